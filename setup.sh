@@ -12,6 +12,7 @@ cmake .. \
   -DCMAKE_INSTALL_PREFIX=../../install \
   -DCMAKE_POSITION_INDEPENDENT_CODE=ON \
   -DBUILD_SHARED_LIBS=ON \
+  -DIGRAPH_ENABLE_TLS=ON \
   -DCMAKE_INSTALL_LIBDIR=lib64
 cmake --build . --target install
 cd ../../../
@@ -0,0 +1,158 @@
+// Optimisation checkpoints: a small header, the iteration records and the
+// membership, written through a temporary file and a rename.
+
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "parallel.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kMagic[8] = {'L', 'C', 'K', 'P', 'T', 0, 0, 0};
+
+// IterationRecord as stored: fixed-width fields, independent of padding.
+struct StoredRecord {
+    int64_t iteration;
+    double quality;
+    int64_t moved;
+    double seconds;
+    double elapsed;
+};
+static_assert(sizeof(StoredRecord) == 40, "checkpoint records are 40 bytes");
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t bits(double d) {
+    uint64_t u;
+    std::memcpy(&u, &d, sizeof u);
+    return u;
+}
+
+} // namespace
+
+uint64_t checkpoint_run_key(const igraph_t* g, bool modularity, double resolution, double beta, uint64_t seed,
+                            unsigned threads) {
+    const int64_t n = igraph_vcount(g), m = igraph_ecount(g);
+    threads = resolve_threads(threads);
+    // Order-dependent edge hash: each edge is mixed with its index, then summed.
+    std::vector<uint64_t> part(threads, 0);
+    parallel_for((size_t) m, threads, [&](size_t b, size_t e, unsigned t) {
+        uint64_t h = 0;
+        for (size_t i = b; i < e; ++i)
+            h += mix64(((uint64_t) IGRAPH_FROM(g, i) << 32) ^ (uint64_t) IGRAPH_TO(g, i) ^ mix64(i));
+        part[t] = h;
+    });
+    uint64_t key = mix64((uint64_t) n) ^ mix64((uint64_t) m + 1);
+    key = mix64(key ^ std::accumulate(part.begin(), part.end(), (uint64_t) 0));
+    key = mix64(key ^ (uint64_t) modularity);
+    key = mix64(key ^ bits(resolution));
+    key = mix64(key ^ bits(beta));
+    key = mix64(key ^ seed);
+    return key;
+}
+
+fs::path checkpoint_path(const fs::path& dir, uint64_t run_key) {
+    char name[40];
+    std::snprintf(name, sizeof name, "leiden.%016llx.ckpt", (unsigned long long) run_key);
+    return dir / name;
+}
+
+void write_checkpoint(const fs::path& path, const LeidenCheckpoint& cp) {
+    const int64_t n = (int64_t) cp.membership.size();
+    CheckpointHeader h;
+    std::memset(&h, 0, sizeof h);
+    std::memcpy(h.magic, kMagic, sizeof kMagic);
+    h.version = kCheckpointVersion;
+    h.label_bytes = n <= (int64_t) UINT32_MAX ? 4 : 8;
+    h.run_key = cp.run_key;
+    h.seed = cp.seed;
+    h.n = n;
+    h.iterations = (int64_t) cp.history.size();
+    h.file_size = sizeof h + cp.history.size() * sizeof(StoredRecord) + (uint64_t) n * h.label_bytes;
+
+    std::vector<StoredRecord> records(cp.history.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        const IterationRecord& r = cp.history[i];
+        records[i] = StoredRecord{r.iteration, r.quality, r.moved, r.seconds, r.elapsed};
+    }
+
+    fs::create_directories(path.parent_path().empty() ? fs::path(".") : path.parent_path());
+    fs::path tmp = path;
+    tmp += ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Cannot open checkpoint for write: " + tmp.string());
+        out.write(reinterpret_cast<const char*>(&h), sizeof h);
+        out.write(reinterpret_cast<const char*>(records.data()), (std::streamsize) (records.size() * sizeof(StoredRecord)));
+        if (h.label_bytes == 4) {
+            std::vector<uint32_t> labels(cp.membership.begin(), cp.membership.end());
+            out.write(reinterpret_cast<const char*>(labels.data()), (std::streamsize) (labels.size() * 4));
+        } else {
+            static_assert(sizeof(igraph_integer_t) == 8, "igraph labels are 64-bit");
+            out.write(reinterpret_cast<const char*>(cp.membership.data()), (std::streamsize) (cp.membership.size() * 8));
+        }
+        out.flush();
+        if (!out) {
+            out.close();
+            fs::remove(tmp);
+            throw std::runtime_error("Failed writing checkpoint: " + tmp.string());
+        }
+    }
+    fs::rename(tmp, path);
+}
+
+bool read_checkpoint(const fs::path& path, uint64_t run_key, LeidenCheckpoint* cp) {
+    std::error_code ec;
+    if (!fs::is_regular_file(path, ec)) return false;
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot open checkpoint: " + path.string());
+    auto bad = [&](const char* why) { return std::runtime_error("Checkpoint " + path.string() + ": " + why); };
+
+    CheckpointHeader h;
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof h)) throw bad("truncated header");
+    if (std::memcmp(h.magic, kMagic, sizeof kMagic) != 0) throw bad("not a checkpoint");
+    if (h.version != kCheckpointVersion) throw bad("format version differs");
+    if (h.run_key != run_key) throw bad("written for another graph or settings");
+    if (h.n < 0 || h.iterations < 0 || (h.label_bytes != 4 && h.label_bytes != 8) ||
+        h.file_size != sizeof h + (uint64_t) h.iterations * sizeof(StoredRecord) + (uint64_t) h.n * h.label_bytes ||
+        h.file_size != (uint64_t) fs::file_size(path))
+        throw bad("truncated or corrupt");
+
+    std::vector<StoredRecord> records((size_t) h.iterations);
+    in.read(reinterpret_cast<char*>(records.data()), (std::streamsize) (records.size() * sizeof(StoredRecord)));
+    cp->membership.resize((size_t) h.n);
+    if (h.label_bytes == 4) {
+        std::vector<uint32_t> labels((size_t) h.n);
+        in.read(reinterpret_cast<char*>(labels.data()), (std::streamsize) (labels.size() * 4));
+        std::copy(labels.begin(), labels.end(), cp->membership.begin());
+    } else {
+        in.read(reinterpret_cast<char*>(cp->membership.data()), (std::streamsize) (cp->membership.size() * 8));
+    }
+    if (!in) throw bad("truncated");
+    for (igraph_integer_t c : cp->membership)
+        if (c < 0 || c >= h.n) throw bad("community label out of range");
+
+    cp->run_key = h.run_key;
+    cp->seed = h.seed;
+    cp->history.resize(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        const StoredRecord& r = records[i];
+        cp->history[i] = IterationRecord{(int) r.iteration, r.quality, r.moved, r.seconds, r.elapsed};
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// Optimisation checkpoints (--checkpoint-dir / --resume): the partition
+// after the last finished iteration, the per-iteration records the stopping
+// rules are decided from, and the seed. igraph's RNG is reseeded from
+// (seed, iteration) before every iteration of a seeded run, so seed and
+// iteration count are its whole state.
+//
+// Layout (little-endian):
+//   CheckpointHeader | records (5 x 8 bytes each) | membership (uint32 or int64)[n]
+// Labels are stored as uint32 whenever n fits.
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <igraph/igraph.h>
+
+#include "convergence.h"
+
+constexpr uint32_t kCheckpointVersion = 1;
+
+struct CheckpointHeader {
+    char magic[8];            // "LCKPT\0\0\0"
+    uint32_t version;
+    uint32_t label_bytes;     // 4 or 8
+    uint64_t run_key;         // graph and optimisation settings, see checkpoint_run_key
+    uint64_t seed;
+    int64_t n;
+    int64_t iterations;       // records that follow
+    uint64_t file_size;
+};
+
+struct LeidenCheckpoint {
+    uint64_t run_key = 0;
+    uint64_t seed = 0;
+    std::vector<IterationRecord> history;       // one per finished iteration
+    std::vector<igraph_integer_t> membership;   // after the last of them
+};
+
+// Identifies what a checkpoint can resume: the graph (vertex and edge
+// counts and a hash of the edge array), objective, resolution, beta and
+// seed. Stopping rules are left out, so a resumed run may change them.
+uint64_t checkpoint_run_key(const igraph_t* g, bool modularity, double resolution, double beta, uint64_t seed,
+                            unsigned threads = 0);
+
+// <dir>/leiden.<run_key as hex>.ckpt: runs with different settings can
+// share a directory.
+std::filesystem::path checkpoint_path(const std::filesystem::path& dir, uint64_t run_key);
+
+// Replaces the checkpoint atomically (temporary file, then rename), so a
+// run killed mid-write leaves the previous one intact. Throws on I/O errors.
+void write_checkpoint(const std::filesystem::path& path, const LeidenCheckpoint& cp);
+
+// Returns false when there is no checkpoint at `path`; throws when it is
+// truncated, from another format version or for another run.
+bool read_checkpoint(const std::filesystem::path& path, uint64_t run_key, LeidenCheckpoint* cp);
+
+#endif // CHECKPOINT_H
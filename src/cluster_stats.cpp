@@ -0,0 +1,168 @@
+// Per-cluster quality metrics: per-thread accumulators over the edge array,
+// merged per cluster, and a parallel TSV formatter.
+
+#include "cluster_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+
+#include "edge_io.h"
+#include "parallel.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t kRowsPerBlock = size_t(1) << 18;  // rows one thread formats per round
+// Four int64s, three %.17g weights, three %.6g ratios, tabs, newline and
+// snprintf's terminator.
+constexpr size_t kMaxLine = 4 * 20 + 3 * 24 + 3 * 13 + 11;
+
+size_t format_row(char* p, size_t cap, int64_t id, const ClusterStats& st, int64_t c) {
+    const ClusterStatsRow& r = st.clusters[(size_t) c];
+    const int n = std::snprintf(p, cap, "%lld\t%lld\t%lld\t%lld\t%.17g\t%.17g\t%.17g\t%.6g\t%.6g\t%.6g\n",
+                                (long long) id, (long long) r.size, (long long) r.internal_edges,
+                                (long long) r.cut_edges, r.internal_weight, r.cut_weight, r.volume(),
+                                st.density(c), st.conductance(c), st.modularity_contribution(c));
+    return n > 0 ? std::min((size_t) n, cap) : 0;
+}
+
+} // namespace
+
+double ClusterStats::density(int64_t c) const {
+    const ClusterStatsRow& r = clusters[(size_t) c];
+    if (r.size < 2) return 0.0;
+    return (double) (r.internal_edges - r.loops) / (0.5 * (double) r.size * (double) (r.size - 1));
+}
+
+double ClusterStats::conductance(int64_t c) const {
+    const ClusterStatsRow& r = clusters[(size_t) c];
+    const double vol = r.volume();
+    const double denom = std::min(vol, 2.0 * total_weight - vol);
+    return denom > 0.0 ? r.cut_weight / denom : 0.0;
+}
+
+double ClusterStats::modularity_contribution(int64_t c) const {
+    if (total_weight <= 0.0) return 0.0;
+    const ClusterStatsRow& r = clusters[(size_t) c];
+    const double two_m = 2.0 * total_weight, vol = r.volume();
+    return (2.0 * r.internal_weight - modularity_resolution * vol * vol / two_m) / two_m;
+}
+
+ClusterStats compute_cluster_stats(const igraph_t* g, const std::vector<double>& edge_weights,
+                                   const igraph_vector_int_t* membership, int64_t nb_clusters,
+                                   double modularity_resolution, double cpm_resolution, unsigned threads) {
+    const int64_t n = igraph_vcount(g), m = igraph_ecount(g);
+    const igraph_integer_t* memb = VECTOR(*membership);
+    const double* ew = edge_weights.empty() ? nullptr : edge_weights.data();
+    const size_t k = (size_t) std::max<int64_t>(nb_clusters, 0);
+
+    // One dense array per thread; with many clusters, fewer threads keep the
+    // arrays within roughly the edge list's own footprint.
+    threads = resolve_threads(threads);
+    const size_t cap = std::max<size_t>((size_t) m, size_t(1) << 20) * sizeof(Edge) / sizeof(ClusterStatsRow);
+    threads = (unsigned) std::max<size_t>(1, std::min<size_t>(threads, cap / std::max<size_t>(k, 1)));
+    std::vector<std::vector<ClusterStatsRow>> acc(threads);
+
+    run_parallel(threads, [&](unsigned t) {
+        std::vector<ClusterStatsRow>& a = acc[t];
+        a.assign(k, ClusterStatsRow());
+        const size_t vb = (size_t) n * t / threads, ve = (size_t) n * (t + 1) / threads;
+        for (size_t v = vb; v < ve; ++v) ++a[(size_t) memb[v]].size;
+        const size_t eb = (size_t) m * t / threads, ee = (size_t) m * (t + 1) / threads;
+        for (size_t e = eb; e < ee; ++e) {
+            const igraph_integer_t u = IGRAPH_FROM(g, e), v = IGRAPH_TO(g, e);
+            const igraph_integer_t cu = memb[u], cv = memb[v];
+            const double w = ew ? ew[e] : 1.0;
+            if (cu == cv) {
+                ClusterStatsRow& r = a[(size_t) cu];
+                ++r.internal_edges;
+                r.internal_weight += w;
+                if (u == v) ++r.loops;
+            } else {
+                ClusterStatsRow& ru = a[(size_t) cu];
+                ClusterStatsRow& rv = a[(size_t) cv];
+                ++ru.cut_edges; ru.cut_weight += w;
+                ++rv.cut_edges; rv.cut_weight += w;
+            }
+        }
+    });
+
+    ClusterStats st;
+    st.modularity_resolution = modularity_resolution;
+    st.cpm_resolution = cpm_resolution;
+    st.clusters = std::move(acc[0]);
+    std::vector<double> internal(threads, 0.0), cut(threads, 0.0), sq_size(threads, 0.0);
+    parallel_for(k, threads, [&](size_t b, size_t e, unsigned t) {
+        for (size_t c = b; c < e; ++c) {
+            ClusterStatsRow& r = st.clusters[c];
+            for (unsigned s = 1; s < acc.size(); ++s) {
+                const ClusterStatsRow& x = acc[s][c];
+                r.size += x.size;
+                r.internal_edges += x.internal_edges;
+                r.loops += x.loops;
+                r.cut_edges += x.cut_edges;
+                r.internal_weight += x.internal_weight;
+                r.cut_weight += x.cut_weight;
+            }
+            internal[t] += r.internal_weight;
+            cut[t] += r.cut_weight;
+            sq_size[t] += (double) r.size * (double) r.size;
+        }
+    });
+    acc.clear();
+
+    double w_in = 0.0, w_cut = 0.0, sizes = 0.0;
+    for (unsigned t = 0; t < threads; ++t) { w_in += internal[t]; w_cut += cut[t]; sizes += sq_size[t]; }
+    st.total_weight = w_in + 0.5 * w_cut;   // every cut edge was counted at both ends
+    if (st.total_weight > 0.0) {
+        for (size_t c = 0; c < k; ++c) st.modularity += st.modularity_contribution((int64_t) c);
+        st.cpm = (2.0 * w_in - cpm_resolution * sizes) / (2.0 * st.total_weight);
+    }
+    return st;
+}
+
+ClusterStats run_cluster_stats(const igraph_t* g, const std::vector<double>& edge_weights,
+                               const igraph_vector_int_t* membership, int64_t nb_clusters, bool modularity,
+                               double resolution, unsigned threads) {
+    return compute_cluster_stats(g, edge_weights, membership, nb_clusters, modularity ? resolution : 1.0,
+                                 resolution, threads);
+}
+
+void write_cluster_stats(const fs::path& out, const ClusterStats& st, unsigned threads) {
+    std::ofstream f(out, std::ios::binary | std::ios::trunc);
+    if (!f) throw std::runtime_error("Cannot open output for write: " + out.string());
+    threads = resolve_threads(threads);
+    const size_t k = st.clusters.size();
+
+    char head[512];
+    const int hn = std::snprintf(head, sizeof head,
+                                 "# clusters\t%zu\n# total_weight\t%.17g\n# modularity\t%.17g\n"
+                                 "# modularity_resolution\t%.17g\n# cpm\t%.17g\n# cpm_resolution\t%.17g\n"
+                                 "cluster\tsize\tinternal_edges\tcut_edges\tinternal_weight\tcut_weight\tvolume\t"
+                                 "density\tconductance\tmodularity\n",
+                                 k, st.total_weight, st.modularity, st.modularity_resolution, st.cpm,
+                                 st.cpm_resolution);
+    f.write(head, hn);
+
+    std::vector<std::vector<char, default_init_allocator<char>>> bufs(threads);
+    std::vector<size_t> lens(threads);
+    const size_t round = kRowsPerBlock * threads;
+    for (size_t r0 = 0; r0 < k; r0 += round) {
+        const size_t rn = std::min(round, k - r0);
+        std::fill(lens.begin(), lens.end(), 0);
+        parallel_for(rn, threads, [&](size_t b, size_t e, unsigned t) {
+            auto& buf = bufs[t];
+            buf.resize((e - b) * kMaxLine);
+            size_t len = 0;
+            for (size_t c = r0 + b; c < r0 + e; ++c)
+                len += format_row(buf.data() + len, buf.size() - len, (int64_t) c + 1, st, (int64_t) c);
+            lens[t] = len;
+        });
+        for (unsigned t = 0; t < threads; ++t) f.write(bufs[t].data(), (std::streamsize) lens[t]);
+    }
+    f.flush();
+    if (!f) throw std::runtime_error("Failed writing " + out.string());
+}
@@ -0,0 +1,61 @@
+#ifndef CLUSTER_STATS_H
+#define CLUSTER_STATS_H
+
+// Per-cluster quality metrics for leiden_igraph --cluster-stats: sizes,
+// internal and cut edges, density, conductance and modularity contribution,
+// plus the partition's global modularity and CPM, from one parallel pass
+// over the edges.
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <igraph/igraph.h>
+
+struct ClusterStatsRow {
+    int64_t size = 0;            // vertices
+    int64_t internal_edges = 0;  // both endpoints inside, self-loops included
+    int64_t loops = 0;           // self-loops among internal_edges
+    int64_t cut_edges = 0;       // exactly one endpoint inside
+    double internal_weight = 0.0;
+    double cut_weight = 0.0;
+
+    double volume() const { return 2.0 * internal_weight + cut_weight; }
+};
+
+struct ClusterStats {
+    std::vector<ClusterStatsRow> clusters;  // indexed by community id
+    double total_weight = 0.0;              // m, or the sum of edge weights
+    double modularity_resolution = 1.0;
+    double cpm_resolution = 1.0;
+    double modularity = 0.0;                // sum of the per-cluster contributions
+    double cpm = 0.0;                       // (sum 2 w_in - gamma sum size^2) / 2m, as leiden_igraph reports it
+
+    // Clusters' derived metrics; 0 where undefined (singletons, empty graph).
+    double density(int64_t c) const;        // internal non-loop edges / (size choose 2)
+    double conductance(int64_t c) const;    // cut weight / min(volume, 2m - volume)
+    double modularity_contribution(int64_t c) const;
+};
+
+// Accumulates every cluster of `membership` (labels 0..nb_clusters-1) in one
+// pass over the edges and one over the vertices; edges count as undirected.
+// Each thread sums into its own dense per-cluster array, merged at the end;
+// the thread count is capped so those arrays stay within about the size of
+// the edge list. edge_weights is one per edge, empty = unit.
+ClusterStats compute_cluster_stats(const igraph_t* g, const std::vector<double>& edge_weights,
+                                   const igraph_vector_int_t* membership, int64_t nb_clusters,
+                                   double modularity_resolution, double cpm_resolution, unsigned threads = 0);
+
+// compute_cluster_stats for a run, as leiden_igraph --cluster-stats and
+// leiden_server report it: CPM at the run's resolution, and modularity at
+// the run's resolution for modularity runs, at 1 otherwise.
+ClusterStats run_cluster_stats(const igraph_t* g, const std::vector<double>& edge_weights,
+                               const igraph_vector_int_t* membership, int64_t nb_clusters, bool modularity,
+                               double resolution, unsigned threads = 0);
+
+// Writes the global values as "# key\tvalue" lines (both scores with their
+// resolutions), then one row per cluster (1-indexed ids, as in
+// leiden_results). Rows are formatted in parallel.
+void write_cluster_stats(const std::filesystem::path& out, const ClusterStats& stats, unsigned threads = 0);
+
+#endif // CLUSTER_STATS_H
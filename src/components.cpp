@@ -0,0 +1,236 @@
+// Connected-component decomposition and per-component clustering.
+
+#include "components.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#include "parallel.h"
+#include "thread_pool.h"
+#include "union_find.h"
+
+int64_t connected_components(const igraph_t* g, std::vector<int64_t>& comp, unsigned threads) {
+    threads = resolve_threads(threads);
+    const int64_t n = igraph_vcount(g);
+    const size_t m = (size_t) igraph_ecount(g);
+    ConcurrentUnionFind uf(n, threads);
+    parallel_for(m, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) uf.unite(IGRAPH_FROM(g, i), IGRAPH_TO(g, i));
+    });
+    comp.resize((size_t) n);
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) comp[i] = uf.find((int64_t) i);
+    });
+    // A root is the smallest vertex of its set, so it is renumbered before
+    // any other member looks it up.
+    int64_t k = 0;
+    for (int64_t v = 0; v < n; ++v) comp[(size_t) v] = comp[(size_t) v] == v ? k++ : comp[(size_t) comp[(size_t) v]];
+    return k;
+}
+
+namespace {
+
+// Vertices and edges grouped by component, each group in original order.
+struct ComponentIndex {
+    std::vector<int64_t> vstart, verts;  // verts[vstart[c] .. vstart[c+1]) are component c's vertices
+    std::vector<int64_t> estart, edges;  // likewise for edge ids
+    std::vector<int64_t> local;          // local[v]: v's index within its component
+};
+
+ComponentIndex index_components(const igraph_t* g, const std::vector<int64_t>& comp, int64_t k) {
+    const int64_t n = igraph_vcount(g), m = igraph_ecount(g);
+    ComponentIndex ix;
+    ix.vstart.assign((size_t) k + 1, 0);
+    ix.estart.assign((size_t) k + 1, 0);
+    for (int64_t v = 0; v < n; ++v) ++ix.vstart[(size_t) comp[(size_t) v] + 1];
+    for (int64_t e = 0; e < m; ++e) ++ix.estart[(size_t) comp[(size_t) IGRAPH_FROM(g, e)] + 1];
+    std::partial_sum(ix.vstart.begin(), ix.vstart.end(), ix.vstart.begin());
+    std::partial_sum(ix.estart.begin(), ix.estart.end(), ix.estart.begin());
+
+    std::vector<int64_t> cursor(ix.vstart.begin(), ix.vstart.end() - 1);
+    ix.verts.resize((size_t) n);
+    ix.local.resize((size_t) n);
+    for (int64_t v = 0; v < n; ++v) {
+        const int64_t c = comp[(size_t) v];
+        ix.local[(size_t) v] = cursor[(size_t) c] - ix.vstart[(size_t) c];
+        ix.verts[(size_t) cursor[(size_t) c]++] = v;
+    }
+    cursor.assign(ix.estart.begin(), ix.estart.end() - 1);
+    ix.edges.resize((size_t) m);
+    for (int64_t e = 0; e < m; ++e) ix.edges[(size_t) cursor[(size_t) comp[(size_t) IGRAPH_FROM(g, e)]]++] = e;
+    return ix;
+}
+
+// Advances the restricted growth string a[0..s) (a[0] = 0, each a[i] at most
+// one above the largest before it) to the next set partition; false after
+// the last one.
+bool next_partition(int* a, int s) {
+    for (int i = s - 1; i > 0; --i) {
+        int mx = 0;
+        for (int j = 0; j < i; ++j) mx = std::max(mx, a[j]);
+        if (a[i] <= mx) {
+            ++a[i];
+            std::fill(a + i + 1, a + s, 0);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Best partition of component c by enumeration, in igraph's quality
+// convention (unnormalised); local labels go to labels[v]. Ties keep the
+// coarser partition. Returns the number of communities.
+int64_t solve_small_component(const igraph_t* g, const LeidenObjective& obj, double gamma,
+                              const ComponentIndex& ix, int64_t c, std::vector<int64_t>& labels) {
+    constexpr int kMax = ComponentOptions::kMaxTrivialSize;
+    const int64_t v0 = ix.vstart[(size_t) c];
+    const int s = (int) (ix.vstart[(size_t) c + 1] - v0);
+    double nw[kMax];
+    for (int i = 0; i < s; ++i) {
+        const int64_t v = ix.verts[(size_t) (v0 + i)];
+        nw[i] = obj.node_weights.empty() ? 1.0 : obj.node_weights[(size_t) v];
+    }
+
+    int a[kMax] = {0}, best[kMax] = {0};
+    double best_score = -std::numeric_limits<double>::infinity();
+    do {
+        double score = 0.0, w[kMax] = {0.0};
+        for (int64_t k = ix.estart[(size_t) c]; k < ix.estart[(size_t) c + 1]; ++k) {
+            const int64_t e = ix.edges[(size_t) k];
+            if (a[ix.local[(size_t) IGRAPH_FROM(g, e)]] == a[ix.local[(size_t) IGRAPH_TO(g, e)]])
+                score += 2.0 * (obj.edge_weights.empty() ? 1.0 : obj.edge_weights[(size_t) e]);
+        }
+        for (int i = 0; i < s; ++i) w[a[i]] += nw[i];
+        for (int i = 0; i < s; ++i) score -= gamma * w[i] * w[i];
+        if (score > best_score + 1e-12) {
+            best_score = score;
+            std::copy(a, a + s, best);
+        }
+    } while (next_partition(a, s));
+
+    int64_t clusters = 0;
+    for (int i = 0; i < s; ++i) {
+        labels[(size_t) ix.verts[(size_t) (v0 + i)]] = best[i];
+        clusters = std::max<int64_t>(clusters, best[i] + 1);
+    }
+    return clusters;
+}
+
+// Clusters component c as its own igraph graph; local labels go to labels[v].
+int64_t cluster_component(const igraph_t* g, const LeidenObjective& obj, double resolution,
+                          const ComponentOptions& opt, const ComponentIndex& ix, int64_t c,
+                          std::vector<int64_t>& labels) {
+    const int64_t v0 = ix.vstart[(size_t) c], n = ix.vstart[(size_t) c + 1] - v0;
+    const int64_t e0 = ix.estart[(size_t) c], m = ix.estart[(size_t) c + 1] - e0;
+
+    LeidenObjective sub;
+    sub.modularity = obj.modularity;
+    sub.two_m = obj.two_m;   // whole-graph 2m, so the modularity resolution is unchanged
+    std::vector<igraph_integer_t> es(2 * (size_t) m);
+    if (!obj.edge_weights.empty()) sub.edge_weights.resize((size_t) m);
+    for (int64_t k = 0; k < m; ++k) {
+        const int64_t e = ix.edges[(size_t) (e0 + k)];
+        es[2 * k] = ix.local[(size_t) IGRAPH_FROM(g, e)];
+        es[2 * k + 1] = ix.local[(size_t) IGRAPH_TO(g, e)];
+        if (!obj.edge_weights.empty()) sub.edge_weights[(size_t) k] = obj.edge_weights[(size_t) e];
+    }
+    if (!obj.node_weights.empty()) {
+        sub.node_weights.resize((size_t) n);
+        for (int64_t i = 0; i < n; ++i) sub.node_weights[(size_t) i] = obj.node_weights[(size_t) ix.verts[(size_t) (v0 + i)]];
+    }
+
+    igraph_t sg;
+    igraph_vector_int_t edges_vec;
+    igraph_vector_int_view(&edges_vec, es.data(), (igraph_integer_t) es.size());
+    if (igraph_create(&sg, &edges_vec, (igraph_integer_t) n, igraph_is_directed(g)))
+        throw std::runtime_error("igraph_create failed");
+    igraph_vector_int_t memb;
+    igraph_vector_int_init(&memb, 0);
+    igraph_integer_t clusters = 0;
+    igraph_real_t q = 0.0;
+    try {
+        run_igraph_leiden_converging(&sg, sub, resolution, opt.beta, /*start=*/false, opt.convergence,
+                                     &memb, &clusters, &q);
+    } catch (...) {
+        igraph_vector_int_destroy(&memb);
+        igraph_destroy(&sg);
+        throw;
+    }
+    for (int64_t i = 0; i < n; ++i) labels[(size_t) ix.verts[(size_t) (v0 + i)]] = VECTOR(memb)[i];
+    igraph_vector_int_destroy(&memb);
+    igraph_destroy(&sg);
+    return clusters;
+}
+
+} // namespace
+
+ComponentStats run_leiden_by_components(const igraph_t* g, const LeidenObjective& obj, double resolution,
+                                        const ComponentOptions& opt, igraph_vector_int_t* membership,
+                                        igraph_integer_t* nb_clusters, igraph_real_t* quality,
+                                        RunReport* report) {
+    if (opt.trivial_size > ComponentOptions::kMaxTrivialSize)
+        throw std::invalid_argument("trivial component size above " +
+                                    std::to_string(ComponentOptions::kMaxTrivialSize));
+    const unsigned threads = resolve_threads(opt.threads);
+    const int64_t n = igraph_vcount(g);
+    ComponentStats st;
+
+    RunReport::Phase components_phase(report, "components");
+    components_phase.add_edges((uint64_t) igraph_ecount(g));
+    std::vector<int64_t> comp;
+    const int64_t k = connected_components(g, comp, threads);
+    const ComponentIndex ix = index_components(g, comp, k);
+    components_phase.finish();
+
+    std::vector<int64_t> big;  // components that go through Leiden
+    st.components = k;
+    for (int64_t c = 0; c < k; ++c) {
+        const int64_t size = ix.vstart[(size_t) c + 1] - ix.vstart[(size_t) c];
+        st.largest = std::max(st.largest, size);
+        if (size <= opt.trivial_size) {
+            ++st.trivial_components;
+            st.trivial_vertices += size;
+        } else {
+            big.push_back(c);
+        }
+    }
+    std::cerr << "Components: " << k << " (" << st.trivial_components << " with <= " << opt.trivial_size
+              << " vertices solved directly, covering " << st.trivial_vertices << " vertices; largest "
+              << st.largest << ")\n";
+
+    RunReport::Phase optimise_phase(report, "optimise");
+    optimise_phase.add_edges((uint64_t) igraph_ecount(g));
+    std::vector<int64_t> labels((size_t) n), clusters((size_t) k, 0);
+    const double gamma = (obj.modularity && obj.two_m > 0) ? resolution / obj.two_m : resolution;
+    parallel_for((size_t) k, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t c = b; c < e; ++c)
+            if (ix.vstart[c + 1] - ix.vstart[c] <= opt.trivial_size)
+                clusters[c] = solve_small_component(g, obj, gamma, ix, (int64_t) c, labels);
+    });
+
+    std::stable_sort(big.begin(), big.end(), [&](int64_t a, int64_t b) {
+        return ix.vstart[(size_t) a + 1] - ix.vstart[(size_t) a] > ix.vstart[(size_t) b + 1] - ix.vstart[(size_t) b];
+    });
+    if (!big.empty()) {
+        ThreadPool pool((unsigned) std::min<size_t>(threads, big.size()));
+        for (int64_t c : big)
+            pool.submit([&, c](unsigned) { clusters[(size_t) c] = cluster_component(g, obj, resolution, opt, ix, c, labels); });
+        pool.wait();
+    }
+
+    // Global ids: components in order, each offset by the communities before it.
+    std::vector<int64_t> offset((size_t) k + 1, 0);
+    for (int64_t c = 0; c < k; ++c) offset[(size_t) c + 1] = offset[(size_t) c] + clusters[(size_t) c];
+    if (igraph_vector_int_resize(membership, n)) throw std::runtime_error("igraph_vector_int_resize failed");
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) VECTOR(*membership)[v] = offset[(size_t) comp[v]] + labels[v];
+    });
+    *nb_clusters = offset[(size_t) k];
+    *quality = partition_quality(g, obj, resolution, membership, threads);
+    optimise_phase.finish();
+    return st;
+}
@@ -0,0 +1,90 @@
+// Convergence tracking for the Leiden iteration loops.
+
+#include "convergence.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+const char* stop_reason_name(StopReason r) {
+    switch (r) {
+        case StopReason::Stable:        return "stable";
+        case StopReason::QualityGain:   return "quality gain";
+        case StopReason::MovedFraction: return "moved fraction";
+        case StopReason::MaxIterations: return "max iterations";
+        case StopReason::TimeBudget:    return "time budget";
+    }
+    return "?";
+}
+
+ConvergenceTracker::ConvergenceTracker(const ConvergenceOptions& opt, int64_t n)
+    : opt_(opt), n_(n), start_(Clock::now()), last_(start_) {}
+
+bool ConvergenceTracker::record(double quality, int64_t moved) {
+    const Clock::time_point now = Clock::now();
+    IterationRecord rec;
+    rec.iteration = (int) history_.size() + 1;
+    rec.quality = quality;
+    rec.moved = moved;
+    rec.seconds = std::chrono::duration<double>(now - last_).count();
+    rec.elapsed = std::chrono::duration<double>(now - start_).count();
+    last_ = now;
+
+    const double prev = history_.empty() ? quality : history_.back().quality;
+    const double gain = quality - prev;
+    const double moved_fraction = n_ > 0 ? (double) moved / (double) n_ : 0.0;
+    history_.push_back(rec);
+
+    bool more = true;
+    if (moved == 0) {
+        reason_ = StopReason::Stable;
+        more = false;
+    } else if (rec.iteration > 1 && gain < 0) {
+        reason_ = StopReason::QualityGain;
+        reverted_ = true;
+        more = false;
+    } else if (rec.iteration > 1 && opt_.min_quality_gain > 0 &&
+               gain < opt_.min_quality_gain * std::max(std::fabs(prev), 1e-12)) {
+        reason_ = StopReason::QualityGain;
+        more = false;
+    } else if (opt_.min_moved_fraction > 0 && moved_fraction < opt_.min_moved_fraction) {
+        reason_ = StopReason::MovedFraction;
+        more = false;
+    } else if (opt_.max_iterations >= 0 && rec.iteration >= std::max(opt_.max_iterations, 1)) {
+        reason_ = StopReason::MaxIterations;
+        more = false;
+    } else if (opt_.time_budget_seconds > 0 && rec.elapsed + rec.seconds > opt_.time_budget_seconds) {
+        reason_ = StopReason::TimeBudget;
+        more = false;
+    }
+
+    if (opt_.log) {
+        std::cerr << "Iteration " << rec.iteration << ": quality " << quality;
+        if (rec.iteration > 1) std::cerr << " (" << (gain >= 0 ? "+" : "") << gain << ")";
+        std::cerr << ", moved " << moved << " (" << 100.0 * moved_fraction << "%), " << rec.seconds << " s, "
+                  << rec.elapsed << " s total";
+        if (!more) std::cerr << "; stopping (" << stop_reason_name(reason_) << (reverted_ ? ", undone" : "") << ")";
+        std::cerr << "\n";
+    }
+    return more;
+}
+
+void ConvergenceTracker::resume(std::vector<IterationRecord> history) {
+    history_ = std::move(history);
+    last_ = Clock::now();
+    const double elapsed = history_.empty() ? 0.0 : history_.back().elapsed;
+    start_ = last_ - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(elapsed));
+}
+
+double ConvergenceTracker::best_quality() const {
+    if (history_.empty()) return 0.0;
+    return history_[history_.size() - (reverted_ ? 2 : 1)].quality;
+}
+
+std::vector<double> ConvergenceTracker::iteration_seconds() const {
+    std::vector<double> s;
+    s.reserve(history_.size());
+    for (const IterationRecord& r : history_) s.push_back(r.seconds);
+    return s;
+}
@@ -0,0 +1,103 @@
+#ifndef CONVERGENCE_H
+#define CONVERGENCE_H
+
+// Stopping rules shared by the Leiden engines: an iteration cap, quality-gain
+// and moved-vertex thresholds, and a wall-clock budget, plus the
+// per-iteration log they are decided from.
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct ConvergenceOptions {
+    int max_iterations = 50;           // < 0: no cap
+    double min_quality_gain = 0.0;     // > 0: stop once an iteration gains less than this, relative to |quality|
+    double min_moved_fraction = 0.0;   // > 0: stop once an iteration moves fewer than this fraction of vertices
+    double time_budget_seconds = 0.0;  // > 0: do not start an iteration expected to end past the budget
+    bool log = false;                  // one stderr line per iteration
+};
+
+enum class StopReason {
+    Stable,         // an iteration moved no vertex
+    QualityGain,    // gain below min_quality_gain, or quality fell (that iteration is undone)
+    MovedFraction,  // fewer than min_moved_fraction of the vertices moved
+    MaxIterations,
+    TimeBudget,
+};
+
+const char* stop_reason_name(StopReason r);
+
+struct IterationRecord {
+    int iteration = 0;         // 1-based
+    double quality = 0.0;
+    int64_t moved = 0;         // vertices that left their previous community
+    double seconds = 0.0;      // this iteration
+    double elapsed = 0.0;      // since the tracker was created
+};
+
+// Drives an engine's iteration loop:
+//
+//     ConvergenceTracker conv(opt, n);
+//     do { ...one iteration...; } while (conv.record(quality, moved));
+//     if (conv.reverted()) ...restore the partition from before the last iteration...
+//
+// The first iteration always runs. An iteration that lowers quality ends the
+// run and is reported as reverted, so the partition returned is the best one
+// seen. The time budget is checked between iterations against the duration
+// of the last one.
+class ConvergenceTracker {
+public:
+    ConvergenceTracker(const ConvergenceOptions& opt, int64_t n);
+
+    // Records the iteration that just finished (timed from the previous call
+    // or from construction). Returns whether another iteration should run.
+    bool record(double quality, int64_t moved);
+
+    // Continues a run restored from a checkpoint: `history` holds the
+    // iterations already done, and elapsed time carries on from the last.
+    void resume(std::vector<IterationRecord> history);
+
+    bool reverted() const { return reverted_; }
+    StopReason reason() const { return reason_; }
+    int iterations() const { return (int) history_.size(); }
+    double best_quality() const;
+    const std::vector<IterationRecord>& history() const { return history_; }
+    std::vector<double> iteration_seconds() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    ConvergenceOptions opt_;
+    int64_t n_;
+    Clock::time_point start_, last_;
+    std::vector<IterationRecord> history_;
+    StopReason reason_ = StopReason::Stable;
+    bool reverted_ = false;
+};
+
+// Vertices whose community changed between two labelings, ignoring how the
+// communities are numbered. Each old community follows its first vertex to
+// that vertex's new community, and each new community belongs to the first
+// old community that followed into it; v moved unless it followed its old
+// community into a new one that community owns. Merging k communities
+// moves all but the first's members. Labels must be in 0..n-1.
+template <class A, class B>
+int64_t count_moved(const A* before, const B* after, size_t n) {
+    std::vector<int64_t> target(n, -1), owner(n, -1);
+    for (size_t v = 0; v < n; ++v) {
+        int64_t& t = target[(size_t) before[v]];
+        if (t < 0) t = (int64_t) after[v];
+    }
+    int64_t moved = 0;
+    for (size_t v = 0; v < n; ++v) {
+        const int64_t b = (int64_t) before[v], a = (int64_t) after[v];
+        if (a != target[(size_t) b]) { ++moved; continue; }
+        int64_t& o = owner[(size_t) a];
+        if (o < 0) o = b;
+        else moved += o != b;
+    }
+    return moved;
+}
+
+#endif // CONVERGENCE_H
@@ -0,0 +1,698 @@
+// Edge-list loaders: memory-mapped parallel TSV/CSV parser and Parquet reader.
+
+#include "edge_io.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <glob.h>
+
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <arrow/util/compression.h>
+#include <parquet/arrow/reader.h>
+
+#include "mapped_file.h"
+#include "parallel.h"
+
+namespace fs = std::filesystem;
+
+bool has_ext(const fs::path& p, std::initializer_list<const char*> exts) {
+    auto e = p.extension().string();
+    std::transform(e.begin(), e.end(), e.begin(), [](unsigned char c){return std::tolower(c);});
+    for (auto x: exts) if (e == x) return true;
+    return false;
+}
+
+bool is_compressed(const fs::path& p) {
+    return has_ext(p, {".gz", ".zst", ".zstd"});
+}
+
+bool is_tsv_path(const fs::path& p) {
+    return has_ext(is_compressed(p) ? p.stem() : p, {".tsv", ".csv", ".txt"});
+}
+
+namespace {
+
+// ---------- TSV line parsing ----------
+
+inline bool is_sep(char c) {
+    return c == ' ' || c == '\t' || c == ',' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Next separator-delimited token in [p, end); advances p past it.
+inline std::string_view next_token(const char*& p, const char* end) {
+    while (p < end && is_sep(*p)) ++p;
+    const char* b = p;
+    while (p < end && !is_sep(*p)) ++p;
+    return std::string_view(b, (size_t)(p - b));
+}
+
+inline bool parse_ll(std::string_view sv, long long& val) {
+    auto begin = sv.data(); auto end = sv.data() + sv.size();
+    auto [ptr, ec] = std::from_chars(begin, end, val);
+    return ec == std::errc() && ptr == end;
+}
+
+inline bool parse_double(std::string_view sv, double& val) {
+    auto begin = sv.data(); auto end = sv.data() + sv.size();
+    auto [ptr, ec] = std::from_chars(begin, end, val);
+    return ec == std::errc() && ptr == end;
+}
+
+size_t count_lines(const char* b, const char* e) {
+    size_t n = 0;
+    for (const char* p = b; p < e; ) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(e - p)));
+        if (!nl) { ++n; break; }
+        ++n; p = nl + 1;
+    }
+    return n;
+}
+
+// Parses every line in [b, e) into out (and the third column into wout, when
+// given); returns the number of edges written. `header_allowed` lets the
+// first line with two tokens be skipped as a header.
+size_t parse_chunk(const char* b, const char* e, Edge* out, double* wout, bool header_allowed) {
+    size_t n = 0;
+    bool first = header_allowed;
+    for (const char* p = b; p < e; ) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', (size_t)(e - p)));
+        const char* le = nl ? nl : e;
+        const char* q = p;
+        p = nl ? nl + 1 : e;
+
+        auto t0 = next_token(q, le);
+        auto t1 = next_token(q, le);
+        if (t1.empty()) continue; // fewer than two tokens
+        long long u, v;
+        double w = 1.0;
+        bool ok = parse_ll(t0, u) && parse_ll(t1, v);
+        if (wout) {
+            auto t2 = next_token(q, le);
+            if (!t2.empty()) ok = ok && parse_double(t2, w);
+        }
+        if (first) { first = false; if (!ok) continue; } // header line
+        if (!ok) continue;
+        if (wout) wout[n] = w;
+        out[n++] = Edge{u, v};
+    }
+    return n;
+}
+
+// Slot range i = [slots[i], slots[i] + filled[i]) holds valid entries; packs
+// them to the front of items in order, in place (ranges only ever move
+// left). Returns the number of entries kept.
+template <class T>
+size_t compact_slots(T* items, const std::vector<size_t>& slots, const std::vector<size_t>& filled) {
+    size_t write = 0;
+    for (size_t i = 0; i < filled.size(); ++i) {
+        if (write != slots[i] && filled[i])
+            std::memmove(items + write, items + slots[i], filled[i] * sizeof(T));
+        write += filled[i];
+    }
+    return write;
+}
+
+// Newline-aligned chunks of a TSV file and their line counts: chunk t is
+// [bounds[t], bounds[t+1]) and parses into slots [slots[t], slots[t+1]) of
+// the output, so slots.back() bounds the number of edges.
+struct TsvPlan {
+    std::vector<size_t> bounds, slots;
+    unsigned chunks() const { return (unsigned) bounds.size() - 1; }
+};
+
+// Pass 1: chunk boundaries and per-chunk line counts.
+TsvPlan plan_tsv(const char* data, size_t size, unsigned threads) {
+    // Don't bother splitting small files finer than ~1 MB per thread.
+    threads = (unsigned) std::max<size_t>(1, std::min<size_t>(threads, size >> 20));
+    TsvPlan plan;
+    plan.bounds.assign(threads + 1, size);
+    plan.bounds[0] = 0;
+    for (unsigned t = 1; t < threads; ++t) {
+        size_t pos = std::max(size * t / threads, plan.bounds[t - 1]);
+        const void* nl = pos < size ? std::memchr(data + pos, '\n', size - pos) : nullptr;
+        plan.bounds[t] = nl ? (size_t)(static_cast<const char*>(nl) - data) + 1 : size;
+    }
+    plan.slots.assign(threads + 1, 0);
+    run_parallel(threads, [&](unsigned t) {
+        plan.slots[t + 1] = count_lines(data + plan.bounds[t], data + plan.bounds[t + 1]);
+    });
+    for (unsigned t = 0; t < threads; ++t) plan.slots[t + 1] += plan.slots[t];
+    return plan;
+}
+
+// Pass 2: each thread parses its chunk straight into its slot range of out
+// (and wout), then the gaps left by skipped lines are closed. Returns the
+// number of edges written.
+size_t parse_tsv(const char* data, const TsvPlan& plan, Edge* out, double* wout) {
+    const unsigned threads = plan.chunks();
+    std::vector<size_t> parsed(threads, 0);
+    run_parallel(threads, [&](unsigned t) {
+        parsed[t] = parse_chunk(data + plan.bounds[t], data + plan.bounds[t + 1], out + plan.slots[t],
+                                wout ? wout + plan.slots[t] : nullptr, t == 0);
+    });
+    if (wout) compact_slots(wout, plan.slots, parsed);
+    return compact_slots(out, plan.slots, parsed);
+}
+
+// ---------- Compressed TSV reader ----------
+
+constexpr size_t kDecompressBlock = size_t(32) << 20;  // decompressed bytes per parse block
+
+void check(const arrow::Status& st) {
+    if (!st.ok()) throw std::runtime_error(st.ToString());
+}
+
+// A gzip or zstd file as a stream of decompressed bytes (Arrow's codecs;
+// concatenated gzip members, as written by pigz or bgzip, are read through).
+class DecompressedFile {
+public:
+    explicit DecompressedFile(const fs::path& path) {
+        const auto type = has_ext(path, {".gz"}) ? arrow::Compression::GZIP : arrow::Compression::ZSTD;
+        auto codec = arrow::util::Codec::Create(type);
+        if (!codec.ok()) throw std::runtime_error("Cannot decompress " + path.string() + ": " + codec.status().ToString());
+        codec_ = std::move(*codec);
+        auto file = arrow::io::ReadableFile::Open(path.string());
+        if (!file.ok()) throw std::runtime_error("Cannot open: " + path.string());
+        auto stream = arrow::io::CompressedInputStream::Make(codec_.get(), *file);
+        if (!stream.ok()) throw std::runtime_error(stream.status().ToString());
+        stream_ = *stream;
+    }
+    ~DecompressedFile() { (void) stream_->Close(); }
+    DecompressedFile(const DecompressedFile&) = delete;
+    DecompressedFile& operator=(const DecompressedFile&) = delete;
+
+    // Up to `cap` bytes into dst; 0 at end of file.
+    size_t read(char* dst, size_t cap) {
+        auto n = stream_->Read((int64_t) cap, dst);
+        if (!n.ok()) throw std::runtime_error(n.status().ToString());
+        return (size_t) *n;
+    }
+
+private:
+    std::unique_ptr<arrow::util::Codec> codec_;  // must outlive stream_
+    std::shared_ptr<arrow::io::InputStream> stream_;
+};
+
+// One thread decompresses into a ring of blocks, each cut after its last
+// newline (the partial line is carried into the next block); the other
+// threads parse finished blocks into per-block edge lists as soon as they
+// are published, so parsing overlaps decompression and nothing touches disk.
+EdgeList read_compressed_tsv(const fs::path& path, unsigned threads, WeightList* weights) {
+    auto t_start = std::chrono::steady_clock::now();
+    const unsigned parsers = std::max(1u, resolve_threads(threads) - 1);
+    DecompressedFile in(path);
+
+    using Buffer = std::vector<char, default_init_allocator<char>>;
+    struct Block { Buffer data; size_t len = 0; size_t seq = 0; };
+    std::vector<Block> ring(parsers + 2);
+    std::vector<size_t> free_blocks(ring.size());
+    std::iota(free_blocks.begin(), free_blocks.end(), size_t(0));
+    std::deque<size_t> full;
+    std::deque<EdgeList> parts;      // one per block, in file order; deque keeps references stable
+    std::deque<WeightList> wparts;
+    bool done = false, failed = false;
+    std::mutex mu;
+    std::condition_variable cv_free, cv_full;
+    uint64_t raw_bytes = 0;
+
+    auto fail = [&] {
+        std::lock_guard<std::mutex> lk(mu);
+        failed = true;
+        cv_free.notify_all();
+        cv_full.notify_all();
+    };
+    auto decompress = [&] {
+        Buffer carry;
+        for (size_t seq = 0;; ++seq) {
+            size_t b;
+            {
+                std::unique_lock<std::mutex> lk(mu);
+                cv_free.wait(lk, [&] { return failed || !free_blocks.empty(); });
+                if (failed) return;
+                b = free_blocks.back();
+                free_blocks.pop_back();
+            }
+            Block& blk = ring[b];
+            blk.data.resize(std::max(blk.data.size(), carry.size() + kDecompressBlock));
+            if (!carry.empty()) std::memcpy(blk.data.data(), carry.data(), carry.size());
+            size_t len = carry.size(), cut = 0;
+            bool eof = false;
+            for (;;) {
+                while (len < blk.data.size()) {
+                    const size_t n = in.read(blk.data.data() + len, blk.data.size() - len);
+                    if (n == 0) { eof = true; break; }
+                    len += n;
+                }
+                if (eof) { cut = len; break; }
+                const void* nl = memrchr(blk.data.data(), '\n', len);
+                if (nl) { cut = (size_t) (static_cast<const char*>(nl) - blk.data.data()) + 1; break; }
+                blk.data.resize(2 * blk.data.size());  // a line longer than the block
+            }
+            carry.assign(blk.data.data() + cut, blk.data.data() + len);
+            raw_bytes += cut;
+            blk.len = cut;
+            blk.seq = seq;
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                parts.emplace_back();
+                if (weights) wparts.emplace_back();
+                full.push_back(b);
+                if (eof) done = true;
+            }
+            if (eof) { cv_full.notify_all(); return; }
+            cv_full.notify_one();
+        }
+    };
+    auto parse = [&] {
+        for (;;) {
+            size_t b;
+            EdgeList* out;
+            WeightList* wout = nullptr;
+            {
+                std::unique_lock<std::mutex> lk(mu);
+                cv_full.wait(lk, [&] { return failed || done || !full.empty(); });
+                if (failed || full.empty()) return;
+                b = full.front();
+                full.pop_front();
+                out = &parts[ring[b].seq];
+                if (weights) wout = &wparts[ring[b].seq];
+            }
+            const Block& blk = ring[b];
+            const char* data = blk.data.data();
+            const size_t lines = count_lines(data, data + blk.len);
+            out->resize(lines);
+            if (wout) wout->resize(lines);
+            const size_t n = parse_chunk(data, data + blk.len, out->data(), wout ? wout->data() : nullptr, blk.seq == 0);
+            out->resize(n);
+            if (wout) wout->resize(n);
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                free_blocks.push_back(b);
+            }
+            cv_free.notify_one();
+        }
+    };
+    run_parallel(parsers + 1, [&](unsigned t) {
+        try {
+            if (t == 0) decompress(); else parse();
+        } catch (...) {
+            fail();
+            throw;
+        }
+    });
+
+    // Concatenate the per-block lists in order, releasing each once copied.
+    std::vector<size_t> offset(parts.size() + 1, 0);
+    for (size_t i = 0; i < parts.size(); ++i) offset[i + 1] = offset[i] + parts[i].size();
+    EdgeList edges;
+    edges.resize(offset.back());
+    if (weights) weights->resize(offset.back());
+    parallel_for(parts.size(), resolve_threads(threads), [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) {
+            std::memcpy(edges.data() + offset[i], parts[i].data(), parts[i].size() * sizeof(Edge));
+            EdgeList().swap(parts[i]);
+            if (weights) {
+                std::memcpy(weights->data() + offset[i], wparts[i].data(), wparts[i].size() * sizeof(double));
+                WeightList().swap(wparts[i]);
+            }
+        }
+    });
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    if (secs <= 0) secs = 1e-9;
+    std::cerr << "Decompressed and parsed " << (raw_bytes / 1e6) << " MB (" << (fs::file_size(path) / 1e6)
+              << " MB compressed) with 1 + " << parsers << " threads in " << secs << " s ("
+              << (raw_bytes / 1e6) / secs << " MB/s, " << (double) edges.size() / secs << " edges/s)\n";
+    return edges;
+}
+
+} // namespace
+
+// ---------- TSV reader ----------
+
+EdgeList read_tsv_edges(const fs::path& path, unsigned threads, WeightList* weights) {
+    if (is_compressed(path)) return read_compressed_tsv(path, threads, weights);
+    auto t_start = std::chrono::steady_clock::now();
+    MappedFile file(path);
+    const char* data = file.data();
+    const size_t size = file.size();
+    EdgeList edges;
+    if (size == 0) return edges;
+
+    const TsvPlan plan = plan_tsv(data, size, resolve_threads(threads));
+    threads = plan.chunks();
+    edges.resize(plan.slots.back());
+    if (weights) weights->resize(plan.slots.back());
+    const size_t write = parse_tsv(data, plan, edges.data(), weights ? weights->data() : nullptr);
+    edges.resize(write);
+    if (weights) weights->resize(write);
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    if (secs <= 0) secs = 1e-9;
+    std::cerr << "Parsed " << (size / 1e6) << " MB with " << threads << " threads in " << secs << " s ("
+              << (size / 1e6) / secs << " MB/s, " << (double) write / secs << " edges/s)\n";
+    return edges;
+}
+
+// ---------- Parquet reader ----------
+
+namespace {
+
+int find_column_index(const std::shared_ptr<arrow::Schema>& schema, const std::vector<std::string>& names) {
+    for (const auto& name : names) {
+        int idx = schema->GetFieldIndex(name);
+        if (idx != -1) return idx;
+    }
+    return -1;
+}
+
+template <class ArrayT>
+void widen_column(const arrow::Array& col, Edge* out, long long Edge::* field) {
+    const auto* vals = static_cast<const ArrayT&>(col).raw_values();
+    const int64_t n = col.length();
+    for (int64_t i = 0; i < n; ++i) {
+        if constexpr (std::is_same_v<ArrayT, arrow::UInt64Array>) {
+            if (vals[i] > (uint64_t) std::numeric_limits<long long>::max() && col.IsValid(i))
+                throw std::runtime_error("Parquet node id does not fit in int64: " + std::to_string(vals[i]));
+        }
+        out[i].*field = static_cast<long long>(vals[i]);
+    }
+}
+
+// Writes one integer column of any width into out[0..len).u or .v.
+void copy_column(const arrow::Array& col, Edge* out, long long Edge::* field) {
+    switch (col.type_id()) {
+        case arrow::Type::INT8:   widen_column<arrow::Int8Array>(col, out, field); break;
+        case arrow::Type::INT16:  widen_column<arrow::Int16Array>(col, out, field); break;
+        case arrow::Type::INT32:  widen_column<arrow::Int32Array>(col, out, field); break;
+        case arrow::Type::INT64:  widen_column<arrow::Int64Array>(col, out, field); break;
+        case arrow::Type::UINT8:  widen_column<arrow::UInt8Array>(col, out, field); break;
+        case arrow::Type::UINT16: widen_column<arrow::UInt16Array>(col, out, field); break;
+        case arrow::Type::UINT32: widen_column<arrow::UInt32Array>(col, out, field); break;
+        case arrow::Type::UINT64: widen_column<arrow::UInt64Array>(col, out, field); break;
+        default:
+            throw std::runtime_error("Parquet edge column must be an integer type, got " + col.type()->ToString());
+    }
+}
+
+template <class ArrayT>
+void widen_weights(const arrow::Array& col, double* out) {
+    const auto& arr = static_cast<const ArrayT&>(col);
+    const auto* vals = arr.raw_values();
+    const int64_t n = col.length();
+    for (int64_t i = 0; i < n; ++i) out[i] = col.IsValid(i) ? static_cast<double>(vals[i]) : 1.0;
+}
+
+// Writes a numeric weight column into out[0..len); nulls become 1.
+void copy_weights(const arrow::Array& col, double* out) {
+    switch (col.type_id()) {
+        case arrow::Type::DOUBLE: widen_weights<arrow::DoubleArray>(col, out); break;
+        case arrow::Type::FLOAT:  widen_weights<arrow::FloatArray>(col, out); break;
+        case arrow::Type::INT8:   widen_weights<arrow::Int8Array>(col, out); break;
+        case arrow::Type::INT16:  widen_weights<arrow::Int16Array>(col, out); break;
+        case arrow::Type::INT32:  widen_weights<arrow::Int32Array>(col, out); break;
+        case arrow::Type::INT64:  widen_weights<arrow::Int64Array>(col, out); break;
+        case arrow::Type::UINT8:  widen_weights<arrow::UInt8Array>(col, out); break;
+        case arrow::Type::UINT16: widen_weights<arrow::UInt16Array>(col, out); break;
+        case arrow::Type::UINT32: widen_weights<arrow::UInt32Array>(col, out); break;
+        case arrow::Type::UINT64: widen_weights<arrow::UInt64Array>(col, out); break;
+        default:
+            throw std::runtime_error("Parquet weight column must be numeric, got " + col.type()->ToString());
+    }
+}
+
+// Copies a projected (u, v[, weight]) batch into out (and wout); rows with a
+// null endpoint are dropped. Returns the number of edges written.
+size_t copy_batch(const arrow::RecordBatch& batch, Edge* out, double* wout) {
+    const auto& cu = *batch.column(0);
+    const auto& cv = *batch.column(1);
+    const int64_t n = batch.num_rows();
+    copy_column(cu, out, &Edge::u);
+    copy_column(cv, out, &Edge::v);
+    if (wout) copy_weights(*batch.column(2), wout);
+    if (cu.null_count() == 0 && cv.null_count() == 0) return (size_t) n;
+    size_t w = 0;
+    for (int64_t i = 0; i < n; ++i) {
+        if (!cu.IsValid(i) || !cv.IsValid(i)) continue;
+        if (wout) wout[w] = wout[i];
+        out[w++] = out[i];
+    }
+    return w;
+}
+
+std::unique_ptr<parquet::arrow::FileReader> open_parquet(const fs::path& path,
+                                                         std::shared_ptr<parquet::FileMetaData> metadata) {
+    parquet::ArrowReaderProperties props;
+    props.set_pre_buffer(true);    // coalesce the column-chunk reads of a row group
+    props.set_use_threads(false);  // we parallelise across row groups instead
+    parquet::arrow::FileReaderBuilder builder;
+    check(builder.OpenFile(path.string(), /*memory_map=*/false, parquet::default_reader_properties(), std::move(metadata)));
+    builder.properties(props);
+    std::unique_ptr<parquet::arrow::FileReader> reader;
+    check(builder.Build(&reader));
+    return reader;
+}
+
+// Projected columns and row-group slot ranges of a Parquet file: row group
+// rg decodes into slots [slots[rg], slots[rg+1]) of the output.
+struct ParquetPlan {
+    std::shared_ptr<parquet::FileMetaData> metadata;
+    std::vector<int> columns;  // u, v[, weight]
+    std::vector<size_t> slots;
+    int row_groups() const { return (int) slots.size() - 1; }
+};
+
+ParquetPlan plan_parquet(const fs::path& path, bool weighted) {
+    auto reader = open_parquet(path, nullptr);
+    std::shared_ptr<arrow::Schema> schema;
+    check(reader->GetSchema(&schema));
+
+    int u_idx = find_column_index(schema, {"src","source","u","from"});
+    int v_idx = find_column_index(schema, {"dst","target","v","to"});
+    if (u_idx == -1 || v_idx == -1) {
+        if (schema->num_fields() < 2)
+            throw std::runtime_error("Parquet must have at least two columns for edges");
+        u_idx = 0; v_idx = 1;
+    }
+    ParquetPlan plan;
+    plan.columns = {u_idx, v_idx};
+    if (weighted) {
+        int w_idx = find_column_index(schema, {"weight","weights","w"});
+        if (w_idx == -1) {
+            if (schema->num_fields() < 3)
+                throw std::runtime_error("Parquet has no weight column (expected one named weight, or a third column)");
+            w_idx = 2;
+        }
+        plan.columns.push_back(w_idx);
+    }
+
+    // Row-group sizes from the footer give every row group its slot range up front.
+    plan.metadata = reader->parquet_reader()->metadata();
+    const int num_rg = plan.metadata->num_row_groups();
+    plan.slots.assign(num_rg + 1, 0);
+    for (int rg = 0; rg < num_rg; ++rg)
+        plan.slots[rg + 1] = plan.slots[rg] + (size_t) plan.metadata->RowGroup(rg)->num_rows();
+    return plan;
+}
+
+// Each of `threads` threads has its own FileReader (sharing the parsed
+// footer) and claims row groups from a shared counter; batches are decoded
+// straight into their slot range of out (and wout), then rows dropped for
+// null endpoints are compacted away. Returns the number of edges written.
+size_t read_parquet(const fs::path& path, const ParquetPlan& plan, unsigned threads, Edge* out, double* wout) {
+    const int num_rg = plan.row_groups();
+    std::vector<size_t> filled(num_rg, 0);
+    std::atomic<int> next{0};
+    run_parallel(threads, [&](unsigned) {
+        auto rd = open_parquet(path, plan.metadata);
+        for (int rg; (rg = next.fetch_add(1)) < num_rg; ) {
+            auto batches = rd->GetRecordBatchReader({rg}, plan.columns);
+            if (!batches.ok()) throw std::runtime_error(batches.status().ToString());
+            Edge* rg_out = out + plan.slots[rg];
+            double* rg_wout = wout ? wout + plan.slots[rg] : nullptr;
+            size_t n = 0;
+            std::shared_ptr<arrow::RecordBatch> batch;
+            for (;;) {
+                check((*batches)->ReadNext(&batch));
+                if (!batch) break;
+                n += copy_batch(*batch, rg_out + n, rg_wout ? rg_wout + n : nullptr);
+            }
+            filled[rg] = n;
+        }
+    });
+    if (wout) compact_slots(wout, plan.slots, filled);
+    return compact_slots(out, plan.slots, filled);
+}
+
+unsigned parquet_threads(const ParquetPlan& plan, unsigned threads) {
+    return (unsigned) std::max(1, std::min<int>((int) resolve_threads(threads), plan.row_groups()));
+}
+
+} // namespace
+
+EdgeList read_parquet_edges(const fs::path& path, unsigned threads, WeightList* weights) {
+    auto t_start = std::chrono::steady_clock::now();
+    const ParquetPlan plan = plan_parquet(path, weights != nullptr);
+    const int num_rg = plan.row_groups();
+    EdgeList edges;
+    edges.resize(plan.slots.back());
+    if (weights) weights->resize(plan.slots.back());
+    threads = parquet_threads(plan, threads);
+    const size_t write = read_parquet(path, plan, threads, edges.data(), weights ? weights->data() : nullptr);
+    edges.resize(write);
+    if (weights) weights->resize(write);
+    if (edges.empty()) throw std::runtime_error("No valid edges found in Parquet file");
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    if (secs <= 0) secs = 1e-9;
+    std::cerr << "Read " << num_rg << " row groups with " << threads << " threads in " << secs << " s ("
+              << (double) edges.size() / secs << " edges/s)\n";
+    return edges;
+}
+
+// ---------- Files and shards ----------
+
+EdgeList read_edge_file(const fs::path& path, unsigned threads, WeightList* weights) {
+    if (is_tsv_path(path)) {
+        std::cerr << "Reading TSV/CSV edges from: " << path << "\n";
+        return read_tsv_edges(path, threads, weights);
+    }
+    if (has_ext(path, {".parquet"})) {
+        std::cerr << "Reading Parquet edges from: " << path << "\n";
+        return read_parquet_edges(path, threads, weights);
+    }
+    throw std::runtime_error("Unsupported input extension: " + path.extension().string());
+}
+
+std::vector<fs::path> expand_input_shards(const fs::path& input) {
+    std::vector<fs::path> shards;
+    std::error_code ec;
+    if (fs::is_directory(input, ec)) {
+        for (const auto& entry : fs::directory_iterator(input))
+            if (entry.is_regular_file(ec) && (is_tsv_path(entry.path()) || has_ext(entry.path(), {".parquet"})))
+                shards.push_back(entry.path());
+    } else if (fs::exists(input, ec)) {
+        shards.push_back(input);
+    } else {
+        glob_t matches;
+        if (::glob(input.c_str(), 0, nullptr, &matches) == 0)
+            for (size_t i = 0; i < matches.gl_pathc; ++i)
+                if (fs::is_regular_file(matches.gl_pathv[i], ec)) shards.emplace_back(matches.gl_pathv[i]);
+        ::globfree(&matches);
+    }
+    if (shards.empty()) throw std::runtime_error("No edge files found at " + input.string());
+    std::sort(shards.begin(), shards.end());
+    return shards;
+}
+
+EdgeList read_edge_shards(const std::vector<fs::path>& shards, unsigned threads, unsigned max_io_threads,
+                          WeightList* weights) {
+    if (shards.size() == 1) return read_edge_file(shards[0], threads, weights);
+    auto t_start = std::chrono::steady_clock::now();
+    const size_t k = shards.size();
+    threads = resolve_threads(threads);
+    const unsigned readers = (unsigned) std::max<size_t>(
+        1, std::min<size_t>(k, max_io_threads ? std::min(max_io_threads, threads) : threads));
+    const unsigned per_reader = std::max(1u, threads / readers);
+
+    struct Shard {
+        bool parquet = false;
+        TsvPlan tsv;
+        ParquetPlan pq;
+        EdgeList decoded;      // compressed shards, which have no cheap line count
+        WeightList wdecoded;
+        size_t rows = 0;       // upper bound on its edges
+    };
+    std::vector<Shard> plan(k);
+    for (size_t i = 0; i < k; ++i) {
+        plan[i].parquet = has_ext(shards[i], {".parquet"});
+        if (!plan[i].parquet && !is_tsv_path(shards[i]))
+            throw std::runtime_error("Unsupported input extension: " + shards[i].string());
+    }
+
+    // `readers` threads claim shards from a shared counter, so at most that
+    // many files are open at once.
+    auto for_each_shard = [&](auto&& fn) {
+        std::atomic<size_t> next{0};
+        run_parallel(readers, [&](unsigned) {
+            for (size_t i; (i = next.fetch_add(1)) < k; ) fn(i);
+        });
+    };
+
+    // Pass 1: line counts / row-group footers bound every shard's edges, so
+    // each gets an exclusive slot range in one shared buffer. Compressed
+    // shards are decoded whole here and copied into place in pass 2.
+    std::vector<uint64_t> bytes(k, 0);
+    for_each_shard([&](size_t i) {
+        Shard& s = plan[i];
+        if (is_compressed(shards[i])) {
+            s.decoded = read_compressed_tsv(shards[i], per_reader, weights ? &s.wdecoded : nullptr);
+            s.rows = s.decoded.size();
+            bytes[i] = (uint64_t) fs::file_size(shards[i]);
+        } else if (s.parquet) {
+            s.pq = plan_parquet(shards[i], weights != nullptr);
+            s.rows = s.pq.slots.back();
+            bytes[i] = (uint64_t) fs::file_size(shards[i]);
+        } else {
+            MappedFile file(shards[i]);
+            bytes[i] = file.size();
+            if (file.size() == 0) return;
+            s.tsv = plan_tsv(file.data(), file.size(), per_reader);
+            s.rows = s.tsv.slots.back();
+        }
+    });
+    std::vector<size_t> slots(k + 1, 0);
+    for (size_t i = 0; i < k; ++i) slots[i + 1] = slots[i] + plan[i].rows;
+    EdgeList edges;
+    edges.resize(slots[k]);
+    if (weights) weights->resize(slots[k]);
+
+    // Pass 2: every shard parses straight into its slot range (a TSV shard is
+    // mapped again; its pages are still cached from pass 1).
+    std::vector<size_t> filled(k, 0);
+    for_each_shard([&](size_t i) {
+        Shard& s = plan[i];
+        Edge* out = edges.data() + slots[i];
+        double* wout = weights ? weights->data() + slots[i] : nullptr;
+        if (is_compressed(shards[i])) {
+            std::memcpy(out, s.decoded.data(), s.rows * sizeof(Edge));
+            if (wout) std::memcpy(wout, s.wdecoded.data(), s.rows * sizeof(double));
+            filled[i] = s.rows;
+            EdgeList().swap(s.decoded);
+            WeightList().swap(s.wdecoded);
+        } else if (s.parquet) {
+            filled[i] = read_parquet(shards[i], s.pq, parquet_threads(s.pq, per_reader), out, wout);
+        } else if (s.rows) {
+            MappedFile file(shards[i]);
+            if (file.size() != bytes[i]) throw std::runtime_error("Shard changed while reading: " + shards[i].string());
+            filled[i] = parse_tsv(file.data(), s.tsv, out, wout);
+        }
+    });
+    edges.resize(compact_slots(edges.data(), slots, filled));
+    if (weights) weights->resize(compact_slots(weights->data(), slots, filled));
+    if (edges.empty()) throw std::runtime_error("No valid edges found in " + std::to_string(k) + " shards");
+
+    uint64_t total_bytes = 0;
+    for (uint64_t b : bytes) total_bytes += b;
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    if (secs <= 0) secs = 1e-9;
+    std::cerr << "Read " << k << " shards (" << (total_bytes / 1e6) << " MB) with " << readers << " readers x "
+              << per_reader << " threads in " << secs << " s (" << (total_bytes / 1e6) / secs << " MB/s, "
+              << (double) edges.size() / secs << " edges/s)\n";
+    return edges;
+}
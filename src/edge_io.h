@@ -0,0 +1,89 @@
+#ifndef EDGE_IO_H
+#define EDGE_IO_H
+
+// Edge-list loaders for leiden_igraph: TSV/CSV (memory-mapped, parallel) and
+// Parquet, from one file or a set of shards.
+
+#include <filesystem>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct Edge { long long u; long long v; };
+
+// Allocator whose resize() leaves trivial elements uninitialised, so the
+// multi-GB edge buffers are not zero-filled right before a parser overwrites them.
+template <typename T, typename A = std::allocator<T>>
+class default_init_allocator : public A {
+    using a_t = std::allocator_traits<A>;
+public:
+    template <typename U> struct rebind {
+        using other = default_init_allocator<U, typename a_t::template rebind_alloc<U>>;
+    };
+    using A::A;
+
+    template <typename U>
+    void construct(U* ptr) noexcept(std::is_nothrow_default_constructible<U>::value) {
+        ::new (static_cast<void*>(ptr)) U;
+    }
+    template <typename U, typename... Args>
+    void construct(U* ptr, Args&&... args) {
+        a_t::construct(static_cast<A&>(*this), ptr, std::forward<Args>(args)...);
+    }
+};
+
+using EdgeList = std::vector<Edge, default_init_allocator<Edge>>;
+using WeightList = std::vector<double, default_init_allocator<double>>;
+
+bool has_ext(const std::filesystem::path& p, std::initializer_list<const char*> exts);
+
+// .gz, .zst or .zstd.
+bool is_compressed(const std::filesystem::path& p);
+
+// A .tsv, .csv or .txt file, optionally compressed (edges.tsv.gz, edges.csv.zst).
+bool is_tsv_path(const std::filesystem::path& p);
+
+// Two integer columns per line, separated by whitespace and/or commas; extra
+// columns are ignored. A first line that does not parse is treated as a header.
+// With `weights`, a third numeric column is read as the edge weight (1 when
+// absent). threads == 0 uses every hardware thread.
+// A .gz or .zst file is decompressed in memory while it is parsed: one thread
+// decompresses 32 MB blocks (cut at line ends) and the others parse each
+// block as soon as it is ready, so the read runs at about the decompressor's
+// speed.
+EdgeList read_tsv_edges(const std::filesystem::path& path, unsigned threads = 0,
+                        WeightList* weights = nullptr);
+
+// Columns named {src,source,u,from} / {dst,target,v,to}, else the first two;
+// any integer width. Only those columns are decoded, row groups are read
+// in parallel, and rows with a null endpoint are dropped. With `weights`, a
+// numeric column named {weight,weights,w} (else the third column) is read as
+// the edge weight; null weights count as 1.
+EdgeList read_parquet_edges(const std::filesystem::path& path, unsigned threads = 0,
+                            WeightList* weights = nullptr);
+
+// TSV/CSV (.tsv, .csv, .txt, plain or compressed) or Parquet (.parquet), chosen
+// by extension.
+EdgeList read_edge_file(const std::filesystem::path& path, unsigned threads = 0,
+                        WeightList* weights = nullptr);
+
+// The edge files an input names, sorted by path: the file itself, every
+// .tsv/.csv/.txt/.parquet file directly inside a directory, or the regular
+// files matching a shell glob such as "edges/part-*.parquet". Compressed
+// TSV shards are accepted too. Throws when
+// nothing matches.
+std::vector<std::filesystem::path> expand_input_shards(const std::filesystem::path& input);
+
+// Reads every shard into one edge list, in shard order, with at most
+// `max_io_threads` shards in flight (0 = up to `threads`); the `threads`
+// parser threads are split between them. Line counts and Parquet footers are
+// read first, so the shared buffer is sized once and each shard parses
+// straight into its own range. Node ids stay as written, so an id means the
+// same vertex in every shard once the combined list is remapped. Mixed TSV
+// and Parquet shards are allowed.
+EdgeList read_edge_shards(const std::vector<std::filesystem::path>& shards, unsigned threads = 0,
+                          unsigned max_io_threads = 0, WeightList* weights = nullptr);
+
+#endif // EDGE_IO_H
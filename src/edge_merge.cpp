@@ -0,0 +1,172 @@
+// Duplicate-edge merging: canonicalise, radix-sort by (u, v), then collapse
+// runs of equal pairs in parallel.
+
+#include "edge_merge.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+
+#include "edge_io.h"
+#include "parallel.h"
+#include "radix_sort.h"
+
+DuplicatePolicy parse_duplicate_policy(const std::string& name) {
+    if (name == "sum") return DuplicatePolicy::Sum;
+    if (name == "max") return DuplicatePolicy::Max;
+    if (name == "first") return DuplicatePolicy::First;
+    throw std::invalid_argument("Unknown duplicate-edge policy: " + name);
+}
+
+const char* duplicate_policy_name(DuplicatePolicy p) {
+    switch (p) {
+        case DuplicatePolicy::Sum:   return "sum";
+        case DuplicatePolicy::Max:   return "max";
+        case DuplicatePolicy::First: return "first";
+    }
+    return "?";
+}
+
+SelfLoopPolicy parse_self_loop_policy(const std::string& name) {
+    if (name == "keep") return SelfLoopPolicy::Keep;
+    if (name == "drop") return SelfLoopPolicy::Drop;
+    throw std::invalid_argument("Unknown self-loop policy: " + name);
+}
+
+namespace {
+
+struct WeightedPair { uint64_t u; uint64_t v; double w; };
+
+// Both endpoints in one key (u above v) when ids fit in 32 bits: half the
+// sort record and a single sort instead of two.
+struct PackedPair { uint64_t key; double w; };
+
+// Endpoints of a sorted record, for each record layout.
+struct WideKeys {
+    unsigned shift;
+    uint64_t u(const WeightedPair& r) const { return r.u; }
+    uint64_t v(const WeightedPair& r) const { return r.v; }
+    bool same(const WeightedPair& a, const WeightedPair& b) const { return a.u == b.u && a.v == b.v; }
+};
+struct PackedKeys {
+    unsigned shift;
+    uint64_t u(const PackedPair& r) const { return r.key >> shift; }
+    uint64_t v(const PackedPair& r) const { return r.key & ((uint64_t(1) << shift) - 1); }
+    bool same(const PackedPair& a, const PackedPair& b) const { return a.key == b.key; }
+};
+
+// Collapses runs of equal pairs in recs[0..kept) into es and weights.
+template <class Rec, class Keys>
+size_t collapse_runs(const Rec* recs, size_t kept, const Keys& keys, DuplicatePolicy dup, int64_t* es,
+                     std::vector<double>& weights, unsigned threads) {
+    auto is_head = [&](size_t i) { return i == 0 || !keys.same(recs[i], recs[i - 1]); };
+
+    // Count run heads per block, then let each block write its runs (a run
+    // belongs to the block holding its head and may extend past the block end).
+    std::vector<size_t> base(threads + 1, 0);
+    parallel_for(kept, threads, [&](size_t b, size_t e, unsigned t) {
+        size_t c = 0;
+        for (size_t i = b; i < e; ++i) c += is_head(i);
+        base[t + 1] = c;
+    });
+    for (unsigned t = 0; t < threads; ++t) base[t + 1] += base[t];
+    const size_t out_m = base[threads];
+
+    std::vector<double> merged(out_m);
+    parallel_for(kept, threads, [&](size_t b, size_t e, unsigned t) {
+        size_t o = base[t];
+        for (size_t i = b; i < e; ++i) {
+            if (!is_head(i)) continue;
+            double w = recs[i].w;
+            for (size_t j = i + 1; j < kept && !is_head(j); ++j) {
+                if (dup == DuplicatePolicy::Sum) w += recs[j].w;
+                else if (dup == DuplicatePolicy::Max) w = std::max(w, recs[j].w);
+            }
+            es[2 * o] = (int64_t) keys.u(recs[i]);
+            es[2 * o + 1] = (int64_t) keys.v(recs[i]);
+            merged[o++] = w;
+        }
+    });
+    weights.swap(merged);
+    return out_m;
+}
+
+} // namespace
+
+size_t merge_duplicate_edges(int64_t* es, size_t m, int64_t n, bool directed,
+                             DuplicatePolicy dup, SelfLoopPolicy loops,
+                             std::vector<double>& weights, unsigned threads) {
+    auto t_start = std::chrono::steady_clock::now();
+    threads = resolve_threads(threads);
+    if (!weights.empty() && weights.size() != m)
+        throw std::invalid_argument("merge_duplicate_edges: weight count does not match edge count");
+    const bool unit = weights.empty();
+
+    // Dropped self-loops get u = n so they sort past every real edge. Radix
+    // sorts are stable, so input order survives inside each run of equal
+    // pairs (needed for DuplicatePolicy::First).
+    const unsigned bits = bit_width_u64((uint64_t) n);
+    auto canonical = [&](size_t i, uint64_t& u, uint64_t& v) {
+        u = (uint64_t) es[2 * i]; v = (uint64_t) es[2 * i + 1];
+        if (!directed && v < u) std::swap(u, v);
+        if (u == v && loops == SelfLoopPolicy::Drop) u = (uint64_t) n;
+    };
+    size_t kept, out_m;
+    if (bits <= 32) {
+        const PackedKeys keys{bits};
+        std::vector<PackedPair, default_init_allocator<PackedPair>> recs(m), tmp(m);
+        parallel_for(m, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t i = b; i < e; ++i) {
+                uint64_t u, v;
+                canonical(i, u, v);
+                recs[i] = PackedPair{u << bits | v, unit ? 1.0 : weights[i]};
+            }
+        });
+        radix_sort(recs.data(), tmp.data(), m, 2 * bits, [](const PackedPair& r) { return r.key; }, threads);
+        tmp = decltype(tmp)();
+        kept = (size_t) (std::lower_bound(recs.begin(), recs.end(), (uint64_t) n << bits,
+                                          [](const PackedPair& r, uint64_t key) { return r.key < key; })
+                         - recs.begin());
+        out_m = collapse_runs(recs.data(), kept, keys, dup, es, weights, threads);
+    } else {
+        const WideKeys keys{0};
+        std::vector<WeightedPair, default_init_allocator<WeightedPair>> recs(m), tmp(m);
+        parallel_for(m, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t i = b; i < e; ++i) {
+                uint64_t u, v;
+                canonical(i, u, v);
+                recs[i] = WeightedPair{u, v, unit ? 1.0 : weights[i]};
+            }
+        });
+        // LSD: stable by v, then stable by u, gives (u, v) order.
+        radix_sort(recs.data(), tmp.data(), m, bits, [](const WeightedPair& r) { return r.v; }, threads);
+        radix_sort(recs.data(), tmp.data(), m, bits, [](const WeightedPair& r) { return r.u; }, threads);
+        tmp = decltype(tmp)();
+        kept = (size_t) (std::lower_bound(recs.begin(), recs.end(), (uint64_t) n,
+                                          [](const WeightedPair& r, uint64_t key) { return r.u < key; })
+                         - recs.begin());
+        out_m = collapse_runs(recs.data(), kept, keys, dup, es, weights, threads);
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    std::cerr << "Merged duplicate edges (" << duplicate_policy_name(dup) << "): " << m << " -> " << out_m
+              << " edges (" << (m ? 100.0 * (double) (m - out_m) / (double) m : 0.0) << "% fewer";
+    if (loops == SelfLoopPolicy::Drop) std::cerr << ", " << m - kept << " self-loops dropped";
+    std::cerr << ") in " << secs << " s\n";
+    return out_m;
+}
+
+size_t drop_self_loops(int64_t* es, size_t m, std::vector<double>& weights) {
+    size_t w = 0;
+    for (size_t i = 0; i < m; ++i) {
+        if (es[2 * i] == es[2 * i + 1]) continue;
+        es[2 * w] = es[2 * i];
+        es[2 * w + 1] = es[2 * i + 1];
+        if (!weights.empty()) weights[w] = weights[i];
+        ++w;
+    }
+    if (!weights.empty()) weights.resize(w);
+    std::cerr << "Dropped " << m - w << " self-loops\n";
+    return w;
+}
@@ -0,0 +1,40 @@
+#ifndef EDGE_MERGE_H
+#define EDGE_MERGE_H
+
+// Duplicate-edge merging and self-loop handling on a remapped edge array.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class DuplicatePolicy {
+    Sum,    // merged weight is the sum (multigraph semantics)
+    Max,    // largest weight of the duplicates
+    First,  // weight of the first occurrence in input order
+};
+
+enum class SelfLoopPolicy {
+    Keep,
+    Drop,
+};
+
+DuplicatePolicy parse_duplicate_policy(const std::string& name);
+const char* duplicate_policy_name(DuplicatePolicy p);
+SelfLoopPolicy parse_self_loop_policy(const std::string& name);
+
+// Merges repeated edges of es (pairs es[2i], es[2i+1] in 0..n-1, m of them)
+// in place. For undirected graphs (u,v) and (v,u) are canonicalised to
+// (min, max) first. `weights` holds one weight per input edge, or is empty
+// for unit weights; on return it holds one weight per surviving edge.
+// Surviving edges are sorted by (u, v). Returns the new edge count and logs
+// how much the edge list shrank.
+size_t merge_duplicate_edges(int64_t* es, size_t m, int64_t n, bool directed,
+                             DuplicatePolicy dup, SelfLoopPolicy loops,
+                             std::vector<double>& weights, unsigned threads = 0);
+
+// Removes self-loops from es (and weights, unless empty) in place, keeping
+// the order of the remaining edges. Returns the new edge count.
+size_t drop_self_loops(int64_t* es, size_t m, std::vector<double>& weights);
+
+#endif // EDGE_MERGE_H
@@ -0,0 +1,188 @@
+// Binary graph cache: writer, validator and checksum.
+
+#include "graph_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "parallel.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kMagic[8] = {'L', 'G', 'C', 'A', 'C', 'H', 'E', '\0'};
+constexpr size_t kChecksumBlock = size_t(4) << 20;
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    return x ^ (x >> 33);
+}
+
+uint64_t hash_block(const char* p, size_t n, uint64_t seed) {
+    uint64_t h = mix64(seed ^ n);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t w;
+        std::memcpy(&w, p + i, 8);
+        h = (h ^ mix64(w)) * 0x9e3779b97f4a7c15ULL;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, p + i, n - i);
+    return mix64(h ^ tail);
+}
+
+struct SourceStat {
+    uint64_t size;
+    int64_t mtime_ns;
+};
+
+// Total size and newest mtime over all source files.
+SourceStat stat_sources(const std::vector<fs::path>& sources) {
+    SourceStat total{0, 0};
+    for (const auto& source : sources) {
+        struct stat st;
+        if (::stat(source.c_str(), &st) != 0) throw std::runtime_error("Cannot stat: " + source.string());
+        total.size += (uint64_t) st.st_size;
+        total.mtime_ns = std::max<int64_t>(total.mtime_ns, (int64_t) st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec);
+    }
+    return total;
+}
+
+inline uint64_t align64(uint64_t x) { return (x + 63) & ~uint64_t(63); }
+
+void write_at(std::ofstream& out, uint64_t offset, const void* data, size_t bytes) {
+    out.seekp((std::streamoff) offset);
+    out.write(static_cast<const char*>(data), (std::streamsize) bytes);
+}
+
+} // namespace
+
+uint64_t file_checksum(const fs::path& path, unsigned threads) {
+    MappedFile file(path);
+    const size_t blocks = (file.size() + kChecksumBlock - 1) / kChecksumBlock;
+    std::vector<uint64_t> block_hash(blocks);
+    parallel_for(blocks, resolve_threads(threads), [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) {
+            const size_t off = i * kChecksumBlock;
+            block_hash[i] = hash_block(file.data() + off, std::min(kChecksumBlock, file.size() - off), i);
+        }
+    });
+    uint64_t h = mix64(file.size());
+    for (uint64_t bh : block_hash) h = mix64(h ^ bh) + 0x9e3779b97f4a7c15ULL;
+    return h;
+}
+
+uint64_t sources_checksum(const std::vector<fs::path>& sources, unsigned threads) {
+    uint64_t h = file_checksum(sources.at(0), threads);
+    for (size_t i = 1; i < sources.size(); ++i)
+        h = mix64(h ^ file_checksum(sources[i], threads)) + 0x9e3779b97f4a7c15ULL;
+    return h;
+}
+
+fs::path graph_cache_path(const fs::path& source, const fs::path& cache_dir, uint64_t build_key) {
+    const fs::path src = source.filename().empty() ? source.parent_path() : source;  // "dir/"
+    std::string base = src.filename().string();
+    std::replace_if(base.begin(), base.end(), [](char c) { return c == '*' || c == '?' || c == '[' || c == ']'; }, '_');
+    // Inputs with the same name in different directories can share a
+    // --cache-dir, so the name also carries a hash of the full source path.
+    std::error_code ec;
+    fs::path full = fs::weakly_canonical(fs::absolute(src), ec);
+    if (ec) full = fs::absolute(src).lexically_normal();
+    const std::string key = full.string();
+    std::ostringstream name;
+    name << base << '.' << std::hex << std::setfill('0') << std::setw(16) << hash_block(key.data(), key.size(), 0)
+         << '.' << std::setw(16) << build_key << ".lgcache";
+    return (cache_dir.empty() ? src.parent_path() : cache_dir) / name.str();
+}
+
+void write_graph_cache(const fs::path& cache, const std::vector<fs::path>& sources, uint64_t build_key,
+                       const GraphCacheView& data, unsigned threads) {
+    const SourceStat st = stat_sources(sources);
+
+    GraphCacheHeader h;
+    std::memset(&h, 0, sizeof h);
+    std::memcpy(h.magic, kMagic, sizeof kMagic);
+    h.version = kGraphCacheVersion;
+    h.flags = (data.weights ? kCacheWeighted : 0) | (data.inv_map ? kCacheInvMap : 0);
+    h.build_key = build_key;
+    h.source_size = st.size;
+    h.source_mtime_ns = st.mtime_ns;
+    h.source_checksum = sources_checksum(sources, threads);
+    h.n = data.n;
+    h.m = data.m;
+    h.edges_offset = align64(sizeof h);
+    h.weights_offset = align64(h.edges_offset + 2 * (uint64_t) data.m * sizeof(int64_t));
+    h.inv_map_offset = align64(h.weights_offset + (data.weights ? (uint64_t) data.m * sizeof(double) : 0));
+    h.file_size = h.inv_map_offset + (data.inv_map ? (uint64_t) data.n * sizeof(int64_t) : 0);
+
+    fs::create_directories(cache.parent_path().empty() ? fs::path(".") : cache.parent_path());
+    fs::path tmp = cache;
+    tmp += ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Cannot open cache for write: " + tmp.string());
+        write_at(out, 0, &h, sizeof h);
+        write_at(out, h.edges_offset, data.edges, 2 * (size_t) data.m * sizeof(int64_t));
+        if (data.weights) write_at(out, h.weights_offset, data.weights, (size_t) data.m * sizeof(double));
+        if (data.inv_map) write_at(out, h.inv_map_offset, data.inv_map, (size_t) data.n * sizeof(int64_t));
+        out.flush();
+        if (!out) {
+            out.close();
+            fs::remove(tmp);
+            throw std::runtime_error("Failed writing cache: " + tmp.string());
+        }
+    }
+    fs::rename(tmp, cache);
+}
+
+std::unique_ptr<GraphCacheFile> GraphCacheFile::open(const fs::path& cache, const std::vector<fs::path>& sources,
+                                                     uint64_t build_key, bool verify_checksum,
+                                                     unsigned threads) {
+    std::error_code ec;
+    if (!fs::is_regular_file(cache, ec)) return nullptr;
+
+    auto stale = [&](const char* why) -> std::unique_ptr<GraphCacheFile> {
+        std::cerr << "Ignoring graph cache " << cache << ": " << why << "\n";
+        return nullptr;
+    };
+
+    std::unique_ptr<GraphCacheFile> f(new GraphCacheFile(cache));
+    const char* base = f->map_.data();
+    const size_t size = f->map_.size();
+    GraphCacheHeader h;
+    if (size < sizeof h) return stale("truncated header");
+    std::memcpy(&h, base, sizeof h);
+    if (std::memcmp(h.magic, kMagic, sizeof kMagic) != 0) return stale("not a graph cache");
+    if (h.version != kGraphCacheVersion) return stale("format version differs");
+    if (h.build_key != build_key) return stale("built with different options");
+    if (h.file_size != size || h.n < 0 || h.m < 0 ||
+        h.edges_offset + 2 * (uint64_t) h.m * sizeof(int64_t) > size ||
+        ((h.flags & kCacheWeighted) && h.weights_offset + (uint64_t) h.m * sizeof(double) > size) ||
+        ((h.flags & kCacheInvMap) && h.inv_map_offset + (uint64_t) h.n * sizeof(int64_t) > size) ||
+        (h.edges_offset | h.weights_offset | h.inv_map_offset) % 8 != 0)
+        return stale("corrupt or truncated");
+
+    const SourceStat st = stat_sources(sources);
+    if (st.size != h.source_size || st.mtime_ns != h.source_mtime_ns) return stale("source file changed");
+    if (verify_checksum && sources_checksum(sources, threads) != h.source_checksum)
+        return stale("source checksum differs");
+
+    f->view_.n = h.n;
+    f->view_.m = h.m;
+    f->view_.edges = reinterpret_cast<const int64_t*>(base + h.edges_offset);
+    f->view_.weights = (h.flags & kCacheWeighted) ? reinterpret_cast<const double*>(base + h.weights_offset) : nullptr;
+    f->view_.inv_map = (h.flags & kCacheInvMap) ? reinterpret_cast<const int64_t*>(base + h.inv_map_offset) : nullptr;
+    return f;
+}
@@ -0,0 +1,88 @@
+#ifndef GRAPH_CACHE_H
+#define GRAPH_CACHE_H
+
+// Binary cache of a prepared graph (remapped edge array, optional edge
+// weights, inverse id map), so repeat runs on the same input skip parsing,
+// remapping and duplicate merging.
+//
+// Layout (little-endian, sections 64-byte aligned):
+//   GraphCacheHeader | edges int64[2m] | weights double[m] | inv_map int64[n]
+// The weights and inv_map sections are absent when unweighted / when ids
+// were used as-is. A sharded input is fingerprinted as a whole: sizes are
+// summed, the newest mtime is kept and the shard checksums are chained in
+// order.
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "mapped_file.h"
+
+constexpr uint32_t kGraphCacheVersion = 1;
+
+struct GraphCacheHeader {
+    char magic[8];              // "LGCACHE\0"
+    uint32_t version;
+    uint32_t flags;             // kCacheWeighted | kCacheInvMap
+    uint64_t build_key;         // options that shape the edge array
+    uint64_t source_size;
+    int64_t source_mtime_ns;
+    uint64_t source_checksum;
+    int64_t n;
+    int64_t m;
+    uint64_t edges_offset;
+    uint64_t weights_offset;
+    uint64_t inv_map_offset;
+    uint64_t file_size;
+};
+
+constexpr uint32_t kCacheWeighted = 1u << 0;
+constexpr uint32_t kCacheInvMap = 1u << 1;
+
+// What a cache holds; pointers refer to caller-owned (writing) or mapped
+// (reading) memory.
+struct GraphCacheView {
+    int64_t n = 0;
+    int64_t m = 0;
+    const int64_t* edges = nullptr;     // pairs, 2m entries in 0..n-1
+    const double* weights = nullptr;    // m entries, or null
+    const int64_t* inv_map = nullptr;   // n entries, or null (ids used as-is)
+};
+
+// Parallel 64-bit content hash of a file (block hashes combined in order).
+uint64_t file_checksum(const std::filesystem::path& path, unsigned threads = 0);
+
+// Checksums of several files chained in order; equals file_checksum for one.
+uint64_t sources_checksum(const std::vector<std::filesystem::path>& sources, unsigned threads = 0);
+
+// <dir or source's dir>/<source file name>.<path hash>.<build_key>.lgcache,
+// both in hex; the path hash is of the canonical absolute source path. The
+// source may be a directory or a glob (wildcards become '_').
+std::filesystem::path graph_cache_path(const std::filesystem::path& source,
+                                       const std::filesystem::path& cache_dir, uint64_t build_key);
+
+// Writes the cache atomically (temporary file, then rename). Throws on I/O errors.
+void write_graph_cache(const std::filesystem::path& cache, const std::vector<std::filesystem::path>& sources,
+                       uint64_t build_key, const GraphCacheView& data, unsigned threads = 0);
+
+// A validated, memory-mapped cache file.
+class GraphCacheFile {
+public:
+    // Returns null when the cache is missing, from another version or build
+    // key, truncated, or older than the source (size or mtime changed). With
+    // verify_checksum the source is also re-hashed and compared.
+    static std::unique_ptr<GraphCacheFile> open(const std::filesystem::path& cache,
+                                                const std::vector<std::filesystem::path>& sources, uint64_t build_key,
+                                                bool verify_checksum, unsigned threads = 0);
+
+    const GraphCacheView& view() const { return view_; }
+
+private:
+    explicit GraphCacheFile(const std::filesystem::path& cache) : map_(cache, MADV_WILLNEED) {}
+
+    MappedFile map_;
+    GraphCacheView view_;
+};
+
+#endif // GRAPH_CACHE_H
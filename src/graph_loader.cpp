@@ -0,0 +1,170 @@
+// Graph loading: shards -> parsed edges -> remapped / merged edge array ->
+// igraph graph, with the binary graph cache short-circuiting the middle.
+
+#include "graph_loader.h"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "graph_cache.h"
+
+namespace fs = std::filesystem;
+
+uint64_t graph_build_key(const GraphBuildOptions& opt, bool weighted) {
+    uint64_t key = 0;
+    key |= (uint64_t) opt.directed << 0;
+    key |= (uint64_t) opt.assume_dense_ids << 1;
+    key |= (uint64_t) weighted << 2;
+    key |= (uint64_t) opt.merge_duplicates << 3;
+    if (opt.merge_duplicates) key |= (uint64_t) opt.duplicates << 4;
+    key |= (uint64_t) opt.self_loops << 8;
+    key |= (uint64_t) opt.reorder << 12;
+    return key;
+}
+
+PreparedEdges prepare_edges(EdgeList&& edges_raw, WeightList* weights_raw,
+                            const GraphBuildOptions& opt, RunReport* report) {
+    PreparedEdges p;
+    RunReport::Phase remap_phase(report, "remap");
+    remap_phase.add_edges(edges_raw.size());
+    // Map arbitrary node IDs to 0..N-1
+    if (opt.low_memory) {
+        p.storage = std::move(edges_raw);
+        if (opt.assume_dense_ids) {
+            p.n = identity_edge_ids(p.storage, edge_id_array(p.storage), opt.threads);
+        } else {
+            RemapStrategy used;
+            p.n = remap_edge_ids_in_place(p.storage, &p.inv_map, opt.remap, opt.threads, &used);
+            std::cerr << "Remapped " << p.n << " node ids in place (" << remap_strategy_name(used) << ")\n";
+        }
+    } else {
+        p.storage.resize(edges_raw.size());
+        if (opt.assume_dense_ids) {
+            p.n = identity_edge_ids(edges_raw, edge_id_array(p.storage), opt.threads);
+        } else {
+            RemapStrategy used;
+            p.n = remap_edge_ids(edges_raw, edge_id_array(p.storage), &p.inv_map, opt.remap, opt.threads, &used);
+            std::cerr << "Remapped " << p.n << " node ids (" << remap_strategy_name(used) << ")\n";
+        }
+        edges_raw = EdgeList();
+    }
+    if (opt.assume_dense_ids) std::cerr << "Using node ids as-is (0.." << p.n - 1 << ")\n";
+
+    if (weights_raw) {
+        p.weights.assign(weights_raw->begin(), weights_raw->end());
+        *weights_raw = WeightList();
+    }
+    remap_phase.finish();
+
+    size_t m = p.storage.size();
+    RunReport::Phase dedup_phase(opt.merge_duplicates || opt.self_loops == SelfLoopPolicy::Drop ? report : nullptr,
+                                 "dedup");
+    dedup_phase.add_edges(m);
+    if (opt.merge_duplicates) {
+        m = merge_duplicate_edges(p.es(), m, p.n, opt.directed, opt.duplicates, opt.self_loops, p.weights, opt.threads);
+    } else if (opt.self_loops == SelfLoopPolicy::Drop) {
+        m = drop_self_loops(p.es(), m, p.weights);
+    }
+    p.storage.resize(m);
+    dedup_phase.finish();
+
+    if (opt.reorder != VertexOrder::None) {
+        const double gap_before = edge_id_gap(edge_id_array(p.storage), m, opt.threads);
+        const auto t0 = std::chrono::steady_clock::now();
+        {
+            RunReport::Phase reorder_phase(report, "reorder");
+            reorder_phase.add_edges(m);
+            const std::vector<int64_t> perm = vertex_order(edge_id_array(p.storage), m, p.n,
+                                                           p.weights.empty() ? nullptr : p.weights.data(),
+                                                           opt.reorder, opt.threads);
+            apply_vertex_order(edge_id_array(p.storage), m, perm, &p.inv_map, opt.threads);
+        }
+        const double reorder_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        const double gap_after = edge_id_gap(edge_id_array(p.storage), m, opt.threads);
+        std::cerr << "Reordered " << p.n << " vertices (" << vertex_order_name(opt.reorder) << ") in " << reorder_s
+                  << " s; mean log2 neighbour id gap " << gap_before << " -> " << gap_after << "\n";
+        if (report) {
+            report->set("reorder_gap_before", gap_before);
+            report->set("reorder_gap_after", gap_after);
+        }
+    }
+    return p;
+}
+
+void create_graph(const igraph_integer_t* es, size_t m, int64_t n, bool directed, igraph_t* g) {
+    igraph_vector_int_t edges_vec;
+    igraph_vector_int_view(&edges_vec, es, (igraph_integer_t) (2 * m));
+    if (igraph_create(g, &edges_vec, (igraph_integer_t) n, directed ? IGRAPH_DIRECTED : IGRAPH_UNDIRECTED))
+        throw std::runtime_error("igraph_create failed");
+}
+
+void load_graph(const fs::path& input, const GraphLoadOptions& opt, igraph_t* g,
+                std::vector<long long>* inv_map, std::vector<double>* weights, RunReport* report) {
+    const GraphBuildOptions& build = opt.build;
+    const unsigned threads = build.threads;
+    const std::vector<fs::path> shards = expand_input_shards(input);
+    if (report && shards.size() > 1) report->set("input_shards", (int64_t) shards.size());
+    if (report && build.reorder != VertexOrder::None) report->set("reorder", vertex_order_name(build.reorder));
+    const uint64_t build_key = graph_build_key(build, opt.weighted);
+    const fs::path cache_path = opt.use_cache ? graph_cache_path(input, opt.cache_dir, build_key) : fs::path();
+
+    auto t_load = std::chrono::steady_clock::now();
+    std::unique_ptr<GraphCacheFile> cached;
+    if (opt.use_cache) cached = GraphCacheFile::open(cache_path, shards, build_key, opt.verify_cache, threads);
+    if (cached) {
+        static_assert(sizeof(igraph_integer_t) == sizeof(int64_t) && sizeof(long long) == sizeof(int64_t),
+                      "graph cache stores 64-bit ids");
+        const GraphCacheView& c = cached->view();
+        RunReport::Phase build_phase(report, "graph_build");
+        build_phase.add_edges((uint64_t) c.m);
+        create_graph(reinterpret_cast<const igraph_integer_t*>(c.edges), (size_t) c.m, c.n, build.directed, g);
+        if (c.weights) weights->assign(c.weights, c.weights + c.m);
+        if (c.inv_map) inv_map->assign(c.inv_map, c.inv_map + c.n);
+        cached.reset();
+        build_phase.finish();
+        if (report) report->set("graph_cache", "hit");
+        std::cerr << "Loaded graph cache " << cache_path << " in "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - t_load).count() << " s\n";
+        return;
+    }
+
+    EdgeList edges;
+    WeightList edge_weights;
+    WeightList* wl = opt.weighted ? &edge_weights : nullptr;
+    RunReport::Phase load_phase(report, "load");
+    for (const auto& shard : shards) load_phase.add_bytes((uint64_t) fs::file_size(shard));
+    edges = read_edge_shards(shards, threads, opt.max_io_threads, wl);
+
+    std::cerr << "Loaded " << edges.size() << " edges\n";
+    load_phase.add_edges(edges.size());
+    load_phase.finish();
+
+    PreparedEdges prepared = prepare_edges(std::move(edges), wl, build, report);
+    const size_t m = prepared.m();
+    if (opt.use_cache) {
+        RunReport::Phase cache_phase(report, "cache_write");
+        GraphCacheView view;
+        view.n = prepared.n;
+        view.m = (int64_t) m;
+        view.edges = reinterpret_cast<const int64_t*>(prepared.es());
+        view.weights = prepared.weights.empty() ? nullptr : prepared.weights.data();
+        view.inv_map = prepared.inv_map.empty() ? nullptr : reinterpret_cast<const int64_t*>(prepared.inv_map.data());
+        try {
+            write_graph_cache(cache_path, shards, build_key, view, threads);
+            std::cerr << "Wrote graph cache " << cache_path << "\n";
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: could not write graph cache: " << e.what() << "\n";
+        }
+    }
+    RunReport::Phase build_phase(report, "graph_build");
+    build_phase.add_edges(m);
+    create_graph(prepared.es(), m, prepared.n, build.directed, g);
+    prepared.storage = EdgeList();
+    *inv_map = std::move(prepared.inv_map);
+    *weights = std::move(prepared.weights);
+    build_phase.finish();
+    if (report) report->set("graph_cache", opt.use_cache ? "miss" : "off");
+}
@@ -0,0 +1,79 @@
+#ifndef GRAPH_LOADER_H
+#define GRAPH_LOADER_H
+
+// Edge input -> igraph graph: shard expansion, parsing, id remapping,
+// duplicate merging and the binary graph cache. Shared by leiden_igraph and
+// leiden_server.
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <igraph/igraph.h>
+
+#include "edge_io.h"
+#include "edge_merge.h"
+#include "id_remap.h"
+#include "reorder.h"
+#include "run_report.h"
+
+struct GraphBuildOptions {
+    bool directed = false;
+    RemapStrategy remap = RemapStrategy::Auto;
+    bool assume_dense_ids = false;
+    bool merge_duplicates = false;                      // --dedup
+    DuplicatePolicy duplicates = DuplicatePolicy::Sum;
+    SelfLoopPolicy self_loops = SelfLoopPolicy::Keep;
+    bool low_memory = false;                            // --low-memory: remap in place, free stages early
+    VertexOrder reorder = VertexOrder::None;            // --reorder
+    unsigned threads = 0;
+};
+
+// Identifies the options that shape the prepared edge array, so a graph
+// cache is only reused by runs that would have built the same graph.
+uint64_t graph_build_key(const GraphBuildOptions& opt, bool weighted);
+
+// Remapped (and possibly merged) edge array ready for igraph.
+struct PreparedEdges {
+    EdgeList storage;                // edge i is (es()[2i], es()[2i+1]), ids 0..n-1
+    int64_t n = 0;
+    std::vector<double> weights;     // one per edge, empty when unweighted
+    std::vector<long long> inv_map;  // empty when ids are used as-is (assume_dense_ids)
+
+    static_assert(sizeof(igraph_integer_t) == sizeof(int64_t), "igraph edge ids are 64-bit");
+    igraph_integer_t* es() { return reinterpret_cast<igraph_integer_t*>(edge_id_array(storage)); }
+    size_t m() const { return storage.size(); }
+};
+
+// Consumes the loader's edges (and weights, when non-null: one per input
+// edge); both are released here. By default ids are remapped into a second
+// array; with low_memory they overwrite the loaded edges, so only one edge
+// buffer ever exists. With a reorder, vertices are then renumbered and
+// inv_map follows them, so output still carries the original ids. Phases
+// are recorded in `report` when it is non-null.
+PreparedEdges prepare_edges(EdgeList&& edges_raw, WeightList* weights_raw,
+                            const GraphBuildOptions& opt, RunReport* report);
+
+// Builds g straight from the edge array in one igraph_create call (viewed,
+// not copied), so igraph sizes its edge and index vectors once.
+void create_graph(const igraph_integer_t* es, size_t m, int64_t n, bool directed, igraph_t* g);
+
+struct GraphLoadOptions {
+    GraphBuildOptions build;
+    bool weighted = false;
+    bool use_cache = true;
+    bool verify_cache = false;       // re-hash the input before trusting a cache
+    std::filesystem::path cache_dir; // empty = next to the input
+    unsigned max_io_threads = 0;     // shards read at once, 0 = up to build.threads
+};
+
+// Loads `input` (a file, a directory of shards or a glob) into *g, which the
+// caller destroys, with its edge weights (empty when unweighted) and inverse
+// id map (empty when ids were used as-is). A valid graph cache is used
+// instead of parsing; otherwise one is written after the edges are
+// prepared. Records load, remap, dedup, cache_write and graph_build phases
+// and the input_shards and graph_cache fields in `report` when non-null.
+void load_graph(const std::filesystem::path& input, const GraphLoadOptions& opt, igraph_t* g,
+                std::vector<long long>* inv_map, std::vector<double>* weights, RunReport* report = nullptr);
+
+#endif // GRAPH_LOADER_H
@@ -0,0 +1,266 @@
+// Pendant and chain folding before Leiden, and the expansion back.
+
+#include "graph_reduction.h"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+
+#include "parallel.h"
+
+Reduction parse_reduction(const std::string& name) {
+    if (name == "none") return Reduction::None;
+    if (name == "pendants") return Reduction::Pendants;
+    if (name == "chains") return Reduction::Chains;
+    throw std::invalid_argument("Unknown reduction: " + name);
+}
+
+const char* reduction_name(Reduction r) {
+    switch (r) {
+        case Reduction::None:     return "none";
+        case Reduction::Pendants: return "pendants";
+        case Reduction::Chains:   return "chains";
+    }
+    return "?";
+}
+
+GraphReduction reduce_graph(const int64_t* src, const int64_t* dst, size_t m, int64_t n, const double* weights,
+                            const double* node_weights, double gamma, const ReductionOptions& opt) {
+    GraphReduction r;
+    r.stats.vertices = n;
+    r.stats.edges = (int64_t) m;
+    auto weight = [&](int64_t e) { return weights ? weights[e] : 1.0; };
+
+    // Incident edges of each vertex (edge ids, self-loops left out; those go
+    // straight into loop[]). deg[] counts the ones still alive.
+    std::vector<int64_t> off((size_t) n + 1, 0);
+    std::vector<double> loop((size_t) n, 0.0);
+    std::vector<char> dead(m, 0);
+    for (size_t e = 0; e < m; ++e) {
+        if (src[e] == dst[e]) {
+            loop[(size_t) src[e]] += weight((int64_t) e);
+            dead[e] = 1;
+            continue;
+        }
+        ++off[(size_t) src[e] + 1];
+        ++off[(size_t) dst[e] + 1];
+    }
+    std::partial_sum(off.begin(), off.end(), off.begin());
+    std::vector<int64_t> inc((size_t) off[(size_t) n]);
+    {
+        std::vector<int64_t> cursor(off.begin(), off.end() - 1);
+        for (size_t e = 0; e < m; ++e) {
+            if (dead[e]) continue;
+            inc[(size_t) cursor[(size_t) src[e]]++] = (int64_t) e;
+            inc[(size_t) cursor[(size_t) dst[e]]++] = (int64_t) e;
+        }
+    }
+    std::vector<int64_t> deg((size_t) n);
+    std::vector<double> nw((size_t) n);
+    for (int64_t v = 0; v < n; ++v) {
+        deg[(size_t) v] = off[(size_t) v + 1] - off[(size_t) v];
+        nw[(size_t) v] = node_weights ? node_weights[v] : 1.0;
+    }
+
+    // A group is named by its root; an edge's ends are the roots of its
+    // stored endpoints. A contracted degree-2 vertex hands its remaining edge
+    // to the group it joined through the extra lists.
+    std::vector<int64_t> parent((size_t) n);
+    std::iota(parent.begin(), parent.end(), (int64_t) 0);
+    auto root = [&](int64_t x) {
+        while (parent[(size_t) x] != x) {
+            parent[(size_t) x] = parent[(size_t) parent[(size_t) x]];
+            x = parent[(size_t) x];
+        }
+        return x;
+    };
+    std::vector<int64_t> extra_head((size_t) n, -1), extra_edge, extra_next;
+    std::vector<char> folded((size_t) n, 0);
+    auto merge = [&](int64_t v, int64_t u, double w) {
+        parent[(size_t) v] = u;
+        nw[(size_t) u] += nw[(size_t) v];
+        loop[(size_t) u] += loop[(size_t) v] + w;
+        folded[(size_t) u] = 1;
+        deg[(size_t) v] = 0;
+    };
+
+    std::vector<int64_t> stack;
+    auto candidate = [&](int64_t v) {
+        if (deg[(size_t) v] >= 1 && deg[(size_t) v] <= 2) stack.push_back(v);
+    };
+    for (int64_t v = n - 1; v >= 0; --v) candidate(v);
+
+    while (!stack.empty()) {
+        const int64_t v = stack.back();
+        stack.pop_back();
+        const int64_t k = deg[(size_t) v];
+        if (parent[(size_t) v] != v || k < 1 || k > 2) continue;
+
+        int64_t e[2], nb[2];
+        double w[2];
+        int found = 0;
+        auto take = [&](int64_t edge) {
+            if (found == k || dead[(size_t) edge]) return;
+            const int64_t a = root(src[edge]), b = root(dst[edge]);
+            e[found] = edge;
+            nb[found] = a == v ? b : a;
+            w[found] = weight(edge);
+            ++found;
+        };
+        for (int64_t i = off[(size_t) v]; i < off[(size_t) v + 1] && found < k; ++i) take(inc[(size_t) i]);
+        for (int64_t x = extra_head[(size_t) v]; x >= 0 && found < k; x = extra_next[(size_t) x]) take(extra_edge[(size_t) x]);
+        if (found != k) throw std::logic_error("reduce_graph: degree out of step with the edge lists");
+
+        if (k == 1 || nb[0] == nb[1]) {
+            // Pendant: every edge goes to the same neighbour.
+            const int64_t u = nb[0];
+            const double wu = k == 1 ? w[0] : w[0] + w[1];
+            if (wu < gamma * nw[(size_t) u] * nw[(size_t) v]) continue;
+            merge(v, u, wu);
+            for (int i = 0; i < k; ++i) dead[(size_t) e[i]] = 1;
+            deg[(size_t) u] -= k;
+            ++r.stats.pendants;
+            candidate(u);
+        } else if (opt.mode == Reduction::Chains) {
+            // Middle of a chain: join the heavier side, and the other edge
+            // now runs from that side's group.
+            const int j = (w[0] > w[1] || (w[0] == w[1] && nb[0] < nb[1])) ? 0 : 1;
+            const int64_t u = nb[j], o = nb[1 - j];
+            if (w[j] < gamma * nw[(size_t) u] * nw[(size_t) v]) continue;
+            merge(v, u, w[j]);
+            dead[(size_t) e[j]] = 1;
+            extra_edge.push_back(e[1 - j]);
+            extra_next.push_back(extra_head[(size_t) u]);
+            extra_head[(size_t) u] = (int64_t) extra_edge.size() - 1;
+            ++r.stats.chains;
+            // Both ends may now hold two parallel edges to each other.
+            candidate(u);
+            candidate(o);
+        }
+    }
+
+    // Groups that keep an edge become the reduced vertices, in root order;
+    // the dropped ones are numbered after them.
+    std::vector<int64_t> id((size_t) n, -1);
+    std::vector<int64_t> dropped;
+    for (int64_t v = 0; v < n; ++v) {
+        if (parent[(size_t) v] != v) continue;
+        const bool bare = !folded[(size_t) v] && loop[(size_t) v] == 0.0;
+        if (deg[(size_t) v] == 0 && (bare ? opt.drop_isolated : opt.drop_folded)) dropped.push_back(v);
+        else id[(size_t) v] = r.n++;
+    }
+    for (size_t i = 0; i < dropped.size(); ++i) id[(size_t) dropped[i]] = r.n + (int64_t) i;
+    r.groups = r.n + (int64_t) dropped.size();
+    r.group.resize((size_t) n);
+    for (int64_t v = 0; v < n; ++v) r.group[(size_t) v] = id[(size_t) root(v)];
+
+    r.node_weights.resize((size_t) r.n);
+    for (int64_t v = 0; v < n; ++v)
+        if (parent[(size_t) v] == v && id[(size_t) v] < r.n) r.node_weights[(size_t) id[(size_t) v]] = nw[(size_t) v];
+    for (size_t e = 0; e < m; ++e) {
+        if (dead[e]) continue;
+        r.edges.push_back(id[(size_t) root(src[e])]);
+        r.edges.push_back(id[(size_t) root(dst[e])]);
+        r.weights.push_back(weight((int64_t) e));
+    }
+    for (int64_t v = 0; v < n; ++v) {
+        if (parent[(size_t) v] != v || id[(size_t) v] >= r.n || loop[(size_t) v] == 0.0) continue;
+        r.edges.push_back(id[(size_t) v]);
+        r.edges.push_back(id[(size_t) v]);
+        r.weights.push_back(loop[(size_t) v]);
+    }
+
+    r.stats.reduced_vertices = r.n;
+    r.stats.reduced_edges = (int64_t) r.weights.size();
+    r.stats.dropped = (int64_t) dropped.size();
+    return r;
+}
+
+int64_t expand_membership(const GraphReduction& r, const int64_t* reduced, int64_t reduced_clusters,
+                          int64_t* membership, unsigned threads) {
+    parallel_for(r.group.size(), resolve_threads(threads), [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) {
+            const int64_t g = r.group[v];
+            membership[v] = g < r.n ? reduced[g] : reduced_clusters + (g - r.n);
+        }
+    });
+    return reduced_clusters + (r.groups - r.n);
+}
+
+ReductionStats run_leiden_reduced(const igraph_t* g, const LeidenObjective& obj, double resolution,
+                                  const ReductionOptions& opt, igraph_vector_int_t* membership,
+                                  igraph_integer_t* nb_clusters, igraph_real_t* quality,
+                                  std::vector<IterationRecord>* history, const LeidenRunControl* control,
+                                  RunReport* report) {
+    const unsigned threads = resolve_threads(opt.threads);
+    const int64_t n = igraph_vcount(g);
+    const size_t m = (size_t) igraph_ecount(g);
+
+    RunReport::Phase reduce_phase(report, "reduce");
+    reduce_phase.add_edges((uint64_t) m);
+    // The fold guard in the optimiser's own units: CPM charges resolution
+    // per pair of node weight, modularity resolution / 2m.
+    const double gamma = obj.modularity ? (obj.two_m > 0 ? resolution / obj.two_m : 0.0) : resolution;
+    GraphReduction red;
+    {
+        std::vector<int64_t> src, dst;
+        edge_endpoints(g, src, dst, threads);
+        red = reduce_graph(src.data(), dst.data(), m, n,
+                           obj.edge_weights.empty() ? nullptr : obj.edge_weights.data(),
+                           obj.node_weights.empty() ? nullptr : obj.node_weights.data(), gamma, opt);
+    }
+    ReductionStats st = red.stats;
+
+    LeidenObjective sub;
+    sub.modularity = obj.modularity;
+    sub.two_m = obj.two_m;   // the whole graph's, dropped groups included
+    sub.edge_weights = std::move(red.weights);
+    sub.node_weights = std::move(red.node_weights);
+    igraph_t rg;
+    {
+        std::vector<igraph_integer_t> es(red.edges.begin(), red.edges.end());
+        std::vector<int64_t>().swap(red.edges);
+        igraph_vector_int_t edges_vec;
+        igraph_vector_int_view(&edges_vec, es.data(), (igraph_integer_t) es.size());
+        if (igraph_create(&rg, &edges_vec, (igraph_integer_t) red.n, igraph_is_directed(g)))
+            throw std::runtime_error("igraph_create failed");
+    }
+    reduce_phase.finish();
+    std::cerr << "Reduced: " << st.vertices << " -> " << st.reduced_vertices << " vertices (" << st.ratio()
+              << "), " << st.edges << " -> " << st.reduced_edges << " edges; " << st.pendants
+              << " pendants folded, " << st.chains << " chain vertices contracted, " << st.dropped
+              << " groups dropped\n";
+
+    RunReport::Phase optimise_phase(report, "optimise");
+    optimise_phase.add_edges((uint64_t) st.reduced_edges);
+    igraph_vector_int_t reduced;
+    igraph_vector_int_init(&reduced, 0);
+    igraph_integer_t reduced_clusters = 0;
+    igraph_real_t reduced_quality = 0.0;
+    try {
+        if (red.n > 0)
+            st.stop = run_igraph_leiden_converging(&rg, sub, resolution, opt.beta, /*start=*/false, opt.convergence,
+                                         &reduced, &reduced_clusters, &reduced_quality, history, control);
+        if (igraph_vector_int_resize(membership, (igraph_integer_t) n))
+            throw std::runtime_error("igraph_vector_int_resize failed");
+    } catch (...) {
+        igraph_vector_int_destroy(&reduced);
+        igraph_destroy(&rg);
+        throw;
+    }
+    igraph_destroy(&rg);
+    std::vector<int64_t> reduced_labels(VECTOR(reduced), VECTOR(reduced) + igraph_vector_int_size(&reduced));
+    igraph_vector_int_destroy(&reduced);
+    std::vector<int64_t> labels((size_t) n);
+    *nb_clusters = expand_membership(red, reduced_labels.data(), reduced_clusters, labels.data(), threads);
+    std::copy(labels.begin(), labels.end(), VECTOR(*membership));
+    *quality = partition_quality(g, obj, resolution, membership, threads);
+    if (history) {
+        std::vector<double> iteration_seconds;
+        for (const IterationRecord& rec : *history) iteration_seconds.push_back(rec.seconds);
+        optimise_phase.set_iteration_seconds(std::move(iteration_seconds));
+    }
+    optimise_phase.finish();
+    return st;
+}
@@ -0,0 +1,97 @@
+#ifndef GRAPH_REDUCTION_H
+#define GRAPH_REDUCTION_H
+
+// Graph reduction before Leiden (--reduce): degree-1 vertices are folded
+// into their neighbour, optionally degree-2 vertices into the heavier of
+// their two neighbours, and whatever is left without edges is dropped. The
+// optimiser then runs on the smaller graph and the membership is expanded
+// back to every original vertex.
+//
+// The objective is unchanged for every partition that keeps each folded
+// group together: a group's node weight is the sum of its members' (vertex
+// sizes for CPM, strengths for modularity), and the edges folded inside it
+// become one self-loop, which counts as internal weight. Folding is a
+// constraint, so a fold is made only when it does not lower quality on its
+// own (w_uv >= gamma * W_u * W_v); at high CPM resolutions a hub then keeps
+// only the pendants it can afford instead of gluing a whole star together.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <igraph/igraph.h>
+
+#include "convergence.h"
+#include "igraph_backend.h"
+#include "run_report.h"
+
+enum class Reduction {
+    None,
+    Pendants,  // fold degree-1 vertices, repeatedly, and drop isolated ones
+    Chains,    // also contract degree-2 vertices
+};
+
+Reduction parse_reduction(const std::string& name);
+const char* reduction_name(Reduction r);
+
+struct ReductionOptions {
+    Reduction mode = Reduction::Pendants;
+    bool drop_isolated = true;      // vertices without any edge leave the graph, each its own community
+    bool drop_folded = true;        // so do folded groups left without edges to the rest (whole trees)
+    double beta = 0.01;
+    ConvergenceOptions convergence; // the run on the reduced graph
+    unsigned threads = 0;
+};
+
+struct ReductionStats {
+    int64_t vertices = 0;
+    int64_t edges = 0;
+    int64_t reduced_vertices = 0;   // what Leiden ran on
+    int64_t reduced_edges = 0;      // including one self-loop per group with folded weight
+    int64_t pendants = 0;           // vertices folded into their only neighbour
+    int64_t chains = 0;             // degree-2 vertices contracted
+    int64_t dropped = 0;            // groups left out of the reduced graph
+    StopReason stop = StopReason::Stable;  // run_leiden_reduced: why the run on the reduced graph stopped
+
+    double ratio() const { return vertices ? (double) reduced_vertices / (double) vertices : 1.0; }
+};
+
+// The reduced graph and the way back. Original vertex v belongs to group
+// group[v]: groups 0..n-1 are the reduced graph's vertices, groups n.. were
+// dropped.
+struct GraphReduction {
+    int64_t n = 0;
+    std::vector<int64_t> edges;         // 2 per reduced edge, same orientation as the input
+    std::vector<double> weights;        // one per reduced edge
+    std::vector<double> node_weights;   // summed over each group
+    std::vector<int64_t> group;         // one per original vertex
+    int64_t groups = 0;
+    ReductionStats stats;
+};
+
+// Reduces the graph with edges src[e] - dst[e] (direction ignored when
+// folding, kept in the output), weights (null = unit) and node weights
+// (null = 1 each). gamma is the merge penalty the fold guard uses: the CPM
+// resolution, or resolution / 2m for modularity; 0 folds unconditionally.
+// Sequential and deterministic, O(n + m).
+GraphReduction reduce_graph(const int64_t* src, const int64_t* dst, size_t m, int64_t n, const double* weights,
+                            const double* node_weights, double gamma, const ReductionOptions& opt);
+
+// membership[v] for every original vertex from reduced[0..r.n): a dropped
+// group becomes community reduced_clusters, reduced_clusters + 1, ... in
+// group order. Returns the number of communities.
+int64_t expand_membership(const GraphReduction& r, const int64_t* reduced, int64_t reduced_clusters,
+                          int64_t* membership, unsigned threads = 0);
+
+// Reduces g, runs run_igraph_leiden_converging on the reduced graph and
+// expands the result into *membership (reindexed to 0..nb_clusters-1).
+// *quality is scored on g itself. Records "reduce" and "optimise" phases in
+// `report` when non-null; history and control are passed through.
+ReductionStats run_leiden_reduced(const igraph_t* g, const LeidenObjective& obj, double resolution,
+                                  const ReductionOptions& opt, igraph_vector_int_t* membership,
+                                  igraph_integer_t* nb_clusters, igraph_real_t* quality,
+                                  std::vector<IterationRecord>* history = nullptr,
+                                  const LeidenRunControl* control = nullptr, RunReport* report = nullptr);
+
+#endif // GRAPH_REDUCTION_H
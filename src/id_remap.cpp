@@ -0,0 +1,419 @@
+// Parallel node-id compaction: dense table, radix sort + unique, or concurrent hash.
+//
+// All three strategies share the same skeleton: give every distinct id a key
+// slot, record the first endpoint position at which it occurs (atomic min),
+// then rank those first positions through a bitmap over positions. The rank is
+// the id's first-appearance number, so the output does not depend on the
+// strategy or on the thread count.
+//
+// Every strategy except Sort only reads the edges until its tables are
+// complete, and then writes out[p] right after reading endpoint p, which is
+// what lets the in-place variant write the ids over the edges themselves.
+
+#include "id_remap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+#include "parallel.h"
+#include "radix_sort.h"
+
+namespace {
+
+using AtomicI64 = std::atomic<int64_t>;
+constexpr int64_t kAbsent = std::numeric_limits<int64_t>::max();
+
+// Endpoint p of the flattened edge list: u of edge p/2 for even p, v for odd p.
+inline long long endpoint(const EdgeList& edges, size_t p) {
+    return (p & 1) ? edges[p >> 1].v : edges[p >> 1].u;
+}
+
+inline uint64_t key_of(long long x, long long lo) {
+    return (uint64_t) x - (uint64_t) lo;
+}
+
+inline void atomic_min(AtomicI64& a, int64_t v) {
+    int64_t cur = a.load(std::memory_order_relaxed);
+    while (v < cur && !a.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+}
+
+std::unique_ptr<AtomicI64[]> make_first_table(size_t k, unsigned threads) {
+    std::unique_ptr<AtomicI64[]> first(new AtomicI64[k]);
+    parallel_for(k, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) first[i].store(kAbsent, std::memory_order_relaxed);
+    });
+    return first;
+}
+
+// first[k] holds the first position (< P) of key k, or kAbsent. Replaces each
+// present entry with the rank of its position among all first positions and
+// returns the number of present keys.
+int64_t rank_first_positions(AtomicI64* first, size_t K, size_t P, unsigned threads) {
+    const size_t W = (P + 63) / 64;
+    std::unique_ptr<std::atomic<uint64_t>[]> bits(new std::atomic<uint64_t>[W]);
+    parallel_for(W, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t w = b; w < e; ++w) bits[w].store(0, std::memory_order_relaxed);
+    });
+    parallel_for(K, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t k = b; k < e; ++k) {
+            int64_t f = first[k].load(std::memory_order_relaxed);
+            if (f != kAbsent) bits[f >> 6].fetch_or(uint64_t(1) << (f & 63), std::memory_order_relaxed);
+        }
+    });
+
+    // Prefix popcounts per word: block sums, then block-local scans.
+    std::vector<int64_t> base(W);
+    const unsigned T = (unsigned) std::max<size_t>(1, std::min<size_t>(threads, W));
+    std::vector<int64_t> block(T + 1, 0);
+    parallel_for(W, T, [&](size_t b, size_t e, unsigned t) {
+        int64_t c = 0;
+        for (size_t w = b; w < e; ++w) c += __builtin_popcountll(bits[w].load(std::memory_order_relaxed));
+        block[t + 1] = c;
+    });
+    for (unsigned t = 0; t < T; ++t) block[t + 1] += block[t];
+    parallel_for(W, T, [&](size_t b, size_t e, unsigned t) {
+        int64_t c = block[t];
+        for (size_t w = b; w < e; ++w) { base[w] = c; c += __builtin_popcountll(bits[w].load(std::memory_order_relaxed)); }
+    });
+
+    parallel_for(K, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t k = b; k < e; ++k) {
+            int64_t f = first[k].load(std::memory_order_relaxed);
+            if (f == kAbsent) continue;
+            uint64_t word = bits[f >> 6].load(std::memory_order_relaxed);
+            uint64_t below = word & ((uint64_t(1) << (f & 63)) - 1);
+            first[k].store(base[f >> 6] + __builtin_popcountll(below), std::memory_order_relaxed);
+        }
+    });
+    return block[T];
+}
+
+int64_t remap_dense(const EdgeList& edges, int64_t* out, std::vector<long long>* inv_map,
+                    long long lo, uint64_t span, unsigned threads) {
+    const size_t P = edges.size() * 2, K = (size_t) span + 1;
+    auto first = make_first_table(K, threads);
+    parallel_for(P, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t p = b; p < e; ++p) atomic_min(first[key_of(endpoint(edges, p), lo)], (int64_t) p);
+    });
+    const int64_t n = rank_first_positions(first.get(), K, P, threads);
+    parallel_for(P, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t p = b; p < e; ++p) out[p] = first[key_of(endpoint(edges, p), lo)].load(std::memory_order_relaxed);
+    });
+    if (inv_map) {
+        inv_map->resize((size_t) n);
+        parallel_for(K, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t k = b; k < e; ++k) {
+                int64_t id = first[k].load(std::memory_order_relaxed);
+                if (id != kAbsent) (*inv_map)[(size_t) id] = (long long) ((uint64_t) lo + k);
+            }
+        });
+    }
+    return n;
+}
+
+int64_t remap_sort(const EdgeList& edges, int64_t* out, std::vector<long long>* inv_map,
+                   long long lo, uint64_t span, unsigned threads) {
+    const size_t P = edges.size() * 2;
+    const unsigned key_bits = bit_width_u64(span);
+
+    // Sort all endpoint keys, using `out` as the sort buffer.
+    std::vector<uint64_t> uniq;
+    {
+        uint64_t* keys = reinterpret_cast<uint64_t*>(out);
+        parallel_for(P, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t p = b; p < e; ++p) keys[p] = key_of(endpoint(edges, p), lo);
+        });
+        std::vector<uint64_t, default_init_allocator<uint64_t>> tmp(P);
+        radix_sort(keys, tmp.data(), P, key_bits, [](uint64_t k) { return k; }, threads);
+
+        const unsigned T = (unsigned) std::max<size_t>(1, std::min<size_t>(threads, P));
+        std::vector<size_t> cnt(T + 1, 0);
+        parallel_for(P, T, [&](size_t b, size_t e, unsigned t) {
+            size_t c = 0;
+            for (size_t i = b; i < e; ++i) c += (i == 0 || keys[i] != keys[i - 1]);
+            cnt[t + 1] = c;
+        });
+        for (unsigned t = 0; t < T; ++t) cnt[t + 1] += cnt[t];
+        uniq.resize(cnt[T]);
+        parallel_for(P, T, [&](size_t b, size_t e, unsigned t) {
+            size_t w = cnt[t];
+            for (size_t i = b; i < e; ++i) if (i == 0 || keys[i] != keys[i - 1]) uniq[w++] = keys[i];
+        });
+    }
+    const size_t U = uniq.size();
+
+    // Bucket directory over the top bits of the key: each lookup is one
+    // directory read plus a binary search within a short run of `uniq`.
+    const unsigned dir_bits = std::min(key_bits, std::max(1u, bit_width_u64(U)));
+    const unsigned shift = key_bits - dir_bits;
+    const size_t D = size_t(1) << dir_bits;
+    std::vector<size_t> dir(D + 1);
+    auto bucket = [&](uint64_t k) { return (size_t) (k >> shift); };
+    parallel_for(U, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) {
+            size_t from = (i == 0) ? 0 : bucket(uniq[i - 1]) + 1;
+            for (size_t d = from; d <= bucket(uniq[i]); ++d) dir[d] = i;
+        }
+    });
+    for (size_t d = bucket(uniq[U - 1]) + 1; d <= D; ++d) dir[d] = U;
+
+    auto first = make_first_table(U, threads);
+    parallel_for(P, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t p = b; p < e; ++p) {
+            uint64_t k = key_of(endpoint(edges, p), lo);
+            size_t d = bucket(k);
+            size_t r = std::lower_bound(uniq.begin() + dir[d], uniq.begin() + dir[d + 1], k) - uniq.begin();
+            out[p] = (int64_t) r;
+            atomic_min(first[r], (int64_t) p);
+        }
+    });
+    const int64_t n = rank_first_positions(first.get(), U, P, threads);
+    parallel_for(P, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t p = b; p < e; ++p) out[p] = first[(size_t) out[p]].load(std::memory_order_relaxed);
+    });
+    if (inv_map) {
+        inv_map->resize((size_t) n);
+        parallel_for(U, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t r = b; r < e; ++r)
+                (*inv_map)[(size_t) first[r].load(std::memory_order_relaxed)] = (long long) ((uint64_t) lo + uniq[r]);
+        });
+    }
+    return n;
+}
+
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// HyperLogLog estimate (2^14 registers, ~1% error) of the number of distinct
+// ids, so the hash table is sized by what the input holds rather than by its
+// endpoint count.
+double estimate_distinct(const EdgeList& edges, long long lo, unsigned threads) {
+    constexpr unsigned kBits = 14;
+    constexpr size_t kRegs = size_t(1) << kBits;
+    const size_t P = edges.size() * 2;
+    std::vector<std::vector<uint8_t>> regs(threads);
+    parallel_for(P, threads, [&](size_t b, size_t e, unsigned t) {
+        std::vector<uint8_t>& r = regs[t];
+        r.assign(kRegs, 0);
+        for (size_t p = b; p < e; ++p) {
+            const uint64_t h = mix64(key_of(endpoint(edges, p), lo));
+            const uint64_t rest = h << kBits;
+            const uint8_t rank = rest ? (uint8_t) (__builtin_clzll(rest) + 1) : (uint8_t) (64 - kBits + 1);
+            uint8_t& slot = r[h >> (64 - kBits)];
+            if (rank > slot) slot = rank;
+        }
+    });
+    std::vector<uint8_t> merged(kRegs, 0);
+    for (const auto& r : regs)
+        for (size_t j = 0; j < r.size(); ++j) merged[j] = std::max(merged[j], r[j]);
+
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (uint8_t m : merged) { sum += std::ldexp(1.0, -(int) m); zeros += (m == 0); }
+    const double regs_d = (double) kRegs;
+    const double estimate = 0.7213 / (1.0 + 1.079 / regs_d) * regs_d * regs_d / sum;
+    if (estimate <= 2.5 * regs_d && zeros > 0) return regs_d * std::log(regs_d / (double) zeros);
+    return estimate;
+}
+
+int64_t remap_hash(const EdgeList& edges, int64_t* out, std::vector<long long>* inv_map,
+                   long long lo, uint64_t span, unsigned threads) {
+    constexpr uint64_t kEmpty = std::numeric_limits<uint64_t>::max();
+    constexpr size_t kFlush = 256;   // inserts a thread counts before publishing them
+    if (span == kEmpty) throw std::runtime_error("Hash remap cannot represent the full 64-bit id range");
+    const size_t P = edges.size() * 2;
+    const size_t distinct_max = (size_t) std::min<uint64_t>(span + 1, P);
+    size_t cap_max = 16;
+    while (cap_max < 2 * distinct_max) cap_max <<= 1;
+
+    // Start from the estimate (plus slack for the lag in the fill count); a
+    // table that still fills past 3/4 is rebuilt at twice the size. At
+    // cap_max the table cannot overflow and the check is skipped.
+    const double estimate = estimate_distinct(edges, lo, threads);
+    const size_t target = std::min(distinct_max, (size_t) (1.25 * estimate) + 4 * kFlush * threads);
+    size_t cap = 16;
+    while (cap < 2 * target) cap <<= 1;
+    cap = std::min(cap, cap_max);
+
+    std::unique_ptr<std::atomic<uint64_t>[]> keys;
+    std::unique_ptr<AtomicI64[]> first;
+    for (;;) {
+        const size_t mask = cap - 1;
+        keys.reset();
+        first.reset();
+        keys.reset(new std::atomic<uint64_t>[cap]);
+        parallel_for(cap, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t s = b; s < e; ++s) keys[s].store(kEmpty, std::memory_order_relaxed);
+        });
+        first = make_first_table(cap, threads);
+
+        const bool guarded = cap < cap_max;
+        const size_t limit = cap - cap / 4;
+        std::atomic<size_t> filled{0};
+        std::atomic<bool> overflow{false};
+        parallel_for(P, threads, [&](size_t b, size_t e, unsigned) {
+            size_t local = 0;
+            for (size_t p = b; p < e; ++p) {
+                const uint64_t k = key_of(endpoint(edges, p), lo);
+                size_t s = mix64(k) & mask;
+                for (;;) {
+                    uint64_t cur = keys[s].load(std::memory_order_acquire);
+                    if (cur == k) break;
+                    if (cur == kEmpty) {
+                        if (keys[s].compare_exchange_strong(cur, k, std::memory_order_acq_rel)) { ++local; break; }
+                        if (cur == k) break;
+                    }
+                    s = (s + 1) & mask;
+                }
+                atomic_min(first[s], (int64_t) p);
+                if (guarded && local == kFlush) {
+                    if (filled.fetch_add(local, std::memory_order_relaxed) + local > limit)
+                        overflow.store(true, std::memory_order_relaxed);
+                    local = 0;
+                    if (overflow.load(std::memory_order_relaxed)) return;
+                }
+            }
+        });
+        if (!overflow.load()) break;
+        cap <<= 1;
+    }
+
+    const size_t mask = cap - 1;
+    auto slot_of = [&](uint64_t k) {
+        size_t s = mix64(k) & mask;
+        while (keys[s].load(std::memory_order_relaxed) != k) s = (s + 1) & mask;
+        return s;
+    };
+    const int64_t n = rank_first_positions(first.get(), cap, P, threads);
+    parallel_for(P, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t p = b; p < e; ++p)
+            out[p] = first[slot_of(key_of(endpoint(edges, p), lo))].load(std::memory_order_relaxed);
+    });
+    if (inv_map) {
+        inv_map->resize((size_t) n);
+        parallel_for(cap, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t s = b; s < e; ++s) {
+                int64_t id = first[s].load(std::memory_order_relaxed);
+                if (id != kAbsent) (*inv_map)[(size_t) id] = (long long) ((uint64_t) lo + keys[s].load(std::memory_order_relaxed));
+            }
+        });
+    }
+    return n;
+}
+
+void id_range(const EdgeList& edges, unsigned threads, long long& lo, long long& hi) {
+    std::vector<long long> los(threads, std::numeric_limits<long long>::max());
+    std::vector<long long> his(threads, std::numeric_limits<long long>::min());
+    parallel_for(edges.size(), threads, [&](size_t b, size_t e, unsigned t) {
+        long long l = los[t], h = his[t];
+        for (size_t i = b; i < e; ++i) {
+            l = std::min({l, edges[i].u, edges[i].v});
+            h = std::max({h, edges[i].u, edges[i].v});
+        }
+        los[t] = l; his[t] = h;
+    });
+    lo = *std::min_element(los.begin(), los.end());
+    hi = *std::max_element(his.begin(), his.end());
+}
+
+} // namespace
+
+RemapStrategy parse_remap_strategy(const std::string& name) {
+    if (name == "auto") return RemapStrategy::Auto;
+    if (name == "dense") return RemapStrategy::Dense;
+    if (name == "sort") return RemapStrategy::Sort;
+    if (name == "hash") return RemapStrategy::Hash;
+    throw std::invalid_argument("Unknown remap strategy: " + name);
+}
+
+const char* remap_strategy_name(RemapStrategy s) {
+    switch (s) {
+        case RemapStrategy::Auto:  return "auto";
+        case RemapStrategy::Dense: return "dense";
+        case RemapStrategy::Sort:  return "sort";
+        case RemapStrategy::Hash:  return "hash";
+    }
+    return "?";
+}
+
+int64_t remap_edge_ids(const EdgeList& edges, int64_t* out, std::vector<long long>* inv_map,
+                       RemapStrategy strategy, unsigned threads, RemapStrategy* used) {
+    if (inv_map) inv_map->clear();
+    if (edges.empty()) { if (used) *used = strategy; return 0; }
+    threads = resolve_threads(threads);
+
+    long long lo, hi;
+    id_range(edges, threads, lo, hi);
+    const uint64_t span = (uint64_t) hi - (uint64_t) lo;   // id range minus one
+    const uint64_t endpoints = (uint64_t) edges.size() * 2;
+
+    if (strategy == RemapStrategy::Auto) {
+        // A dense table costs 8 bytes per id in the range; take it while that
+        // stays within ~2x of what the sort path would allocate.
+        strategy = (span < 2 * endpoints) ? RemapStrategy::Dense : RemapStrategy::Sort;
+    }
+    if (strategy == RemapStrategy::Dense && span >= (uint64_t(1) << 40))
+        throw std::runtime_error("Id range too large for dense remap");
+
+    if (strategy == RemapStrategy::Sort) {
+        try {
+            if (used) *used = strategy;
+            return remap_sort(edges, out, inv_map, lo, span, threads);
+        } catch (const std::bad_alloc&) {
+            std::cerr << "Warning: out of memory in sort remap; falling back to hash remap\n";
+            strategy = RemapStrategy::Hash;
+        }
+    }
+    if (used) *used = strategy;
+    if (strategy == RemapStrategy::Dense) return remap_dense(edges, out, inv_map, lo, span, threads);
+    return remap_hash(edges, out, inv_map, lo, span, threads);
+}
+
+int64_t remap_edge_ids_in_place(EdgeList& edges, std::vector<long long>* inv_map, RemapStrategy strategy,
+                                unsigned threads, RemapStrategy* used) {
+    if (inv_map) inv_map->clear();
+    if (edges.empty()) { if (used) *used = strategy; return 0; }
+    threads = resolve_threads(threads);
+
+    long long lo, hi;
+    id_range(edges, threads, lo, hi);
+    const uint64_t span = (uint64_t) hi - (uint64_t) lo;
+    const uint64_t endpoints = (uint64_t) edges.size() * 2;
+
+    if (strategy == RemapStrategy::Sort) {
+        std::cerr << "Note: sort remap needs a second endpoint buffer; using hash remap in place\n";
+        strategy = RemapStrategy::Hash;
+    }
+    if (strategy == RemapStrategy::Auto)
+        strategy = (span < endpoints / 2) ? RemapStrategy::Dense : RemapStrategy::Hash;
+    if (strategy == RemapStrategy::Dense && span >= (uint64_t(1) << 40))
+        throw std::runtime_error("Id range too large for dense remap");
+
+    if (used) *used = strategy;
+    int64_t* out = edge_id_array(edges);
+    if (strategy == RemapStrategy::Dense) return remap_dense(edges, out, inv_map, lo, span, threads);
+    return remap_hash(edges, out, inv_map, lo, span, threads);
+}
+
+int64_t identity_edge_ids(const EdgeList& edges, int64_t* out, unsigned threads) {
+    if (edges.empty()) return 0;
+    threads = resolve_threads(threads);
+    long long lo, hi;
+    id_range(edges, threads, lo, hi);
+    if (lo < 0) throw std::runtime_error("--assume-dense-ids requires non-negative node ids");
+    if (out == reinterpret_cast<const int64_t*>(edges.data())) return (int64_t) hi + 1;
+    const size_t P = edges.size() * 2;
+    parallel_for(P, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t p = b; p < e; ++p) out[p] = endpoint(edges, p);
+    });
+    return (int64_t) hi + 1;
+}
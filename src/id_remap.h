@@ -0,0 +1,50 @@
+#ifndef ID_REMAP_H
+#define ID_REMAP_H
+
+// Compaction of arbitrary 64-bit node ids to 0..N-1.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "edge_io.h"
+
+enum class RemapStrategy {
+    Auto,   // Dense when the id range is small relative to the edge count, else Sort
+    Dense,  // direct-indexed table over [min_id, max_id]
+    Sort,   // parallel radix sort + unique, bucketed rank lookup
+    Hash,   // concurrent open-addressing table
+};
+
+RemapStrategy parse_remap_strategy(const std::string& name);
+const char* remap_strategy_name(RemapStrategy s);
+
+// Maps every endpoint of `edges` to 0..N-1 and writes out[2*i] / out[2*i+1].
+// Ids are assigned in first-appearance order (u then v of each edge, in file
+// order), the same numbering the old unordered_map interning produced.
+// inv_map (optional) receives the original id of each new id. Returns N.
+int64_t remap_edge_ids(const EdgeList& edges, int64_t* out, std::vector<long long>* inv_map,
+                       RemapStrategy strategy = RemapStrategy::Auto, unsigned threads = 0,
+                       RemapStrategy* used = nullptr);
+
+// An Edge has the layout of two int64_t, so a remapped array (out[2*i],
+// out[2*i+1]) can live in the edge list's own storage.
+static_assert(sizeof(Edge) == 2 * sizeof(int64_t) && offsetof(Edge, v) == sizeof(int64_t),
+              "Edge must be two packed 64-bit ids");
+inline int64_t* edge_id_array(EdgeList& edges) { return reinterpret_cast<int64_t*>(edges.data()); }
+
+// --low-memory: remap_edge_ids writing over `edges` itself (read the result
+// through edge_id_array), so no second endpoint array is allocated. Same
+// numbering as remap_edge_ids. Sort needs an endpoint-sized scratch buffer
+// and is replaced by Hash; Auto takes Dense only while its table stays below
+// 4 bytes per endpoint, else Hash.
+int64_t remap_edge_ids_in_place(EdgeList& edges, std::vector<long long>* inv_map,
+                                RemapStrategy strategy = RemapStrategy::Auto, unsigned threads = 0,
+                                RemapStrategy* used = nullptr);
+
+// --assume-dense-ids: ids are used as-is (they must be >= 0); returns max id + 1.
+// `out` may be edge_id_array(edges), in which case nothing is copied.
+int64_t identity_edge_ids(const EdgeList& edges, int64_t* out, unsigned threads = 0);
+
+#endif // ID_REMAP_H
@@ -0,0 +1,165 @@
+// igraph_community_leiden helpers for leiden_igraph.
+
+#include "igraph_backend.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "parallel.h"
+
+// Read-only igraph view of obj.edge_weights, or nullptr when unweighted.
+static const igraph_vector_t* edge_weight_view(const LeidenObjective& obj, igraph_vector_t* view) {
+    if (obj.edge_weights.empty()) return nullptr;
+    return igraph_vector_view(view, obj.edge_weights.data(), (igraph_integer_t) obj.edge_weights.size());
+}
+
+LeidenObjective make_objective(const igraph_t* g, bool modularity, std::vector<double> edge_weights) {
+    LeidenObjective obj;
+    obj.modularity = modularity;
+    if (!edge_weights.empty() && (igraph_integer_t) edge_weights.size() != igraph_ecount(g))
+        throw std::invalid_argument("make_objective: edge weight count does not match the graph");
+    obj.edge_weights = std::move(edge_weights);
+    if (!modularity) return obj;
+
+    igraph_vector_t strength, wview;
+    if (igraph_vector_init(&strength, 0)) throw std::runtime_error("igraph_vector_init failed");
+    igraph_error_t err = igraph_strength(g, &strength, igraph_vss_all(), IGRAPH_ALL, IGRAPH_LOOPS,
+                                         edge_weight_view(obj, &wview));
+    if (err) { igraph_vector_destroy(&strength); throw std::runtime_error("igraph_strength failed"); }
+    const igraph_integer_t n = igraph_vector_size(&strength);
+    obj.node_weights.assign(VECTOR(strength), VECTOR(strength) + n);
+    igraph_vector_destroy(&strength);
+    for (double w : obj.node_weights) obj.two_m += w;
+    return obj;
+}
+
+void run_igraph_leiden(const igraph_t* g, const LeidenObjective& obj, double resolution,
+                       double beta, bool start, igraph_integer_t n_iterations,
+                       igraph_vector_int_t* membership, igraph_integer_t* nb_clusters,
+                       igraph_real_t* quality) {
+    igraph_vector_t node_weights, edge_weights;
+    const igraph_vector_t* nw = nullptr;
+    double gamma = resolution;
+    if (!obj.node_weights.empty())
+        nw = igraph_vector_view(&node_weights, obj.node_weights.data(), (igraph_integer_t) obj.node_weights.size());
+    if (obj.modularity && obj.two_m > 0) gamma = resolution / obj.two_m;
+
+    // igraph 0.10.x API:
+    // igraph_community_leiden(graph, edge_weights, node_weights, resolution, beta,
+    //                         start, n_iterations, membership, nb_clusters, quality)
+    igraph_error_t err = igraph_community_leiden(
+         g,
+         /*edge_weights*/ edge_weight_view(obj, &edge_weights),
+         /*node_weights*/ nw,
+         /*resolution*/   gamma,
+         /*beta*/         beta,
+         /*start*/        start,
+         /*n_iterations*/ n_iterations,
+         /*membership*/   membership,
+         /*nb_clusters*/  nb_clusters,
+         /*quality*/      quality);
+    if (err) throw std::runtime_error("igraph_community_leiden failed");
+
+    // Normalize to 0..C-1 (callers output 1-indexed)
+    err = igraph_reindex_membership(membership, /*new_to_old=*/nullptr, nb_clusters);
+    if (err) throw std::runtime_error("igraph_reindex_membership failed");
+}
+
+uint64_t iteration_seed(uint64_t seed, int iteration) {
+    // splitmix64 of the pair, as native_leiden derives its per-level seeds.
+    uint64_t x = seed ^ ((uint64_t) iteration * 0x9E3779B97F4A7C15ull);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+StopReason run_igraph_leiden_converging(const igraph_t* g, const LeidenObjective& obj, double resolution,
+                                        double beta, bool start, const ConvergenceOptions& conv,
+                                        igraph_vector_int_t* membership, igraph_integer_t* nb_clusters,
+                                        igraph_real_t* quality, std::vector<IterationRecord>* history,
+                                        const LeidenRunControl* control) {
+    const igraph_integer_t n = igraph_vcount(g);
+    const bool resuming = control && !control->resume.empty();
+    if (resuming) start = true;
+    std::vector<igraph_integer_t> before((size_t) n);
+    if (start) std::copy(VECTOR(*membership), VECTOR(*membership) + n, before.begin());
+    else std::iota(before.begin(), before.end(), (igraph_integer_t) 0);
+
+    ConvergenceTracker tracker(conv, n);
+    if (resuming) tracker.resume(control->resume);
+    for (;;) {
+        if (control && control->seeded)
+            igraph_rng_seed(igraph_rng_default(), iteration_seed(control->seed, tracker.iterations() + 1));
+        run_igraph_leiden(g, obj, resolution, beta, start, /*n_iterations=*/1, membership, nb_clusters, quality);
+        start = true;
+        if (!tracker.record(*quality, count_moved(before.data(), VECTOR(*membership), (size_t) n))) break;
+        std::copy(VECTOR(*membership), VECTOR(*membership) + n, before.begin());
+        if (control && control->checkpoint) control->checkpoint(membership, tracker.history());
+    }
+    if (tracker.reverted()) {
+        std::copy(before.begin(), before.end(), VECTOR(*membership));
+        if (igraph_reindex_membership(membership, /*new_to_old=*/nullptr, nb_clusters))
+            throw std::runtime_error("igraph_reindex_membership failed");
+        *quality = tracker.best_quality();
+    }
+    if (history) *history = tracker.history();
+    return tracker.reason();
+}
+
+double partition_quality(const igraph_t* g, const LeidenObjective& obj, double resolution,
+                         const igraph_vector_int_t* membership, unsigned threads) {
+    const igraph_integer_t n = igraph_vcount(g), m = igraph_ecount(g);
+    if (m == 0) return 0.0;
+    const igraph_integer_t* memb = VECTOR(*membership);
+    const double* ew = obj.edge_weights.empty() ? nullptr : obj.edge_weights.data();
+
+    threads = resolve_threads(threads);
+    std::vector<double> internal(threads, 0.0), total(threads, 0.0);
+    parallel_for((size_t) m, threads, [&](size_t b, size_t e, unsigned t) {
+        double w = 0.0, all = 0.0;
+        for (size_t eid = b; eid < e; ++eid) {
+            const double we = ew ? ew[eid] : 1.0;
+            all += we;
+            if (memb[IGRAPH_FROM(g, eid)] == memb[IGRAPH_TO(g, eid)]) w += 2.0 * we;
+        }
+        internal[t] = w;
+        total[t] = all;
+    });
+
+    igraph_integer_t c_max = 0;
+    for (igraph_integer_t i = 0; i < n; ++i) c_max = std::max(c_max, memb[i]);
+    std::vector<double> cluster_weight((size_t) c_max + 1, 0.0);
+    for (igraph_integer_t i = 0; i < n; ++i)
+        cluster_weight[(size_t) memb[i]] += obj.node_weights.empty() ? 1.0 : obj.node_weights[(size_t) i];
+
+    double q = 0.0, total_weight = 0.0;
+    for (double w : internal) q += w;
+    for (double w : total) total_weight += w;
+    const double gamma = (obj.modularity && obj.two_m > 0) ? resolution / obj.two_m : resolution;
+    for (double w : cluster_weight) q -= gamma * w * w;
+    return q / (2.0 * total_weight);
+}
+
+void edge_endpoints(const igraph_t* g, std::vector<int64_t>& src, std::vector<int64_t>& dst,
+                    unsigned threads) {
+    const size_t m = (size_t) igraph_ecount(g);
+    src.resize(m);
+    dst.resize(m);
+    parallel_for(m, resolve_threads(threads), [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) {
+            const igraph_integer_t from = IGRAPH_FROM(g, (igraph_integer_t) i);
+            const igraph_integer_t to = IGRAPH_TO(g, (igraph_integer_t) i);
+            src[i] = (int64_t) from;
+            dst[i] = (int64_t) to;
+        }
+    });
+}
+
+void prime_graph_cache(const igraph_t* g) {
+    igraph_bool_t flag;
+    igraph_has_loop(g, &flag);
+    igraph_has_multiple(g, &flag);
+    igraph_is_simple(g, &flag);
+}
@@ -0,0 +1,81 @@
+#ifndef IGRAPH_BACKEND_H
+#define IGRAPH_BACKEND_H
+
+// igraph_community_leiden setup shared by the leiden_igraph run modes.
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include <igraph/igraph.h>
+
+#include "convergence.h"
+
+// Objective-specific inputs, computed once per graph and then shared
+// read-only by any number of concurrent runs.
+//
+// igraph_community_leiden optimises CPM; modularity is obtained by passing
+// vertex strengths as node weights and scaling the resolution by 1/(2m).
+struct LeidenObjective {
+    bool modularity = false;
+    std::vector<double> edge_weights;  // one per igraph edge, empty for unit weights
+    std::vector<double> node_weights;  // strengths for modularity; for CPM empty (1 per vertex) or vertex sizes
+    double two_m = 0.0;                // sum of strengths (2 * total edge weight)
+};
+
+// Takes ownership of edge_weights (empty = unweighted).
+LeidenObjective make_objective(const igraph_t* g, bool modularity, std::vector<double> edge_weights = {});
+
+// Runs igraph_community_leiden. With start == true, *membership is used as the
+// initial partition (warm start); otherwise it is overwritten. On return the
+// membership is reindexed to 0..nb_clusters-1. Throws on igraph errors.
+void run_igraph_leiden(const igraph_t* g, const LeidenObjective& obj, double resolution,
+                       double beta, bool start, igraph_integer_t n_iterations,
+                       igraph_vector_int_t* membership, igraph_integer_t* nb_clusters,
+                       igraph_real_t* quality);
+
+// Seeding and checkpointing for run_igraph_leiden_converging.
+struct LeidenRunControl {
+    // Reseed igraph's default RNG before every iteration from (seed,
+    // iteration), so a run restarted at any iteration draws the same numbers
+    // as one that never stopped.
+    bool seeded = false;
+    uint64_t seed = 0;
+    // Iterations already done, from a checkpoint; *membership then holds the
+    // partition after the last of them and the run continues from there.
+    std::vector<IterationRecord> resume;
+    // Called after every iteration that another one will follow, with the
+    // partition so far and the records of all iterations up to it.
+    std::function<void(const igraph_vector_int_t* membership, const std::vector<IterationRecord>& history)>
+        checkpoint;
+};
+
+// The RNG seed of 1-based iteration `iteration` of a run seeded with `seed`.
+uint64_t iteration_seed(uint64_t seed, int iteration);
+
+// run_igraph_leiden one iteration at a time (each continuing from the last,
+// which is what n_iterations > 1 does inside igraph) until `conv` says stop.
+// Leaves the best partition seen in *membership, reindexed to
+// 0..nb_clusters-1; history (optional) receives one record per iteration.
+StopReason run_igraph_leiden_converging(const igraph_t* g, const LeidenObjective& obj, double resolution,
+                                        double beta, bool start, const ConvergenceOptions& conv,
+                                        igraph_vector_int_t* membership, igraph_integer_t* nb_clusters,
+                                        igraph_real_t* quality, std::vector<IterationRecord>* history = nullptr,
+                                        const LeidenRunControl* control = nullptr);
+
+// Quality of `membership` in igraph_community_leiden's convention:
+//   (2 * internal edge weight - gamma * sum_c W_c^2) / (2 * total edge weight)
+// where W_c sums the node weights of cluster c (1 per vertex when there are none).
+double partition_quality(const igraph_t* g, const LeidenObjective& obj, double resolution,
+                         const igraph_vector_int_t* membership, unsigned threads = 0);
+
+// Copies the endpoints of every edge, in edge order, into src and dst for
+// the stages that take plain int64 edge arrays (CSR build, reduction).
+void edge_endpoints(const igraph_t* g, std::vector<int64_t>& src, std::vector<int64_t>& dst,
+                    unsigned threads = 0);
+
+// Fills igraph's lazily computed graph-property cache so that concurrent
+// read-only calls on the same graph do not race to write it.
+void prime_graph_cache(const igraph_t* g);
+
+#endif // IGRAPH_BACKEND_H
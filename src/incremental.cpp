@@ -0,0 +1,357 @@
+// Incremental re-clustering: edge deltas, previous memberships and the
+// local-then-global re-optimisation.
+
+#include "incremental.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "edge_merge.h"
+#include "parallel.h"
+#include "radix_sort.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Original id -> vertex lookup: the identity when inv_map is empty, else a
+// binary search over the vertices sorted by original id.
+class IdIndex {
+public:
+    IdIndex(const std::vector<long long>& inv_map, int64_t n, unsigned threads)
+        : n_(n), dense_(inv_map.empty()) {
+        if (dense_ || n == 0) return;
+        min_id_ = *std::min_element(inv_map.begin(), inv_map.begin() + n);
+        const long long max_id = *std::max_element(inv_map.begin(), inv_map.begin() + n);
+        recs_.resize((size_t) n);
+        parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t i = b; i < e; ++i) recs_[i] = Keyed{(uint64_t) inv_map[i] - (uint64_t) min_id_, (int64_t) i};
+        });
+        std::vector<Keyed, default_init_allocator<Keyed>> tmp((size_t) n);
+        radix_sort(recs_.data(), tmp.data(), (size_t) n, bit_width_u64((uint64_t) max_id - (uint64_t) min_id_),
+                   [](const Keyed& r) { return r.key; }, threads);
+    }
+
+    // Vertex of `id`, or -1 when it is not in the graph.
+    int64_t find(long long id) const {
+        if (dense_) return id >= 0 && id < n_ ? (int64_t) id : -1;
+        const uint64_t key = (uint64_t) id - (uint64_t) min_id_;  // ids below the minimum wrap past every key
+        auto it = std::lower_bound(recs_.begin(), recs_.end(), key,
+                                   [](const Keyed& r, uint64_t k) { return r.key < k; });
+        return it != recs_.end() && it->key == key ? it->v : -1;
+    }
+
+private:
+    struct Keyed { uint64_t key; int64_t v; };
+
+    int64_t n_;
+    bool dense_;
+    long long min_id_ = 0;
+    std::vector<Keyed, default_init_allocator<Keyed>> recs_;
+};
+
+double seconds_since(Clock::time_point t) {
+    return std::chrono::duration<double>(Clock::now() - t).count();
+}
+
+} // namespace
+
+DeltaStats apply_edge_delta(igraph_t* g, std::vector<double>& weights, std::vector<long long>& inv_map,
+                            const EdgeDelta& delta, std::vector<int64_t>* touched, unsigned threads) {
+    threads = resolve_threads(threads);
+    const bool directed = igraph_is_directed(g);
+    const int64_t n0 = igraph_vcount(g);
+    const size_t m0 = (size_t) igraph_ecount(g);
+    if (!delta.added_weights.empty() && delta.added_weights.size() != delta.added.size())
+        throw std::invalid_argument("apply_edge_delta: added weight count does not match the added edges");
+    if (!weights.empty() && weights.size() != m0)
+        throw std::invalid_argument("apply_edge_delta: edge weight count does not match the graph");
+    const bool weighted = !weights.empty() || !delta.added_weights.empty();
+    const IdIndex index(inv_map, n0, threads);
+    DeltaStats st;
+
+    // Removals: distinct canonical (u, v) pairs, each with how many copies to take out.
+    std::vector<std::pair<int64_t, int64_t>> pairs;
+    pairs.reserve(delta.removed.size());
+    for (const Edge& e : delta.removed) {
+        int64_t u = index.find(e.u), v = index.find(e.v);
+        if (u < 0 || v < 0) { ++st.missing_removals; continue; }
+        if (!directed && u > v) std::swap(u, v);
+        pairs.emplace_back(u, v);
+    }
+    std::sort(pairs.begin(), pairs.end());
+    std::vector<std::pair<int64_t, int64_t>> keys;
+    std::vector<int64_t> copies;
+    for (const auto& p : pairs) {
+        if (keys.empty() || keys.back() != p) { keys.push_back(p); copies.push_back(0); }
+        ++copies.back();
+    }
+
+    // Graph edges matching a removal key, per contiguous block and so in edge order.
+    std::vector<std::vector<std::pair<size_t, size_t>>> hits(threads);
+    if (!keys.empty()) {
+        parallel_for(m0, threads, [&](size_t b, size_t e, unsigned t) {
+            for (size_t eid = b; eid < e; ++eid) {
+                int64_t u = IGRAPH_FROM(g, eid), v = IGRAPH_TO(g, eid);
+                if (!directed && u > v) std::swap(u, v);
+                auto it = std::lower_bound(keys.begin(), keys.end(), std::make_pair(u, v));
+                if (it != keys.end() && *it == std::make_pair(u, v)) hits[t].emplace_back(eid, (size_t) (it - keys.begin()));
+            }
+        });
+    }
+    std::vector<size_t> deleted;  // ascending
+    for (const auto& block : hits) {
+        for (const auto& h : block) {
+            if (copies[h.second] == 0) continue;
+            --copies[h.second];
+            deleted.push_back(h.first);
+            if (touched) {
+                touched->push_back(IGRAPH_FROM(g, h.first));
+                touched->push_back(IGRAPH_TO(g, h.first));
+            }
+        }
+    }
+    for (int64_t c : copies) st.missing_removals += c;
+    st.removed_edges = (int64_t) deleted.size();
+
+    // Additions: ids not in the graph become new vertices.
+    int64_t n = n0;
+    std::unordered_map<long long, int64_t> fresh;
+    auto vertex_of = [&](long long id) -> int64_t {
+        const int64_t v = index.find(id);
+        if (v >= 0) return v;
+        if (inv_map.empty() && n0 > 0) {
+            if (id < 0) throw std::invalid_argument("Negative node id in added edges: " + std::to_string(id));
+            n = std::max<int64_t>(n, (int64_t) id + 1);
+            return (int64_t) id;
+        }
+        auto ins = fresh.emplace(id, n);
+        if (ins.second) { inv_map.push_back(id); ++n; }
+        return ins.first->second;
+    };
+
+    const size_t m_added = delta.added.size();
+    const size_t m1 = m0 - deleted.size() + m_added;
+    std::vector<igraph_integer_t, default_init_allocator<igraph_integer_t>> es(2 * m1);
+    std::vector<double> new_weights(weighted ? m1 : 0);
+    parallel_for(m0, threads, [&](size_t b, size_t e, unsigned) {
+        size_t d = (size_t) (std::lower_bound(deleted.begin(), deleted.end(), b) - deleted.begin());
+        size_t out = b - d;
+        for (size_t eid = b; eid < e; ++eid) {
+            if (d < deleted.size() && deleted[d] == eid) { ++d; continue; }
+            es[2 * out] = IGRAPH_FROM(g, eid);
+            es[2 * out + 1] = IGRAPH_TO(g, eid);
+            if (weighted) new_weights[out] = weights.empty() ? 1.0 : weights[eid];
+            ++out;
+        }
+    });
+    const size_t base = m0 - deleted.size();
+    for (size_t i = 0; i < m_added; ++i) {
+        const int64_t u = vertex_of(delta.added[i].u), v = vertex_of(delta.added[i].v);
+        es[2 * (base + i)] = u;
+        es[2 * (base + i) + 1] = v;
+        if (weighted) new_weights[base + i] = delta.added_weights.empty() ? 1.0 : delta.added_weights[i];
+        if (touched) { touched->push_back(u); touched->push_back(v); }
+    }
+    st.added_edges = (int64_t) m_added;
+    st.new_vertices = n - n0;
+
+    igraph_destroy(g);
+    igraph_vector_int_t edges_vec;
+    igraph_vector_int_view(&edges_vec, es.data(), (igraph_integer_t) es.size());
+    if (igraph_create(g, &edges_vec, (igraph_integer_t) n, directed))
+        throw std::runtime_error("igraph_create failed");
+    weights = std::move(new_weights);
+
+    std::cerr << "Applied delta: +" << st.added_edges << " / -" << st.removed_edges << " edges, "
+              << st.new_vertices << " new vertices\n";
+    if (st.missing_removals)
+        std::cerr << "Warning: " << st.missing_removals << " removed edges were not in the graph\n";
+    return st;
+}
+
+std::vector<igraph_integer_t> read_previous_membership(const std::filesystem::path& path,
+                                                       const std::vector<long long>& inv_map,
+                                                       igraph_integer_t n, unsigned threads,
+                                                       int64_t* unknown) {
+    const EdgeList rows = has_ext(path, {".parquet"}) ? read_parquet_edges(path, threads)
+                                                      : read_tsv_edges(path, threads);
+    const IdIndex index(inv_map, n, threads);
+
+    // Raw community per vertex (last row wins), then renumbered densely.
+    std::vector<long long> raw((size_t) n);
+    std::vector<char> seen((size_t) n, 0);
+    int64_t skipped = 0;
+    for (const Edge& r : rows) {
+        const int64_t v = index.find(r.u);
+        if (v < 0) { ++skipped; continue; }
+        raw[(size_t) v] = r.v;
+        seen[(size_t) v] = 1;
+    }
+    std::vector<long long> ids;
+    for (igraph_integer_t v = 0; v < n; ++v) if (seen[(size_t) v]) ids.push_back(raw[(size_t) v]);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::vector<igraph_integer_t> labels((size_t) n);
+    igraph_integer_t next = (igraph_integer_t) ids.size();
+    int64_t singletons = 0;
+    for (igraph_integer_t v = 0; v < n; ++v) {
+        if (seen[(size_t) v]) {
+            labels[(size_t) v] = (igraph_integer_t) (std::lower_bound(ids.begin(), ids.end(), raw[(size_t) v]) - ids.begin());
+        } else {
+            labels[(size_t) v] = next++;
+            ++singletons;
+        }
+    }
+    std::cerr << "Previous membership: " << ids.size() << " communities";
+    if (singletons) std::cerr << ", " << singletons << " unlisted vertices as singletons";
+    if (skipped) std::cerr << ", " << skipped << " rows for unknown ids skipped";
+    std::cerr << "\n";
+    if (unknown) *unknown = skipped;
+    return labels;
+}
+
+IncrementalResult recluster_incremental(const igraph_t* g, const LeidenObjective& obj,
+                                        const std::vector<int64_t>& touched, const IncrementalOptions& opt,
+                                        igraph_vector_int_t* membership, igraph_integer_t* nb_clusters,
+                                        igraph_real_t* quality, RunReport* report) {
+    const unsigned threads = resolve_threads(opt.threads);
+    const igraph_integer_t n = igraph_vcount(g);
+    const size_t m = (size_t) igraph_ecount(g);
+    igraph_integer_t* memb = VECTOR(*membership);
+    IncrementalResult res;
+
+    RunReport::Phase local_phase(report, "local");
+    local_phase.add_edges(m);
+    const Clock::time_point t_local = Clock::now();
+
+    // Affected set: changed-edge endpoints, grown breadth-first by opt.hops.
+    std::vector<char> affected((size_t) n, 0);
+    std::vector<int64_t> frontier, next;
+    for (int64_t v : touched) {
+        if (affected[(size_t) v]) continue;
+        affected[(size_t) v] = 1;
+        frontier.push_back(v);
+    }
+    igraph_vector_int_t neis;
+    if (igraph_vector_int_init(&neis, 0)) throw std::runtime_error("igraph_vector_int_init failed");
+    for (int hop = 0; hop < opt.hops && !frontier.empty(); ++hop) {
+        next.clear();
+        for (int64_t v : frontier) {
+            if (igraph_neighbors(g, &neis, (igraph_integer_t) v, IGRAPH_ALL)) {
+                igraph_vector_int_destroy(&neis);
+                throw std::runtime_error("igraph_neighbors failed");
+            }
+            for (igraph_integer_t i = 0; i < igraph_vector_int_size(&neis); ++i) {
+                const igraph_integer_t u = VECTOR(neis)[i];
+                if (affected[(size_t) u]) continue;
+                affected[(size_t) u] = 1;
+                next.push_back(u);
+            }
+        }
+        frontier.swap(next);
+    }
+    igraph_vector_int_destroy(&neis);
+
+    // Contracted graph: affected vertices first, one node each, then one node
+    // per previous community of the rest. Merged edges keep the total weight
+    // and internal edges become self-loops, so qualities carry over unchanged.
+    std::vector<int64_t> node((size_t) n);
+    int64_t k = 0;
+    for (igraph_integer_t v = 0; v < n; ++v) if (affected[(size_t) v]) node[(size_t) v] = k++;
+    res.affected_vertices = k;
+    std::vector<int64_t> super((size_t) n, -1);
+    for (igraph_integer_t v = 0; v < n; ++v) {
+        if (affected[(size_t) v]) continue;
+        int64_t& s = super[(size_t) memb[v]];
+        if (s < 0) s = k++;
+        node[(size_t) v] = s;
+    }
+
+    std::vector<int64_t, default_init_allocator<int64_t>> es(2 * m);
+    LeidenObjective local;
+    local.modularity = obj.modularity;
+    local.two_m = obj.two_m;
+    local.edge_weights.resize(m);
+    parallel_for(m, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t eid = b; eid < e; ++eid) {
+            es[2 * eid] = node[(size_t) IGRAPH_FROM(g, eid)];
+            es[2 * eid + 1] = node[(size_t) IGRAPH_TO(g, eid)];
+            local.edge_weights[eid] = obj.edge_weights.empty() ? 1.0 : obj.edge_weights[eid];
+        }
+    });
+    const size_t mc = merge_duplicate_edges(es.data(), m, k, igraph_is_directed(g), DuplicatePolicy::Sum,
+                                            SelfLoopPolicy::Keep, local.edge_weights, threads);
+    es.resize(2 * mc);
+    local.node_weights.assign((size_t) k, 0.0);
+    igraph_vector_int_t local_memb;
+    if (igraph_vector_int_init(&local_memb, k)) throw std::runtime_error("igraph_vector_int_init failed");
+    for (igraph_integer_t v = 0; v < n; ++v) {
+        const int64_t c = node[(size_t) v];
+        local.node_weights[(size_t) c] += obj.node_weights.empty() ? 1.0 : obj.node_weights[(size_t) v];
+        VECTOR(local_memb)[c] = memb[v];
+    }
+    // igraph wants start labels below the vertex count: renumber densely.
+    std::fill(super.begin(), super.end(), -1);
+    int64_t labels = 0;
+    for (int64_t c = 0; c < k; ++c) {
+        int64_t& l = super[(size_t) VECTOR(local_memb)[c]];
+        if (l < 0) l = labels++;
+        VECTOR(local_memb)[c] = l;
+    }
+    super = std::vector<int64_t>();
+    res.local_vertices = k;
+    res.local_edges = (int64_t) mc;
+
+    igraph_t lg;
+    igraph_vector_int_t edges_vec;
+    static_assert(sizeof(igraph_integer_t) == sizeof(int64_t), "igraph edge ids are 64-bit");
+    igraph_vector_int_view(&edges_vec, reinterpret_cast<const igraph_integer_t*>(es.data()), (igraph_integer_t) es.size());
+    if (igraph_create(&lg, &edges_vec, (igraph_integer_t) k, igraph_is_directed(g))) {
+        igraph_vector_int_destroy(&local_memb);
+        throw std::runtime_error("igraph_create failed");
+    }
+    es = decltype(es)();
+    std::cerr << "Local pass: " << res.affected_vertices << " affected vertices, contracted graph "
+              << k << " vertices, " << mc << " edges\n";
+
+    std::vector<IterationRecord> history;
+    try {
+        run_igraph_leiden_converging(&lg, local, opt.resolution, opt.beta, /*start=*/true, opt.convergence,
+                                     &local_memb, nb_clusters, quality, &history);
+    } catch (...) {
+        igraph_destroy(&lg);
+        igraph_vector_int_destroy(&local_memb);
+        throw;
+    }
+    igraph_destroy(&lg);
+    for (igraph_integer_t v = 0; v < n; ++v) memb[v] = VECTOR(local_memb)[node[(size_t) v]];
+    igraph_vector_int_destroy(&local_memb);
+    res.local_iterations = (int) history.size();
+    std::vector<double> iteration_seconds;
+    for (const IterationRecord& r : history) iteration_seconds.push_back(r.seconds);
+    local_phase.set_iteration_seconds(std::move(iteration_seconds));
+    local_phase.finish();
+    std::cerr << "Local pass done in " << seconds_since(t_local) << " s: " << *nb_clusters
+              << " communities, quality " << *quality << "\n";
+
+    RunReport::Phase global_phase(report, "global");
+    global_phase.add_edges(m);
+    const Clock::time_point t_global = Clock::now();
+    std::cerr << "Global pass\n";
+    res.stop_reason = run_igraph_leiden_converging(g, obj, opt.resolution, opt.beta, /*start=*/true, opt.convergence,
+                                                   membership, nb_clusters, quality, &history);
+    res.global_iterations = (int) history.size();
+    iteration_seconds.clear();
+    for (const IterationRecord& r : history) iteration_seconds.push_back(r.seconds);
+    global_phase.set_iteration_seconds(std::move(iteration_seconds));
+    global_phase.finish();
+    std::cerr << "Global pass done in " << seconds_since(t_global) << " s\n";
+    return res;
+}
@@ -0,0 +1,78 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+// Incremental re-clustering: apply an edge delta (added / removed edges) to a
+// loaded graph and re-optimise from the previous run's membership, first on
+// the neighbourhood of the changed edges and then with one warm-started
+// global pass.
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include <igraph/igraph.h>
+
+#include "convergence.h"
+#include "edge_io.h"
+#include "igraph_backend.h"
+#include "run_report.h"
+
+struct EdgeDelta {
+    EdgeList added;             // original node ids
+    WeightList added_weights;   // one per added edge, empty for unit weights
+    EdgeList removed;           // original node ids
+};
+
+struct DeltaStats {
+    int64_t added_edges = 0;
+    int64_t removed_edges = 0;
+    int64_t missing_removals = 0;  // removed edges that were not in the graph
+    int64_t new_vertices = 0;      // ids first seen in the added edges
+};
+
+// Applies `delta` to *g, rebuilding it. `weights` (one per edge, empty when
+// unweighted) and `inv_map` (empty when ids are used as-is) are updated to
+// match; new vertices get the next free indices. Each listed removal takes
+// out one matching edge, the first in edge order. Endpoints of every edge
+// actually added or removed are appended to *touched.
+DeltaStats apply_edge_delta(igraph_t* g, std::vector<double>& weights, std::vector<long long>& inv_map,
+                            const EdgeDelta& delta, std::vector<int64_t>* touched, unsigned threads = 0);
+
+// Reads a previous leiden_results file (original node id, community; TSV or
+// Parquet) into one label per vertex in 0..n-1. Vertices missing from the
+// file, such as ones added by a delta, start as singletons; rows whose id is
+// not a vertex are skipped and counted in *unknown.
+std::vector<igraph_integer_t> read_previous_membership(const std::filesystem::path& path,
+                                                       const std::vector<long long>& inv_map,
+                                                       igraph_integer_t n, unsigned threads = 0,
+                                                       int64_t* unknown = nullptr);
+
+struct IncrementalOptions {
+    double resolution = 1.0;
+    double beta = 0.01;
+    int hops = 1;                    // affected set: changed-edge endpoints plus this many hops
+    ConvergenceOptions convergence;  // both passes
+    unsigned threads = 0;
+};
+
+struct IncrementalResult {
+    int64_t affected_vertices = 0;
+    int64_t local_vertices = 0;      // vertices of the contracted graph the local pass ran on
+    int64_t local_edges = 0;
+    int local_iterations = 0;
+    int global_iterations = 0;
+    StopReason stop_reason = StopReason::Stable;  // of the global pass
+};
+
+// Re-optimises *membership (in: previous labels in 0..n-1; out: reindexed to
+// 0..nb_clusters-1). The local pass keeps the affected vertices individual
+// and contracts every other vertex into its previous community, so Leiden
+// can only move affected vertices (and merge whole communities); the global
+// pass then runs warm-started on g itself. Records "local" and "global"
+// phases in `report` when it is non-null.
+IncrementalResult recluster_incremental(const igraph_t* g, const LeidenObjective& obj,
+                                        const std::vector<int64_t>& touched, const IncrementalOptions& opt,
+                                        igraph_vector_int_t* membership, igraph_integer_t* nb_clusters,
+                                        igraph_real_t* quality, RunReport* report = nullptr);
+
+#endif // INCREMENTAL_H
@@ -0,0 +1,538 @@
+// leiden_bench: reproducible synthetic graphs, timed ingestion, graph build
+// and clustering for each backend, one CSV row per (graph, vertex order,
+// engine, threads, repeat).
+//
+// Graphs come from igraph's generators, seeded with --seed:
+//   planted  equal blocks, average degree d, fraction mu of edges between blocks
+//   sbm      stochastic block model with heterogeneous (Zipf-like) block sizes
+//   ba       Barabasi-Albert preferential attachment (no ground truth)
+//   er       Erdos-Renyi G(n, m) (no ground truth)
+// Vertex ids are shuffled so that blocks are not contiguous id ranges, the
+// edges are written to a TSV once, and "ingest" times reading that file back
+// with read_tsv_edges plus id remapping, as leiden_igraph does.
+//
+// --reorder adds one pass per vertex order: the ingested ids are renumbered
+// (timed as reorder_s) before every engine runs, so cluster_s can be
+// compared against the "none" rows for the speedup.
+//
+// Engines: libleidenalg (the c_leidenGraphCreateWeighted /
+// c_leidenRunWithStats handle path), igraph (igraph_community_leiden via
+// igraph_backend) and native (native_leiden). Quality is re-scored for every engine with
+// partition_quality, so all rows use igraph's convention; NMI is against the
+// planted blocks.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <igraph/igraph.h>
+
+#include "edge_io.h"
+#include "id_remap.h"
+#include "igraph_backend.h"
+#include "native_leiden.h"
+#include "parallel.h"
+#include "reorder.h"
+#include "run_leiden.h"
+#include "run_report.h"
+
+namespace fs = std::filesystem;
+
+struct BenchOptions {
+    std::vector<std::string> graphs = {"planted", "sbm", "ba", "er"};
+    std::vector<std::string> engines = {"libleidenalg", "igraph", "native"};
+    std::vector<unsigned> threads = {0};
+    std::vector<VertexOrder> reorders = {VertexOrder::None};
+    int64_t n = 100000;
+    double avg_degree = 16.0;
+    int64_t blocks = 100;
+    double mixing = 0.2;             // fraction of a vertex's edges leaving its block
+    bool modularity = true;
+    double resolution = 1.0;
+    int repeats = 1;
+    uint64_t seed = 42;
+    bool shuffle = true;
+    int max_iterations = 50;
+    fs::path csv;                    // empty = stdout
+    fs::path tmp_dir;
+    std::string label;               // free-form tag, e.g. a commit id
+};
+
+// A generated graph after ingestion: remapped edges and ground truth.
+struct BenchGraph {
+    std::string name;
+    int64_t n = 0;
+    std::vector<int64_t> src, dst;          // ids 0..n-1
+    std::vector<igraph_integer_t> truth;    // block per vertex, empty = none
+    double ingest_seconds = 0.0;
+};
+
+struct BenchRow {
+    std::string engine;
+    VertexOrder reorder = VertexOrder::None;
+    double reorder_seconds = 0.0;
+    unsigned threads = 1;
+    int repeat = 0;
+    double build_seconds = 0.0;
+    double cluster_seconds = 0.0;
+    int64_t iterations = 0;
+    int64_t clusters = 0;
+    double quality = 0.0;
+    double nmi = -1.0;                      // < 0 when there is no ground truth
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void check(igraph_error_t err, const char* what) {
+    if (err) throw std::runtime_error(std::string(what) + " failed");
+}
+
+// Destroys a built igraph graph when the scope ends, normally or by an exception.
+struct IgraphGuard {
+    igraph_t* g;
+    ~IgraphGuard() { igraph_destroy(g); }
+};
+
+template <class T>
+static std::vector<T> parse_list(const std::string& spec, T (*conv)(const std::string&)) {
+    std::vector<T> out;
+    std::stringstream ss(spec);
+    for (std::string tok; std::getline(ss, tok, ',');)
+        if (!tok.empty()) out.push_back(conv(tok));
+    if (out.empty()) throw std::invalid_argument("Empty list: " + spec);
+    return out;
+}
+
+// ---------- Generators ----------
+
+// Block sizes for `kind`; both sum to n with every block holding >= 2 vertices.
+static std::vector<igraph_integer_t> block_sizes(const std::string& kind, int64_t n, int64_t k) {
+    k = std::max<int64_t>(1, std::min(k, n / 2));
+    std::vector<double> w((size_t) k, 1.0);
+    if (kind == "sbm")
+        for (int64_t i = 0; i < k; ++i) w[(size_t) i] = 1.0 / std::pow((double) (i + 1), 0.7);
+    const double total = std::accumulate(w.begin(), w.end(), 0.0);
+    std::vector<igraph_integer_t> sizes((size_t) k);
+    int64_t used = 0;
+    for (int64_t i = 0; i < k; ++i) {
+        sizes[(size_t) i] = std::max<igraph_integer_t>(2, (igraph_integer_t) std::floor((double) n * w[(size_t) i] / total));
+        used += sizes[(size_t) i];
+    }
+    // Hand the rounding difference to (or take it from) the largest block.
+    sizes[0] += (igraph_integer_t) (n - used);
+    if (sizes[0] < 2) throw std::invalid_argument("Too many blocks for " + std::to_string(n) + " vertices");
+    return sizes;
+}
+
+static igraph_t generate_block_model(const std::string& kind, const BenchOptions& o,
+                                     std::vector<igraph_integer_t>* truth) {
+    const std::vector<igraph_integer_t> sizes = block_sizes(kind, o.n, o.blocks);
+    const igraph_integer_t k = (igraph_integer_t) sizes.size();
+    igraph_matrix_t pref;
+    check(igraph_matrix_init(&pref, k, k), "igraph_matrix_init");
+    for (igraph_integer_t a = 0; a < k; ++a) {
+        for (igraph_integer_t b = 0; b < k; ++b) {
+            // Expected internal degree d(1-mu) inside a block, d*mu spread over the rest.
+            double p = a == b ? o.avg_degree * (1.0 - o.mixing) / (double) std::max<igraph_integer_t>(1, sizes[a] - 1)
+                              : o.avg_degree * o.mixing / (double) std::max<int64_t>(1, o.n - sizes[a]);
+            MATRIX(pref, a, b) = std::min(1.0, p);
+        }
+    }
+    igraph_vector_int_t bs;
+    igraph_vector_int_view(&bs, sizes.data(), k);
+    igraph_t g;
+    igraph_error_t err = igraph_sbm_game(&g, o.n, &pref, &bs, /*directed=*/false, /*loops=*/false);
+    igraph_matrix_destroy(&pref);
+    check(err, "igraph_sbm_game");
+
+    truth->clear();
+    truth->reserve((size_t) o.n);
+    for (igraph_integer_t a = 0; a < k; ++a) truth->insert(truth->end(), (size_t) sizes[a], a);
+    return g;
+}
+
+static igraph_t generate(const std::string& kind, const BenchOptions& o, std::vector<igraph_integer_t>* truth) {
+    check(igraph_rng_seed(igraph_rng_default(), o.seed), "igraph_rng_seed");
+    truth->clear();
+    if (kind == "planted" || kind == "sbm") return generate_block_model(kind, o, truth);
+
+    igraph_t g;
+    if (kind == "ba") {
+        const igraph_integer_t per_vertex = std::max<igraph_integer_t>(1, (igraph_integer_t) std::llround(o.avg_degree / 2));
+        check(igraph_barabasi_game(&g, o.n, /*power=*/1.0, per_vertex, /*outseq=*/nullptr, /*outpref=*/true,
+                                   /*A=*/1.0, /*directed=*/false, IGRAPH_BARABASI_PSUMTREE, /*start_from=*/nullptr),
+              "igraph_barabasi_game");
+    } else if (kind == "er") {
+        const igraph_integer_t m = (igraph_integer_t) std::llround((double) o.n * o.avg_degree / 2);
+        check(igraph_erdos_renyi_game_gnm(&g, o.n, m, /*directed=*/false, /*loops=*/false),
+              "igraph_erdos_renyi_game_gnm");
+    } else {
+        throw std::invalid_argument("Unknown graph kind: " + kind);
+    }
+    return g;
+}
+
+// Generates `kind`, writes it to a TSV with shuffled ids, then reads it back
+// through the leiden_igraph loader (timed as ingestion).
+static BenchGraph make_bench_graph(const std::string& kind, const BenchOptions& o, unsigned threads) {
+    std::vector<igraph_integer_t> truth;
+    igraph_t g = generate(kind, o, &truth);
+    const int64_t n = igraph_vcount(&g), m = igraph_ecount(&g);
+    igraph_vector_int_t el;
+    check(igraph_vector_int_init(&el, 0), "igraph_vector_int_init");
+    igraph_error_t err = igraph_get_edgelist(&g, &el, /*bycol=*/false);
+    igraph_destroy(&g);
+    if (err) { igraph_vector_int_destroy(&el); check(err, "igraph_get_edgelist"); }
+
+    std::vector<int64_t> perm((size_t) n);
+    std::iota(perm.begin(), perm.end(), (int64_t) 0);
+    if (o.shuffle) {
+        std::mt19937_64 rng(o.seed);
+        std::shuffle(perm.begin(), perm.end(), rng);
+    }
+
+    const fs::path tsv = o.tmp_dir / ("leiden_bench_" + kind + "_" + std::to_string(::getpid()) + ".tsv");
+    {
+        std::ofstream out(tsv);
+        if (!out) throw std::runtime_error("Cannot open for write: " + tsv.string());
+        for (int64_t e = 0; e < m; ++e)
+            out << perm[(size_t) VECTOR(el)[2 * e]] << '\t' << perm[(size_t) VECTOR(el)[2 * e + 1]] << '\n';
+        if (!out) throw std::runtime_error("Failed writing " + tsv.string());
+    }
+    igraph_vector_int_destroy(&el);
+
+    BenchGraph bg;
+    bg.name = kind;
+    auto t0 = std::chrono::steady_clock::now();
+    EdgeList edges = read_tsv_edges(tsv, threads);
+    std::vector<int64_t> es(edges.size() * 2);
+    std::vector<long long> inv_map;
+    bg.n = remap_edge_ids(edges, es.data(), &inv_map, RemapStrategy::Auto, threads);
+    bg.ingest_seconds = seconds_since(t0);
+    fs::remove(tsv);
+
+    bg.src.resize(edges.size());
+    bg.dst.resize(edges.size());
+    for (size_t e = 0; e < edges.size(); ++e) {
+        bg.src[e] = es[2 * e];
+        bg.dst[e] = es[2 * e + 1];
+    }
+    if (!truth.empty()) {
+        // Shuffled id perm[v] carries block truth[v]; remapped id i is inv_map[i].
+        std::vector<igraph_integer_t> by_id((size_t) n);
+        for (int64_t v = 0; v < n; ++v) by_id[(size_t) perm[(size_t) v]] = truth[(size_t) v];
+        bg.truth.resize((size_t) bg.n);
+        for (int64_t i = 0; i < bg.n; ++i) bg.truth[(size_t) i] = by_id[(size_t) inv_map[(size_t) i]];
+    }
+    if (bg.n < n)
+        std::cerr << kind << ": " << n - bg.n << " isolated vertices dropped by ingestion\n";
+    return bg;
+}
+
+// bg with its vertices renumbered by `order`; ground truth moves with them.
+static BenchGraph reorder_bench_graph(const BenchGraph& bg, VertexOrder order, unsigned threads, double* seconds) {
+    const size_t m = bg.src.size();
+    std::vector<int64_t> es(2 * m);
+    for (size_t e = 0; e < m; ++e) {
+        es[2 * e] = bg.src[e];
+        es[2 * e + 1] = bg.dst[e];
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    const std::vector<int64_t> perm = vertex_order(es.data(), m, bg.n, nullptr, order, threads);
+    *seconds = seconds_since(t0);
+
+    BenchGraph out;
+    out.name = bg.name;
+    out.n = bg.n;
+    out.ingest_seconds = bg.ingest_seconds;
+    out.src.resize(m);
+    out.dst.resize(m);
+    for (size_t e = 0; e < m; ++e) {
+        out.src[e] = perm[(size_t) bg.src[e]];
+        out.dst[e] = perm[(size_t) bg.dst[e]];
+    }
+    if (!bg.truth.empty()) {
+        out.truth.resize(bg.truth.size());
+        for (int64_t v = 0; v < bg.n; ++v) out.truth[(size_t) perm[(size_t) v]] = bg.truth[(size_t) v];
+    }
+    return out;
+}
+
+// ---------- Engines ----------
+
+// Undirected igraph graph of bg, used for the igraph engine and for scoring.
+static void build_igraph(const BenchGraph& bg, igraph_t* g) {
+    std::vector<igraph_integer_t> es(bg.src.size() * 2);
+    for (size_t e = 0; e < bg.src.size(); ++e) {
+        es[2 * e] = bg.src[e];
+        es[2 * e + 1] = bg.dst[e];
+    }
+    igraph_vector_int_t view;
+    igraph_vector_int_view(&view, es.data(), (igraph_integer_t) es.size());
+    check(igraph_create(g, &view, bg.n, IGRAPH_UNDIRECTED), "igraph_create");
+}
+
+// libleidenalg optimises on its own handle, which is a directed igraph graph
+// (as for every c_leidenGraphCreate caller); merge mode 2 at least keeps a
+// (u,v) / (v,u) pair from counting twice. The row's quality is re-scored on
+// the undirected reference graph like the other engines.
+static void run_libleidenalg(const BenchGraph& bg, const BenchOptions& o, BenchRow* row,
+                             std::vector<igraph_integer_t>* membership) {
+    const int64_t m = (int64_t) bg.src.size();
+    auto t0 = std::chrono::steady_clock::now();
+    LeidenGraph* handle = c_leidenGraphCreateWeighted(bg.src.data(), bg.dst.data(), nullptr, m, bg.n,
+                                                      /*mergeDuplicates=*/2);
+    if (!handle) throw std::runtime_error("c_leidenGraphCreateWeighted failed");
+    row->build_seconds = seconds_since(t0);
+
+    LeidenConvergence conv;
+    c_leidenConvergenceDefaults(&conv);
+    conv.seed = (int64_t) (o.seed + (uint64_t) row->repeat);
+    LeidenRunStats stats;
+    std::vector<int64_t> communities((size_t) bg.n);
+    t0 = std::chrono::steady_clock::now();
+    const int64_t k = c_leidenRunWithStats(handle, o.modularity ? MODULARITY : CPM, o.resolution, &conv,
+                                           communities.data(), &stats);
+    row->cluster_seconds = seconds_since(t0);
+    c_leidenGraphDestroy(handle);
+    if (k < 0) throw std::runtime_error("c_leidenRunWithStats failed");
+    row->iterations = stats.iterations;
+    row->clusters = k;
+    membership->assign(communities.begin(), communities.end());
+}
+
+// Iterates igraph_community_leiden through run_igraph_leiden_converging so
+// the iteration count can be reported; stops once the partition is stable.
+static void run_igraph(const BenchGraph& bg, const BenchOptions& o, BenchRow* row,
+                       std::vector<igraph_integer_t>* membership) {
+    auto t0 = std::chrono::steady_clock::now();
+    igraph_t g;
+    build_igraph(bg, &g);
+    const LeidenObjective obj = make_objective(&g, o.modularity);
+    row->build_seconds = seconds_since(t0);
+
+    igraph_vector_int_t memb;
+    check(igraph_vector_int_init(&memb, 0), "igraph_vector_int_init");
+    igraph_integer_t k = 0;
+    igraph_real_t q = 0.0;
+    check(igraph_rng_seed(igraph_rng_default(), o.seed + (uint64_t) row->repeat), "igraph_rng_seed");
+    t0 = std::chrono::steady_clock::now();
+    try {
+        ConvergenceOptions conv;
+        conv.max_iterations = o.max_iterations;
+        std::vector<IterationRecord> history;
+        run_igraph_leiden_converging(&g, obj, o.resolution, /*beta=*/0.01, /*start=*/false, conv, &memb, &k, &q,
+                                     &history);
+        row->iterations = (int) history.size();
+    } catch (...) {
+        igraph_vector_int_destroy(&memb);
+        igraph_destroy(&g);
+        throw;
+    }
+    row->cluster_seconds = seconds_since(t0);
+    row->clusters = k;
+    membership->assign(VECTOR(memb), VECTOR(memb) + bg.n);
+    igraph_vector_int_destroy(&memb);
+    igraph_destroy(&g);
+}
+
+static void run_native(const BenchGraph& bg, const BenchOptions& o, BenchRow* row,
+                       std::vector<igraph_integer_t>* membership) {
+    auto t0 = std::chrono::steady_clock::now();
+    CsrGraph csr = build_csr(bg.n, (int64_t) bg.src.size(), bg.src.data(), bg.dst.data(), nullptr, row->threads);
+    row->build_seconds = seconds_since(t0);
+
+    NativeLeidenOptions opt;
+    opt.modularity = o.modularity;
+    opt.resolution = o.resolution;
+    opt.convergence.max_iterations = o.max_iterations;
+    opt.seed = o.seed + (uint64_t) row->repeat;
+    opt.threads = row->threads;
+    t0 = std::chrono::steady_clock::now();
+    NativeLeidenResult res = native_leiden(csr, opt);
+    row->cluster_seconds = seconds_since(t0);
+    row->iterations = res.iterations;
+    row->clusters = res.clusters;
+    membership->assign(res.membership.begin(), res.membership.end());
+}
+
+// ---------- Output ----------
+
+static void write_header(std::ostream& os) {
+    os << "label,graph,n,m,engine,objective,resolution,threads,repeat,seed,ingest_s,build_s,cluster_s,"
+          "edges_per_s,iterations,clusters,quality,nmi,peak_rss_mb,reorder,reorder_s\n";
+}
+
+static void write_row(std::ostream& os, const BenchOptions& o, const BenchGraph& bg, const BenchRow& r) {
+    const double m = (double) bg.src.size();
+    os << o.label << ',' << bg.name << ',' << bg.n << ',' << bg.src.size() << ',' << r.engine << ','
+       << (o.modularity ? "modularity" : "cpm") << ',' << o.resolution << ',' << r.threads << ',' << r.repeat << ','
+       << o.seed << ',' << bg.ingest_seconds << ',' << r.build_seconds << ',' << r.cluster_seconds << ','
+       << (r.cluster_seconds > 0 ? m / r.cluster_seconds : 0.0) << ',' << r.iterations << ',' << r.clusters << ','
+       << std::setprecision(10) << r.quality << ',';
+    if (r.nmi >= 0) os << r.nmi;
+    os << std::setprecision(6) << ',' << (double) peak_rss_bytes() / (1 << 20) << ',' << vertex_order_name(r.reorder)
+       << ',' << r.reorder_seconds << '\n';
+    os.flush();
+}
+
+// ---------- Main ----------
+
+static void print_usage(const char* prog) {
+    std::cerr
+      << "Usage: " << prog << " [options]\n"
+      << "Options:\n"
+      << "  --graphs LIST          planted,sbm,ba,er (default all)\n"
+      << "  --engines LIST         libleidenalg,igraph,native (default all)\n"
+      << "  --threads LIST         Thread counts for the native engine and ingestion, e.g. 1,4,16 (default all cores)\n"
+      << "  --n N                  Vertices (default 100000)\n"
+      << "  --avg-degree D         Average degree (default 16)\n"
+      << "  --blocks K             Planted / SBM blocks (default 100)\n"
+      << "  --mixing MU            Fraction of edges between blocks (default 0.2)\n"
+      << "  --objective modularity|cpm  (default modularity)\n"
+      << "  --resolution R         (default 1.0)\n"
+      << "  --max-iterations N     igraph / native iteration cap (default 50)\n"
+      << "  --repeats R            Runs per configuration (default 1)\n"
+      << "  --seed S               Generator and clustering seed (default 42)\n"
+      << "  --no-shuffle           Keep generator vertex order (blocks stay contiguous)\n"
+      << "  --reorder LIST         Vertex orders to run each graph with: none,degree,bfs,rcm,rabbit (default none)\n"
+      << "  --csv FILE             Append rows to FILE (header written when new); default stdout\n"
+      << "  --tmp-dir DIR          Where the ingestion TSV is written (default system temp)\n"
+      << "  --label STR            Value of the 'label' column, e.g. a commit id\n";
+}
+
+int main(int argc, char** argv) {
+    BenchOptions o;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string flag = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + flag);
+                return argv[++i];
+            };
+            if (flag == "--graphs") o.graphs = parse_list<std::string>(value(), [](const std::string& s) { return s; });
+            else if (flag == "--engines") o.engines = parse_list<std::string>(value(), [](const std::string& s) { return s; });
+            else if (flag == "--threads")
+                o.threads = parse_list<unsigned>(value(), [](const std::string& s) { return (unsigned) std::stoul(s); });
+            else if (flag == "--n") o.n = std::stoll(value());
+            else if (flag == "--avg-degree") o.avg_degree = std::stod(value());
+            else if (flag == "--blocks") o.blocks = std::stoll(value());
+            else if (flag == "--mixing") o.mixing = std::stod(value());
+            else if (flag == "--objective") {
+                const std::string obj = value();
+                if (obj != "modularity" && obj != "cpm") throw std::invalid_argument("--objective expects modularity or cpm");
+                o.modularity = obj == "modularity";
+            }
+            else if (flag == "--resolution") o.resolution = std::stod(value());
+            else if (flag == "--max-iterations") o.max_iterations = std::stoi(value());
+            else if (flag == "--repeats") o.repeats = std::stoi(value());
+            else if (flag == "--seed") o.seed = std::stoull(value());
+            else if (flag == "--no-shuffle") o.shuffle = false;
+            else if (flag == "--reorder") o.reorders = parse_list<VertexOrder>(value(), parse_vertex_order);
+            else if (flag == "--csv") o.csv = value();
+            else if (flag == "--tmp-dir") o.tmp_dir = value();
+            else if (flag == "--label") o.label = value();
+            else if (flag == "--help" || flag == "-h") { print_usage(argv[0]); return 0; }
+            else { std::cerr << "Unknown argument: " << flag << "\n"; print_usage(argv[0]); return 1; }
+        }
+        for (const auto& e : o.engines)
+            if (e != "libleidenalg" && e != "igraph" && e != "native")
+                throw std::invalid_argument("Unknown engine: " + e);
+        if (o.n < 2 || o.avg_degree <= 0 || o.mixing < 0 || o.mixing > 1 || o.repeats < 1)
+            throw std::invalid_argument("Need --n >= 2, --avg-degree > 0, 0 <= --mixing <= 1, --repeats >= 1");
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (o.tmp_dir.empty()) o.tmp_dir = fs::temp_directory_path();
+
+    try {
+        std::ofstream file;
+        std::ostream* out = &std::cout;
+        if (!o.csv.empty()) {
+            const bool fresh = !fs::exists(o.csv) || fs::file_size(o.csv) == 0;
+            file.open(o.csv, std::ios::app);
+            if (!file) throw std::runtime_error("Cannot open CSV for append: " + o.csv.string());
+            out = &file;
+            if (fresh) write_header(*out);
+        } else {
+            write_header(*out);
+        }
+
+        const unsigned ingest_threads = *std::max_element(o.threads.begin(), o.threads.end());
+        for (const std::string& kind : o.graphs) {
+            auto t_gen = std::chrono::steady_clock::now();
+            BenchGraph bg = make_bench_graph(kind, o, ingest_threads);
+            std::cerr << kind << ": " << bg.n << " vertices, " << bg.src.size() << " edges (generated and ingested in "
+                      << seconds_since(t_gen) << " s)\n";
+
+            for (VertexOrder order : o.reorders) {
+                double reorder_s = 0.0;
+                BenchGraph reordered;
+                if (order != VertexOrder::None) {
+                    reordered = reorder_bench_graph(bg, order, ingest_threads, &reorder_s);
+                    std::cerr << kind << ": reordered (" << vertex_order_name(order) << ") in " << reorder_s << " s\n";
+                }
+                const BenchGraph& g = order == VertexOrder::None ? bg : reordered;
+
+                // Reference graph for scoring; not timed.
+                igraph_t ref;
+                build_igraph(g, &ref);
+                IgraphGuard ref_guard{&ref};
+                const LeidenObjective ref_obj = make_objective(&ref, o.modularity);
+                igraph_vector_int_t truth, memb;
+                igraph_vector_int_view(&truth, g.truth.data(), (igraph_integer_t) g.truth.size());
+
+                for (const std::string& engine : o.engines) {
+                    // Only the native engine is multithreaded; the others run once per repeat.
+                    std::vector<unsigned> thread_list = engine == "native" ? o.threads : std::vector<unsigned>{1};
+                    for (unsigned t : thread_list) {
+                        for (int rep = 0; rep < o.repeats; ++rep) {
+                            BenchRow row;
+                            row.engine = engine;
+                            row.reorder = order;
+                            row.reorder_seconds = reorder_s;
+                            row.threads = engine == "native" ? resolve_threads(t) : 1;
+                            row.repeat = rep;
+                            std::vector<igraph_integer_t> membership;
+                            if (engine == "libleidenalg") run_libleidenalg(g, o, &row, &membership);
+                            else if (engine == "igraph") run_igraph(g, o, &row, &membership);
+                            else run_native(g, o, &row, &membership);
+
+                            igraph_vector_int_view(&memb, membership.data(), (igraph_integer_t) membership.size());
+                            row.quality = partition_quality(&ref, ref_obj, o.resolution, &memb);
+                            if (!g.truth.empty())
+                                check(igraph_compare_communities(&memb, &truth, &row.nmi, IGRAPH_COMMCMP_NMI),
+                                      "igraph_compare_communities");
+                            write_row(*out, o, g, row);
+                            std::cerr << "  " << engine << " reorder=" << vertex_order_name(order)
+                                      << " threads=" << row.threads << " repeat=" << rep << ": " << row.clusters
+                                      << " clusters, quality=" << row.quality << ", cluster " << row.cluster_seconds
+                                      << " s\n";
+                        }
+                    }
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+    return 0;
+}
@@ -3,13 +3,27 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include "convergence.h"
 #include "run_leiden.h"
+#include "result_writer.h"
+#include "run_report.h"
 
 void print_usage(const char* program_name) {
     std::cout << "Usage: " << program_name << " [options] input_file output_file\n"
               << "Options:\n"
               << "  -t, --type TYPE       Modularity type (cpm or modularity)\n"
               << "  -r, --resolution VAL  Resolution parameter (default: 1.0)\n"
+              << "  -e, --engine ENGINE   libleidenalg (default) or native (multithreaded)\n"
+              << "  -j, --threads N       Threads for the native engine and output (default: all cores)\n"
+              << "  -f, --format FMT      Output format: tsv (default) or parquet\n"
+              << "  --report FILE         Write per-phase timings, peak memory and throughput as JSON\n"
+              << "  --max-iterations N    Optimiser iterations, -1 = until stable (default: libleidenalg 2, native 50)\n"
+              << "  --min-gain F          Stop once an iteration improves quality by less than F (relative)\n"
+              << "  --min-moved F         Stop once an iteration moves fewer than F of the vertices\n"
+              << "  --time-budget SEC     Keep the best partition found within SEC seconds of optimisation\n"
+              << "  --seed N              Fixed optimiser seed (non-zero): the same seed gives the same partition\n"
+              << "  --reduce MODE         libleidenalg: fold pendant nodes (pendants) and degree-2 chains (chains)\n"
+              << "                        into their neighbours before clustering (default none)\n"
               << "Example:\n"
               << "  " << program_name << " -t cpm -r 0.5 input.tsv output.tsv\n";
 }
@@ -50,27 +64,18 @@ bool read_graph(const std::string& filename,
     return true;
 }
 
-bool write_clusters(const std::string& filename, 
-                   const int64_t communities[], 
-                   int64_t num_nodes) {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open output file: " << filename << std::endl;
-        return false;
-    }
-
-    for (int64_t i = 0; i < num_nodes; i++) {
-        file << i << "\t" << communities[i] << "\n";
-    }
-
-    return true;
-}
-
 int main(int argc, char* argv[]) {
     std::string input_file;
     std::string output_file;
     std::string modularity_type = "modularity";
     double resolution = 1.0;
+    std::string engine = "libleidenalg";
+    int64_t threads = 0;
+    std::string output_format = "tsv";
+    std::string report_file;
+    LeidenConvergence convergence;
+    c_leidenConvergenceDefaults(&convergence);
+    convergence.log_iterations = 1;
 
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
@@ -86,6 +91,56 @@ int main(int argc, char* argv[]) {
             if (i + 1 < argc) {
                 resolution = std::stod(argv[++i]);
             }
+        } else if (arg == "-e" || arg == "--engine") {
+            if (i + 1 < argc) {
+                engine = argv[++i];
+            }
+        } else if (arg == "-j" || arg == "--threads") {
+            if (i + 1 < argc) {
+                threads = std::stoll(argv[++i]);
+            }
+        } else if (arg == "-f" || arg == "--format") {
+            if (i + 1 < argc) {
+                output_format = argv[++i];
+            }
+        } else if (arg == "--report") {
+            if (i + 1 < argc) {
+                report_file = argv[++i];
+            }
+        } else if (arg == "--max-iterations") {
+            if (i + 1 < argc) {
+                convergence.max_iterations = std::stoll(argv[++i]);
+            }
+        } else if (arg == "--min-gain") {
+            if (i + 1 < argc) {
+                convergence.min_quality_gain = std::stod(argv[++i]);
+            }
+        } else if (arg == "--min-moved") {
+            if (i + 1 < argc) {
+                convergence.min_moved_fraction = std::stod(argv[++i]);
+            }
+        } else if (arg == "--time-budget") {
+            if (i + 1 < argc) {
+                convergence.time_budget_seconds = std::stod(argv[++i]);
+            }
+        } else if (arg == "--seed") {
+            if (i + 1 < argc) {
+                convergence.seed = std::stoll(argv[++i]);
+            }
+        } else if (arg == "--reduce") {
+            if (i + 1 < argc) {
+                const std::string mode = argv[++i];
+                if (mode == "none") {
+                    convergence.reduce = 0;
+                } else if (mode == "pendants") {
+                    convergence.reduce = 1;
+                } else if (mode == "chains") {
+                    convergence.reduce = 2;
+                } else {
+                    std::cerr << "Error: Invalid reduction. Use 'none', 'pendants' or 'chains'\n";
+                    return 1;
+                }
+            }
         } else if (input_file.empty()) {
             input_file = arg;
         } else if (output_file.empty()) {
@@ -99,12 +154,30 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    OutputFormat format;
+    try {
+        format = parse_output_format(output_format);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    RunReport report;
+    report.set("input", input_file);
+    report.set("objective", modularity_type);
+    report.set("resolution", resolution);
+    report.set("engine", engine);
+    if (convergence.seed != 0) report.set("seed", convergence.seed);
+
     // Read graph
     std::vector<int64_t> src, dst;
     int64_t max_node_id;
+    RunReport::Phase load_phase(&report, "load");
     if (!read_graph(input_file, src, dst, max_node_id)) {
         return 1;
     }
+    load_phase.add_edges(src.size());
+    load_phase.finish();
 
     // Prepare for clustering
     int64_t num_edges = src.size();
@@ -123,12 +196,52 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    report.set("vertices", num_nodes);
+    report.set("edges", num_edges);
+
     // Run Leiden algorithm
-    run_leiden(src.data(), dst.data(), num_edges, num_nodes, 
-              modularity_option, resolution, communities.data(), num_communities);
+    RunReport::Phase cluster_phase(&report, "cluster");
+    cluster_phase.add_edges(num_edges);
+    if (engine == "native") {
+        num_communities = c_runLeidenNativeWithOptions(src.data(), dst.data(), num_edges, num_nodes, modularity_option,
+                                                       resolution, threads, &convergence, communities.data());
+        if (num_communities < 0) {
+            return 1;
+        }
+    } else if (engine == "libleidenalg") {
+        LeidenRunStats stats;
+        num_communities = c_runLeidenWithOptions(src.data(), dst.data(), num_edges, num_nodes, modularity_option,
+                                                 resolution, &convergence, communities.data(), &stats);
+        if (num_communities < 0) {
+            return 1;
+        }
+        report.set("build_seconds", stats.build_seconds);
+        report.set("iterations", stats.iterations);
+        report.set("stop_reason", stop_reason_name((StopReason) stats.stop_reason));
+        report.set("quality", stats.quality);
+        if (convergence.reduce != 0) {
+            report.set("reduced_vertices", stats.reduced_nodes);
+            report.set("reduced_edges", stats.reduced_edges);
+            report.set("reduction_ratio", num_nodes > 0 ? (double) stats.reduced_nodes / (double) num_nodes : 1.0);
+        }
+    } else {
+        std::cerr << "Error: Invalid engine. Use 'libleidenalg' or 'native'\n";
+        return 1;
+    }
+
+    cluster_phase.finish();
+    report.set("clusters", num_communities);
 
     // Write results
-    if (!write_clusters(output_file, communities.data(), num_nodes)) {
+    try {
+        RunReport::Phase write_phase(&report, "write");
+        write_clusters(output_file, format, communities.data(),
+                       (size_t) num_nodes, /*inv_map=*/nullptr, /*community_base=*/0, (unsigned) threads);
+        write_phase.finish();
+        report.print(std::cerr);
+        if (!report_file.empty()) report.write_json(report_file);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
 
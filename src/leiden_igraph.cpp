@@ -3,171 +3,327 @@
 
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cerrno>
 #include <charconv>
+#include <chrono>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <string_view>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include <igraph/igraph.h>
 
-#include <arrow/api.h>
-#include <arrow/io/api.h>
-#include <parquet/arrow/reader.h>
+#include "checkpoint.h"
+#include "cluster_stats.h"
+#include "components.h"
+#include "edge_io.h"
+#include "edge_merge.h"
+#include "graph_loader.h"
+#include "graph_reduction.h"
+#include "id_remap.h"
+#include "igraph_backend.h"
+#include "incremental.h"
+#include "native_leiden.h"
+#include "result_writer.h"
+#include "run_report.h"
+#include "thread_pool.h"
+#include "union_find.h"
+#include "wcc.h"
 
 namespace fs = std::filesystem;
 
-struct Edge { long long u; long long v; };
+// ---------- Output ----------
 
-static inline bool has_ext(const fs::path& p, std::initializer_list<const char*> exts) {
-    auto e = p.extension().string();
-    std::transform(e.begin(), e.end(), e.begin(), [](unsigned char c){return std::tolower(c);});
-    for (auto x: exts) if (e == x) return true; return false;
+// One (orig_id, community+1) row per vertex, ordered by original id.
+static void write_results(const fs::path& out, OutputFormat format, const igraph_vector_int_t& membership,
+                          const std::vector<long long>& inv_map, unsigned threads) {
+    write_clusters(out, format, reinterpret_cast<const int64_t*>(VECTOR(membership)),
+                   (size_t) igraph_vector_int_size(&membership),
+                   inv_map.empty() ? nullptr : reinterpret_cast<const int64_t*>(inv_map.data()),
+                   /*community_base=*/1, threads);
 }
 
-// Minimal, fast ASCII splitter
-static inline std::vector<std::string_view> split_ws(std::string_view s) {
-    std::vector<std::string_view> out; size_t i=0, n=s.size();
-    while (i<n) { while (i<n && std::isspace((unsigned char)s[i])) ++i; size_t j=i; while (j<n && !std::isspace((unsigned char)s[j])) ++j; if (i<j) out.emplace_back(s.substr(i, j-i)); i=j; }
-    return out;
-}
+// ---------- Resolution sweep ----------
 
-static bool parse_ll(std::string_view sv, long long &val) {
-    auto begin = sv.data(); auto end = sv.data() + sv.size();
-    auto [ptr, ec] = std::from_chars(begin, end, val);
-    return ec == std::errc() && ptr == end;
+static std::vector<double> parse_resolution_list(const std::string& spec) {
+    std::vector<double> out;
+    std::stringstream ss(spec);
+    for (std::string tok; std::getline(ss, tok, ',');)
+        if (!tok.empty()) out.push_back(std::stod(tok));
+    if (out.empty()) throw std::invalid_argument("Empty --resolutions list");
+    return out;
 }
 
-// ---------- Arrow helpers ----------
-
-static int find_column_index(const std::shared_ptr<arrow::Schema>& schema, const std::vector<std::string>& names) {
-    for (const auto& name : names) {
-        int idx = schema->GetFieldIndex(name);
-        if (idx != -1) return idx;
+// "lo:hi:steps" -> steps values from lo to hi inclusive; geometric spacing
+// when both ends are positive (the usual scan), linear otherwise.
+static std::vector<double> parse_resolution_range(const std::string& spec) {
+    auto c1 = spec.find(':'), c2 = spec.rfind(':');
+    if (c1 == std::string::npos || c1 == c2)
+        throw std::invalid_argument("--resolution-range expects lo:hi:steps");
+    const double lo = std::stod(spec.substr(0, c1));
+    const double hi = std::stod(spec.substr(c1 + 1, c2 - c1 - 1));
+    const long steps = std::stol(spec.substr(c2 + 1));
+    if (steps < 1) throw std::invalid_argument("--resolution-range needs at least one step");
+    std::vector<double> out;
+    for (long i = 0; i < steps; ++i) {
+        const double t = steps == 1 ? 0.0 : (double) i / (double) (steps - 1);
+        out.push_back(lo > 0 && hi > 0 ? lo * std::pow(hi / lo, t) : lo + (hi - lo) * t);
     }
-    return -1;
+    return out;
 }
 
-static std::shared_ptr<arrow::Table> read_parquet_table(const fs::path& path) {
-    auto infile_res = arrow::io::ReadableFile::Open(path.string());
-    if (!infile_res.ok()) throw std::runtime_error(infile_res.status().ToString());
-    std::shared_ptr<arrow::io::ReadableFile> infile = *infile_res;
-
-    std::unique_ptr<parquet::arrow::FileReader> pq_reader;
-    auto open_res = parquet::arrow::OpenFile(infile, arrow::default_memory_pool());
-    if (!open_res.ok()) throw std::runtime_error(open_res.status().ToString());
-    pq_reader = std::move(*open_res);
-
-    std::shared_ptr<arrow::Table> table;
-    auto st = pq_reader->ReadTable(&table);
-    if (!st.ok()) throw std::runtime_error(st.ToString());
-
-    return table;
+static std::string resolution_tag(double r) {
+    std::ostringstream os;
+    os << std::setprecision(6) << r;
+    return os.str();
 }
 
-static std::vector<Edge> read_parquet_edges(const fs::path& path) {
-    auto table = read_parquet_table(path);
-    auto schema = table->schema();
+struct SweepRow {
+    double resolution = 0.0;
+    igraph_integer_t clusters = 0;
+    igraph_real_t quality = 0.0;
+    double seconds = 0.0;
+    std::vector<IterationRecord> history;
+};
+
+// Clusters G once per resolution on a thread pool. With warm_start the sorted
+// resolutions are split into one contiguous block per worker, and each run in
+// a block starts from the membership of the previous (neighbouring) run.
+static void run_sweep(const igraph_t* G, const LeidenObjective& obj, std::vector<double> resolutions,
+                      bool warm_start, const ConvergenceOptions& conv, unsigned threads, const fs::path& outdir,
+                      const std::vector<long long>& inv_map, OutputFormat format) {
+    std::sort(resolutions.begin(), resolutions.end());
+    resolutions.erase(std::unique(resolutions.begin(), resolutions.end()), resolutions.end());
+    const size_t R = resolutions.size();
+    std::vector<SweepRow> rows(R);
+    std::mutex log_mu;
+
+    prime_graph_cache(G);
+    ThreadPool pool((unsigned) std::min<size_t>(resolve_threads(threads), R));
+    const size_t blocks = warm_start ? pool.size() : R;
+    for (size_t b = 0; b < blocks; ++b) {
+        const size_t lo = R * b / blocks, hi = R * (b + 1) / blocks;
+        pool.submit([&, lo, hi](unsigned) {
+            igraph_vector_int_t membership; igraph_vector_int_init(&membership, 0);
+            for (size_t r = lo; r < hi; ++r) {
+                auto t0 = std::chrono::steady_clock::now();
+                SweepRow& row = rows[r];
+                row.resolution = resolutions[r];
+                run_igraph_leiden_converging(G, obj, row.resolution, /*beta=*/0.01, /*start=*/warm_start && r > lo,
+                                             conv, &membership, &row.clusters, &row.quality, &row.history);
+                row.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+                fs::path out = outdir / ("leiden_results_res" + resolution_tag(row.resolution) +
+                                         output_format_extension(format));
+                write_results(out, format, membership, inv_map, /*threads=*/1);  // runs are already parallel
+                std::lock_guard<std::mutex> lk(log_mu);
+                std::cerr << "resolution=" << row.resolution << ": " << (long long) row.clusters
+                          << " communities, quality=" << row.quality << ", " << row.history.size() << " iterations, "
+                          << row.seconds << " s -> " << out << "\n";
+            }
+            igraph_vector_int_destroy(&membership);
+        });
+    }
+    pool.wait();
+
+    fs::path summary = outdir / "sweep_summary.tsv";
+    std::ofstream sout(summary);
+    if (!sout) throw std::runtime_error("Cannot open output for write: " + summary.string());
+    sout << "resolution\tclusters\tquality\tseconds\titerations\n";
+    for (const auto& row : rows)
+        sout << resolution_tag(row.resolution) << '\t' << (long long) row.clusters << '\t'
+             << row.quality << '\t' << row.seconds << '\t' << row.history.size() << '\n';
+    std::cerr << "Saved sweep summary to: " << summary << "\n";
+}
 
-    int u_idx = find_column_index(schema, {"src","source","u","from"});
-    int v_idx = find_column_index(schema, {"dst","target","v","to"});
-    if (u_idx == -1 || v_idx == -1) {
-        if (table->num_columns() < 2)
-            throw std::runtime_error("Parquet must have at least two columns for edges");
-        u_idx = 0; v_idx = 1;
+// ---------- Multi-seed ensemble ----------
+
+struct EnsembleRow {
+    unsigned long seed = 0;
+    igraph_integer_t clusters = 0;
+    igraph_real_t quality = 0.0;
+    double seconds = 0.0;
+    int iterations = 0;
+};
+
+// Runs n_runs seeded optimisations of the shared, read-only G on a thread pool.
+// Leaves either the best-quality membership or, with `consensus`, the
+// consensus partition in *membership: vertices joined by an edge on which at
+// least `threshold` of the runs agree end up together (connected components
+// of the agreeing edges). Co-assignment is only counted over edges, never as
+// an n x n matrix.
+static void run_ensemble(const igraph_t* G, const LeidenObjective& obj, double resolution,
+                         const ConvergenceOptions& conv, unsigned n_runs, unsigned long first_seed, unsigned threads,
+                         bool consensus, double threshold,
+                         const fs::path& outdir, igraph_vector_int_t* membership,
+                         igraph_integer_t* nb_clusters, igraph_real_t* quality) {
+    const igraph_integer_t n = igraph_vcount(G), m = igraph_ecount(G);
+    threads = resolve_threads(threads);
+    std::vector<EnsembleRow> rows(n_runs);
+    std::unique_ptr<std::atomic<uint32_t>[]> agree;
+    if (consensus) {
+        agree.reset(new std::atomic<uint32_t>[(size_t) m]);
+        parallel_for((size_t) m, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t i = b; i < e; ++i) agree[i].store(0, std::memory_order_relaxed);
+        });
     }
 
-    // Concatenate chunks if needed
-    auto concat_int64 = [](const std::shared_ptr<arrow::ChunkedArray>& col)
-            -> std::shared_ptr<arrow::Int64Array> {
-        if (col->num_chunks() == 1) {
-            return std::static_pointer_cast<arrow::Int64Array>(col->chunk(0));
+    std::mutex best_mu;
+    igraph_real_t best_quality = -std::numeric_limits<igraph_real_t>::infinity();
+    igraph_vector_int_t best; igraph_vector_int_init(&best, 0);
+
+    prime_graph_cache(G);
+    {
+        ThreadPool pool((unsigned) std::min<size_t>(threads, n_runs));
+        for (unsigned r = 0; r < n_runs; ++r) {
+            pool.submit([&, r](unsigned) {
+                auto t0 = std::chrono::steady_clock::now();
+                EnsembleRow& row = rows[r];
+                row.seed = first_seed + r;
+                // The default RNG is thread-local when igraph is built with TLS.
+                igraph_rng_seed(igraph_rng_default(), row.seed);
+                igraph_vector_int_t memb; igraph_vector_int_init(&memb, 0);
+                std::vector<IterationRecord> history;
+                run_igraph_leiden_converging(G, obj, resolution, /*beta=*/0.01, /*start=*/false, conv,
+                                             &memb, &row.clusters, &row.quality, &history);
+                row.iterations = (int) history.size();
+                row.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+                if (consensus) {
+                    const igraph_integer_t* mv = VECTOR(memb);
+                    for (igraph_integer_t e = 0; e < m; ++e)
+                        if (mv[IGRAPH_FROM(G, e)] == mv[IGRAPH_TO(G, e)])
+                            agree[(size_t) e].fetch_add(1, std::memory_order_relaxed);
+                }
+                std::lock_guard<std::mutex> lk(best_mu);
+                std::cerr << "seed=" << row.seed << ": " << (long long) row.clusters << " communities, quality="
+                          << row.quality << ", " << row.iterations << " iterations, " << row.seconds << " s\n";
+                if (row.quality > best_quality) {
+                    best_quality = row.quality;
+                    std::swap(best, memb);
+                }
+                igraph_vector_int_destroy(&memb);
+            });
         }
-        auto res = arrow::Concatenate(col->chunks(), arrow::default_memory_pool());
-        if (!res.ok()) throw std::runtime_error(res.status().ToString());
-        return std::static_pointer_cast<arrow::Int64Array>(*res);
-    };
-
-    auto col_u = concat_int64(table->column(u_idx));
-    auto col_v = concat_int64(table->column(v_idx));
-    if (col_u->length() != col_v->length())
-        throw std::runtime_error("Mismatched Parquet columns for edges");
-
-    std::vector<Edge> edges; edges.reserve(static_cast<size_t>(col_u->length()));
-    for (int64_t i = 0, n = col_u->length(); i < n; ++i) {
-        if (col_u->IsNull(i) || col_v->IsNull(i)) continue;
-        edges.push_back({ col_u->Value(i), col_v->Value(i) });
+        pool.wait();
     }
-    if (edges.empty()) throw std::runtime_error("No valid edges found in Parquet file");
-    return edges;
-}
 
-// ---------- TSV reader ----------
-
-static std::vector<Edge> read_tsv_edges(const fs::path& path) {
-    std::ifstream fin(path);
-    if (!fin) throw std::runtime_error("Cannot open TSV/CSV: " + path.string());
-    std::vector<Edge> edges; edges.reserve(1<<20);
-    std::string line; bool first=true;
-    while (std::getline(fin, line)) {
-        if (line.empty()) continue;
-        auto toks = split_ws(line);
-        if (toks.size() < 2) continue;
-        long long u,v;
-        if (first) {
-            long long tmp;
-            bool ok1 = parse_ll(toks[0], tmp); bool ok2 = parse_ll(toks[1], tmp);
-            if (!ok1 || !ok2) { first=false; continue; } // header line
-        }
-        if (!parse_ll(toks[0], u) || !parse_ll(toks[1], v)) continue;
-        edges.push_back({u,v});
-        first=false;
+    fs::path summary = outdir / "ensemble_summary.tsv";
+    std::ofstream sout(summary);
+    if (!sout) throw std::runtime_error("Cannot open output for write: " + summary.string());
+    sout << "seed\tclusters\tquality\tseconds\titerations\n";
+    for (const auto& row : rows)
+        sout << row.seed << '\t' << (long long) row.clusters << '\t' << row.quality << '\t' << row.seconds
+             << '\t' << row.iterations << '\n';
+    std::cerr << "Saved ensemble summary to: " << summary << "\n";
+
+    if (!consensus) {
+        std::swap(*membership, best);
+        igraph_vector_int_destroy(&best);
+        *nb_clusters = 0;
+        for (igraph_integer_t i = 0; i < n; ++i) *nb_clusters = std::max(*nb_clusters, VECTOR(*membership)[i] + 1);
+        *quality = best_quality;
+        return;
     }
-    return edges;
+    igraph_vector_int_destroy(&best);
+
+    const uint32_t need = (uint32_t) std::ceil(threshold * n_runs - 1e-9);
+    ConcurrentUnionFind uf(n, threads);
+    parallel_for((size_t) m, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i)
+            if (agree[i].load(std::memory_order_relaxed) >= std::max<uint32_t>(need, 1))
+                uf.unite(IGRAPH_FROM(G, i), IGRAPH_TO(G, i));
+    });
+    igraph_vector_int_resize(membership, n);
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) VECTOR(*membership)[i] = uf.find((int64_t) i);
+    });
+    if (igraph_reindex_membership(membership, nullptr, nb_clusters))
+        throw std::runtime_error("igraph_reindex_membership failed");
+    *quality = partition_quality(G, obj, resolution, membership, threads);
+    std::cerr << "Consensus of " << n_runs << " runs (edge agreement >= " << threshold << "): "
+              << (long long) *nb_clusters << " communities, quality=" << *quality << "\n";
 }
 
-// ---------- Graph build with robust remap ----------
-
-static void build_graph_from_edges(const std::vector<Edge>& edges_raw, igraph_t* g, bool directed,
-                                   std::vector<long long>* inv_map_out) {
-    // Map arbitrary node IDs to 0..N-1
-    std::unordered_map<long long, igraph_integer_t> idmap;
-    idmap.reserve(edges_raw.size()*2);
-    std::vector<igraph_integer_t> es; es.reserve(edges_raw.size()*2);
-
-    auto intern = [&](long long x)->igraph_integer_t {
-        auto it = idmap.find(x);
-        if (it != idmap.end()) return it->second;
-        igraph_integer_t id = static_cast<igraph_integer_t>(idmap.size());
-        idmap.emplace(x, id); return id;
-    };
-
-    for (const auto& e : edges_raw) {
-        es.push_back(intern(e.u));
-        es.push_back(intern(e.v));
+// ---------- Native engine ----------
+
+// Clusters G with the native multithreaded Leiden. With `validate`, also runs
+// igraph_community_leiden on the same graph and compares the two qualities;
+// the native partition is re-scored with partition_quality so that both
+// numbers are known to use the same convention.
+static void run_native_engine(const igraph_t* G, const LeidenObjective& obj, double resolution,
+                              const ConvergenceOptions& conv, uint64_t seed, unsigned threads, bool validate,
+                              igraph_vector_int_t* membership,
+                              igraph_integer_t* nb_clusters, igraph_real_t* quality, RunReport* report) {
+    auto t0 = std::chrono::steady_clock::now();
+    RunReport::Phase csr_phase(report, "csr_build");
+    csr_phase.add_edges((uint64_t) igraph_ecount(G));
+    CsrGraph csr;
+    {
+        std::vector<int64_t> src, dst;
+        edge_endpoints(G, src, dst, threads);
+        csr = build_csr(igraph_vcount(G), (int64_t) src.size(), src.data(), dst.data(),
+                        obj.edge_weights.empty() ? nullptr : obj.edge_weights.data(), threads);
     }
-
-    igraph_vector_int_t edges_vec;
-    igraph_vector_int_view(&edges_vec, es.data(), (long) es.size());
-
-    igraph_error_t err;
-    err = igraph_empty(g, (long) idmap.size(), directed ? IGRAPH_DIRECTED : IGRAPH_UNDIRECTED);
-    if (err) throw std::runtime_error("igraph_empty failed");
-    err = igraph_add_edges(g, &edges_vec, /*attr=*/nullptr);
-    if (err) throw std::runtime_error("igraph_add_edges failed");
-
-    if (inv_map_out) {
-        inv_map_out->resize(idmap.size());
-        for (const auto& kv : idmap) (*inv_map_out)[kv.second] = kv.first;
+    NativeLeidenOptions opt;
+    opt.modularity = obj.modularity;
+    opt.resolution = resolution;
+    opt.threads = threads;
+    opt.convergence = conv;
+    opt.seed = seed;
+    csr_phase.finish();
+    RunReport::Phase optimise_phase(report, "optimise");
+    NativeLeidenResult res = native_leiden(csr, opt);
+    optimise_phase.add_edges((uint64_t) igraph_ecount(G));
+    optimise_phase.set_iteration_seconds(res.iteration_seconds);
+    optimise_phase.finish();
+    if (report) {
+        report->set("iterations", (int64_t) res.iterations);
+        report->set("stop_reason", stop_reason_name(res.stop_reason));
     }
+    const double native_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cerr << "Native Leiden: " << res.iterations << " iterations (" << stop_reason_name(res.stop_reason)
+              << ") on " << resolve_threads(threads) << " threads in " << native_s << " s\n";
+
+    igraph_vector_int_resize(membership, (igraph_integer_t) res.membership.size());
+    std::copy(res.membership.begin(), res.membership.end(), VECTOR(*membership));
+    *nb_clusters = res.clusters;
+    *quality = res.quality;
+    if (!validate) return;
+
+    RunReport::Phase validate_phase(report, "validate");
+    const double rescored = partition_quality(G, obj, resolution, membership, threads);
+    auto t1 = std::chrono::steady_clock::now();
+    igraph_vector_int_t ref; igraph_vector_int_init(&ref, 0);
+    igraph_integer_t ref_clusters = 0;
+    igraph_real_t ref_quality = 0.0;
+    ConvergenceOptions ref_conv = conv;
+    ref_conv.log = false;
+    run_igraph_leiden_converging(G, obj, resolution, /*beta=*/0.01, /*start=*/false, ref_conv,
+                                 &ref, &ref_clusters, &ref_quality);
+    const double igraph_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+    igraph_vector_int_destroy(&ref);
+
+    std::cerr << "Validate: native " << (long long) res.clusters << " communities, quality=" << res.quality
+              << " (" << native_s << " s); igraph " << (long long) ref_clusters << " communities, quality="
+              << ref_quality << " (" << igraph_s << " s)\n";
+    if (std::fabs(rescored - res.quality) > 1e-9 * std::max(1.0, std::fabs(rescored)))
+        throw std::runtime_error("native quality " + std::to_string(res.quality) +
+                                 " disagrees with igraph-side scoring " + std::to_string(rescored));
+    if (res.quality < ref_quality - 1e-3 * std::fabs(ref_quality))
+        std::cerr << "Warning: native quality is below igraph's by " << ref_quality - res.quality << "\n";
 }
 
 // ---------- Main ----------
@@ -176,13 +332,62 @@ int main(int argc, char** argv) {
     auto print_usage = [&](const char* prog){
         std::cerr
           << "Usage (old): " << prog
-          << " <input.{tsv|csv|parquet}> <output_dir> <dataset_name> <objective: modularity|cpm> <resolution> [--directed]\n"
+          << " <input> <output_dir> <dataset_name> <objective: modularity|cpm> <resolution> [options]\n"
           << "Usage (new): " << prog
-          << " <input.{tsv|csv|parquet}> <output_dir> <objective: modularity|cpm> <resolution> [--directed]\n"
+          << " <input> <output_dir> <objective: modularity|cpm> <resolution> [options]\n"
+          << "  <input> is a .tsv/.csv/.txt (optionally .gz/.zst) or .parquet file, a directory of them,\n"
+          << "          or a quoted glob of shards\n"
+          << "Options:\n"
+          << "  --directed | --undirected   Graph direction (default undirected)\n"
+          << "  --threads N                 Worker threads (default: all cores)\n"
+          << "  --max-io-threads N          Sharded input: read at most N shards at once (default: one per thread)\n"
+          << "  --remap auto|dense|sort|hash  Node-id compaction strategy (default auto)\n"
+          << "  --assume-dense-ids          Ids are already 0..N-1; skip remapping\n"
+          << "  --weighted                  Read edge weights (TSV 3rd column, Parquet 'weight' column)\n"
+          << "  --dedup sum|max|first       Merge repeated edges ((u,v) = (v,u) when undirected) into one weighted edge\n"
+          << "  --self-loops keep|drop      Self-loop handling (default keep)\n"
+          << "  --low-memory                Remap ids over the loaded edges and free each stage early\n"
+          << "  --reorder degree|bfs|rcm|rabbit  Renumber vertices for cache locality before clustering (default none)\n"
+          << "  --cache-dir DIR             Where to keep the binary graph cache (default: next to the input)\n"
+          << "  --no-cache                  Neither read nor write the graph cache\n"
+          << "  --verify-cache              Re-hash the input before trusting a cache (default: size + mtime)\n"
+          << "  --resolutions a,b,c         Sweep: cluster once per resolution (graph loaded once)\n"
+          << "  --resolution-range lo:hi:n  Sweep n resolutions from lo to hi (geometric if both > 0)\n"
+          << "  --warm-start                Sweep: start each run from its neighbouring resolution\n"
+          << "  --ensemble N                Run N seeds in parallel on one shared graph; keep the best\n"
+          << "  --consensus                 Ensemble: output the consensus partition instead\n"
+          << "  --consensus-threshold F     Ensemble: edge kept if >= F of runs co-assign it (default 0.5)\n"
+          << "  --engine igraph|native      Clustering backend (default igraph); native uses --threads\n"
+          << "  --seed N                    Seed the optimiser; the same seed gives the same partition\n"
+          << "  --checkpoint-dir DIR        Save the partition and iteration state to DIR between iterations\n"
+          << "  --checkpoint-interval SEC   At most one checkpoint per SEC seconds (default: every iteration)\n"
+          << "  --resume                    Continue from the checkpoint in --checkpoint-dir, if there is one\n"
+          << "  --max-iterations N          Leiden iterations per run, -1 = until stable (default 50)\n"
+          << "  --min-gain F                Stop once an iteration improves quality by less than F (relative)\n"
+          << "  --min-moved F               Stop once an iteration moves fewer than F of the vertices\n"
+          << "  --time-budget SECONDS       Per run: keep the best partition found within this wall time\n"
+          << "  --validate                  Native: also run igraph on the same graph and compare quality\n"
+          << "  --split-components          Cluster each connected component separately (concurrently)\n"
+          << "  --trivial-size N            Split components: solve components of <= N vertices directly (default 3, max 8)\n"
+          << "  --reduce pendants|chains    Fold degree-1 (and degree-2 chain) vertices into their neighbours and drop\n"
+          << "                              isolated ones before clustering; results cover every vertex (default none)\n"
+          << "  --wcc                       Split clusters whose min cut is <= log10(size) until all are well-connected\n"
+          << "  --previous FILE             Incremental: re-cluster from this earlier leiden_results file\n"
+          << "  --added FILE                Incremental: edges to add (ids not in the graph become new vertices)\n"
+          << "  --removed FILE              Incremental: edges to remove, one matching edge per row\n"
+          << "  --delta-hops K              Incremental: optimise locally within K hops of changed edges (default 1)\n"
+          << "  --compare-full              Incremental: also re-cluster from scratch and report the speedup\n"
+          << "  --output-format tsv|parquet Result format (default tsv); Parquet has int64 node, int32 community\n"
+          << "  --report FILE               Write per-phase timings, peak memory and throughput as JSON\n"
+          << "  --cluster-stats FILE        Per-cluster size, internal/cut edges, density, conductance and\n"
+          << "                              modularity contribution (TSV), plus global modularity and CPM\n"
           << "Notes:\n"
           << "  - New form omits <dataset_name>; defaults to 'default_dataset'.\n"
           << "  - Graph is UNDIRECTED by default. Pass --directed to force (Leiden in igraph will error).\n"
-          << "  - Output TSV: <output_dir>/<objective>/leiden_results.tsv (1-indexed community IDs)\n";
+          << "  - Output: <output_dir>/<objective>/leiden_results.{tsv|parquet} (1-indexed community IDs,\n"
+          << "    rows ordered by node id)\n"
+          << "  - In sweep mode <resolution> may be omitted; outputs are leiden_results_res<r>.{tsv|parquet}\n"
+          << "    plus sweep_summary.tsv (resolution, clusters, quality, seconds).\n";
     };
 
     // --help
@@ -191,17 +396,178 @@ int main(int argc, char** argv) {
         return 0;
     }
 
-    if (argc < 5) {
+    // Split positionals from --flags so that flags may appear anywhere without
+    // shifting <objective>/<resolution>.
+    std::vector<std::string> pos;
+    bool directed = false; // default UNDIRECTED
+    unsigned threads = 0;  // 0 = all hardware threads
+    unsigned max_io_threads = 0;  // 0 = up to `threads` shards at once
+    GraphBuildOptions build;
+    bool weighted = false;
+    bool use_cache = true;
+    bool verify_cache = false;
+    fs::path cache_dir;
+    std::vector<double> sweep;   // non-empty => resolution sweep mode
+    bool warm_start = false;
+    unsigned ensemble = 0;       // > 0 => multi-seed ensemble mode
+    bool consensus = false;
+    double consensus_threshold = 0.5;
+    bool native = false;
+    bool validate = false;
+    bool seeded = false;
+    uint64_t seed = 0;
+    fs::path checkpoint_dir;
+    double checkpoint_interval = 0.0;
+    bool resume = false;
+    ConvergenceOptions convergence;
+    fs::path previous_path, added_path, removed_path;  // incremental mode when previous_path is set
+    int delta_hops = 1;
+    bool compare_full = false;
+    bool split_components = false;
+    bool wcc = false;
+    ComponentOptions components;
+    ReductionOptions reduction;
+    reduction.mode = Reduction::None;
+    OutputFormat output_format = OutputFormat::Tsv;
+    fs::path report_path;
+    fs::path cluster_stats_path;
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + flag);
+            return argv[++i];
+        };
+        try {
+            if (flag == "--directed") directed = true;
+            else if (flag == "--undirected") directed = false;
+            else if (flag == "--threads") threads = (unsigned) std::stoul(value());
+            else if (flag == "--max-io-threads") max_io_threads = (unsigned) std::stoul(value());
+            else if (flag == "--remap") build.remap = parse_remap_strategy(value());
+            else if (flag == "--assume-dense-ids") build.assume_dense_ids = true;
+            else if (flag == "--weighted") weighted = true;
+            else if (flag == "--dedup") { build.merge_duplicates = true; build.duplicates = parse_duplicate_policy(value()); }
+            else if (flag == "--self-loops") build.self_loops = parse_self_loop_policy(value());
+            else if (flag == "--low-memory") build.low_memory = true;
+            else if (flag == "--reorder") build.reorder = parse_vertex_order(value());
+            else if (flag == "--cache-dir") cache_dir = value();
+            else if (flag == "--no-cache") use_cache = false;
+            else if (flag == "--verify-cache") verify_cache = true;
+            else if (flag == "--resolutions") sweep = parse_resolution_list(value());
+            else if (flag == "--resolution-range") sweep = parse_resolution_range(value());
+            else if (flag == "--warm-start") warm_start = true;
+            else if (flag == "--ensemble") ensemble = (unsigned) std::stoul(value());
+            else if (flag == "--consensus") consensus = true;
+            else if (flag == "--consensus-threshold") consensus_threshold = std::stod(value());
+            else if (flag == "--engine") {
+                const std::string engine = value();
+                if (engine != "igraph" && engine != "native")
+                    throw std::invalid_argument("--engine expects igraph or native, got " + engine);
+                native = engine == "native";
+            }
+            else if (flag == "--validate") validate = true;
+            else if (flag == "--seed") { seed = std::stoull(value()); seeded = true; }
+            else if (flag == "--checkpoint-dir") checkpoint_dir = value();
+            else if (flag == "--checkpoint-interval") checkpoint_interval = std::stod(value());
+            else if (flag == "--resume") resume = true;
+            else if (flag == "--max-iterations") {
+                convergence.max_iterations = std::stoi(value());
+                if (convergence.max_iterations == 0) throw std::invalid_argument("--max-iterations must be non-zero");
+            }
+            else if (flag == "--min-gain") convergence.min_quality_gain = std::stod(value());
+            else if (flag == "--min-moved") convergence.min_moved_fraction = std::stod(value());
+            else if (flag == "--time-budget") convergence.time_budget_seconds = std::stod(value());
+            else if (flag == "--split-components") split_components = true;
+            else if (flag == "--trivial-size") {
+                components.trivial_size = std::stoi(value());
+                if (components.trivial_size < 0 || components.trivial_size > ComponentOptions::kMaxTrivialSize)
+                    throw std::invalid_argument("--trivial-size must be 0.." + std::to_string(ComponentOptions::kMaxTrivialSize));
+            }
+            else if (flag == "--reduce") reduction.mode = parse_reduction(value());
+            else if (flag == "--wcc") wcc = true;
+            else if (flag == "--previous") previous_path = value();
+            else if (flag == "--added") added_path = value();
+            else if (flag == "--removed") removed_path = value();
+            else if (flag == "--delta-hops") {
+                delta_hops = std::stoi(value());
+                if (delta_hops < 0) throw std::invalid_argument("--delta-hops must be >= 0");
+            }
+            else if (flag == "--compare-full") compare_full = true;
+            else if (flag == "--output-format") output_format = parse_output_format(value());
+            else if (flag == "--report") report_path = value();
+            else if (flag == "--cluster-stats") cluster_stats_path = value();
+            else if (flag == "--help" || flag == "-h") { print_usage(argv[0]); return 0; }
+            else if (flag.rfind("--", 0) == 0) { std::cerr << "Unknown flag: " << flag << "\n"; print_usage(argv[0]); return 1; }
+            else pos.push_back(flag);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // In sweep mode the positional resolution is optional.
+    if (!sweep.empty()) {
+        auto is_number = [](const std::string& x) {
+            char* end = nullptr; std::strtod(x.c_str(), &end);
+            return !x.empty() && end && *end == '\0';
+        };
+        if (pos.size() == 3 || (pos.size() == 4 && !is_number(pos[3]))) pos.push_back("1.0");
+    }
+
+    if (native && (!sweep.empty() || ensemble > 0)) {
+        std::cerr << "Error: --engine native does not support sweep or ensemble mode yet\n";
+        return 1;
+    }
+
+    if (previous_path.empty() && (!added_path.empty() || !removed_path.empty() || compare_full)) {
+        std::cerr << "Error: --added, --removed and --compare-full need --previous\n";
+        return 1;
+    }
+    if (!previous_path.empty() && (native || !sweep.empty() || ensemble > 0)) {
+        std::cerr << "Error: incremental mode (--previous) runs the igraph engine without sweep or ensemble\n";
+        return 1;
+    }
+
+    if (split_components && (native || !sweep.empty() || ensemble > 0 || !previous_path.empty())) {
+        std::cerr << "Error: --split-components runs the igraph engine without sweep, ensemble or --previous\n";
+        return 1;
+    }
+
+    if (reduction.mode != Reduction::None &&
+        (native || !sweep.empty() || ensemble > 0 || !previous_path.empty() || split_components || !checkpoint_dir.empty())) {
+        std::cerr << "Error: --reduce runs the igraph engine without sweep, ensemble, --previous, --split-components "
+                     "or --checkpoint-dir\n";
+        return 1;
+    }
+
+    if (resume && checkpoint_dir.empty()) {
+        std::cerr << "Error: --resume needs --checkpoint-dir\n";
+        return 1;
+    }
+    if (!checkpoint_dir.empty() && (native || !sweep.empty() || ensemble > 0 || !previous_path.empty() || split_components)) {
+        std::cerr << "Error: --checkpoint-dir runs the igraph engine without sweep, ensemble, --previous or --split-components\n";
+        return 1;
+    }
+    if (!checkpoint_dir.empty() && !seeded) {
+        seed = 1;  // resuming must redraw the same random numbers
+        seeded = true;
+    }
+
+    if (!cluster_stats_path.empty() && !sweep.empty()) {
+        std::cerr << "Error: --cluster-stats is not supported in sweep mode\n";
+        return 1;
+    }
+
+    if (pos.size() != 4 && pos.size() != 5) {
         print_usage(argv[0]);
         return 1;
     }
 
-    const fs::path input_path = argv[1];
-    const fs::path dataset_path = argv[2];
+    const fs::path input_path = pos[0];
+    const fs::path dataset_path = pos[1];
 
     // We accept either:
-    //   old: argv[3]=dataset_name, argv[4]=objective, argv[5]=resolution
-    //   new:               (no dataset_name) argv[3]=objective, argv[4]=resolution
+    //   old: dataset_name, objective, resolution
+    //   new: (no dataset_name) objective, resolution
     std::string dataset_name = "default_dataset";
     std::string objective;
     double resolution = 1.0;
@@ -212,26 +578,13 @@ int main(int argc, char** argv) {
         return s;
     };
 
-    // Try to detect whether argv[3] is an objective or a dataset name
-    if (argc >= 6) {
-        // Old form present (we have at least 6 args)
-        dataset_name = argv[3];
-        objective = argv[4];
-        resolution = std::stod(argv[5]);
-        // optional flags start at 6
+    if (pos.size() == 5) {
+        dataset_name = pos[2];
+        objective = pos[3];
+        resolution = std::stod(pos[4]);
     } else {
-        // New form (no dataset name)
-        objective = argv[3];
-        resolution = std::stod(argv[4]);
-        // optional flags start at 5
-    }
-
-    bool directed = false; // default UNDIRECTED
-    for (int i = (argc >= 6 ? 6 : 5); i < argc; ++i) {
-        const std::string flag = argv[i];
-        if (flag == "--directed") directed = true;
-        if (flag == "--undirected") directed = false;
-        if (flag == "--help" || flag == "-h") { print_usage(argv[0]); return 0; }
+        objective = pos[2];
+        resolution = std::stod(pos[3]);
     }
 
     std::transform(objective.begin(), objective.end(), objective.begin(), [](unsigned char c){return std::tolower(c);});
@@ -239,65 +592,272 @@ int main(int argc, char** argv) {
     std::string mode = (objective == "modularity") ? "modularity" : "CPM"; // default CPM if unknown
 
     try {
-        std::vector<Edge> edges;
-        if (has_ext(input_path, {".tsv", ".csv", ".txt"})) {
-            std::cerr << "Reading TSV/CSV edges from: " << input_path << "\n";
-            edges = read_tsv_edges(input_path);
-        } else if (has_ext(input_path, {".parquet"})) {
-            std::cerr << "Reading Parquet edges from: " << input_path << "\n";
-            edges = read_parquet_edges(input_path);
-        } else {
-            throw std::runtime_error("Unsupported input extension: " + input_path.extension().string());
+        RunReport report;
+        report.set("input", input_path.string());
+        report.set("objective", mode);
+        report.set("resolution", resolution);
+        report.set("engine", native ? "native" : "igraph");
+        report.set("threads", (int64_t) resolve_threads(threads));
+        if (seeded) report.set("seed", (int64_t) seed);
+
+        GraphLoadOptions load;
+        load.build = build;
+        load.build.directed = directed;
+        load.build.threads = threads;
+        load.weighted = weighted;
+        load.use_cache = use_cache;
+        load.verify_cache = verify_cache;
+        load.cache_dir = cache_dir;
+        load.max_io_threads = max_io_threads;
+        igraph_t G; std::vector<long long> inv_map; std::vector<double> weights;
+        load_graph(input_path, load, &G, &inv_map, &weights, &report);
+
+        // Incremental mode: apply the delta to the loaded graph, then map the
+        // previous membership onto the resulting vertices.
+        std::vector<int64_t> touched;
+        std::vector<igraph_integer_t> previous;
+        if (!previous_path.empty()) {
+            RunReport::Phase delta_phase(&report, "delta");
+            EdgeDelta delta;
+            if (!added_path.empty()) delta.added = read_edge_file(added_path, threads, weighted ? &delta.added_weights : nullptr);
+            if (!removed_path.empty()) delta.removed = read_edge_file(removed_path, threads);
+            delta_phase.add_edges(delta.added.size() + delta.removed.size());
+            const DeltaStats ds = apply_edge_delta(&G, weights, inv_map, delta, &touched, threads);
+            delta_phase.finish();
+            report.set("previous", previous_path.string());
+            report.set("added_edges", ds.added_edges);
+            report.set("removed_edges", ds.removed_edges);
+            report.set("missing_removals", ds.missing_removals);
+            report.set("new_vertices", ds.new_vertices);
+
+            RunReport::Phase previous_phase(&report, "previous");
+            previous = read_previous_membership(previous_path, inv_map, igraph_vcount(&G), threads);
+            previous_phase.finish();
         }
-
-        std::cerr << "Loaded " << edges.size() << " edges\n";
-
-        igraph_t G; std::vector<long long> inv_map; build_graph_from_edges(edges, &G, directed, &inv_map);
+        report.set("vertices", (int64_t) igraph_vcount(&G));
+        report.set("edges", (int64_t) igraph_ecount(&G));
         std::cerr << "Graph: " << (int)igraph_vcount(&G) << " vertices, " << (int)igraph_ecount(&G) << " edges\n";
 
-        if (directed) {
+        if (directed && !native) {
             std::cerr << "Warning: Leiden in igraph only supports undirected graphs; directed run will fail.\n";
         }
 
+        // Modes without per-iteration seeding draw from one seeded stream.
+        if (seeded) igraph_rng_seed(igraph_rng_default(), seed);
+
+        RunReport::Phase objective_phase(&report, "objective");
+        const LeidenObjective obj = make_objective(&G, mode == "modularity", std::move(weights));
+        objective_phase.finish();
+        fs::path outdir = dataset_path / mode;
+        fs::create_directories(outdir);
+
+        auto finish_report = [&] {
+            report.print(std::cerr);
+            if (report_path.empty()) return;
+            report.write_json(report_path);
+            std::cerr << "Saved run report to: " << report_path << "\n";
+        };
+
+        if (!sweep.empty()) {
+            RunReport::Phase sweep_phase(&report, "sweep");
+            sweep_phase.add_edges((uint64_t) igraph_ecount(&G) * sweep.size());
+            run_sweep(&G, obj, sweep, warm_start, convergence, threads, outdir, inv_map, output_format);
+            sweep_phase.finish();
+            report.set("resolutions", (int64_t) sweep.size());
+            igraph_destroy(&G);
+            finish_report();
+            return 0;
+        }
+
         igraph_vector_int_t membership; igraph_vector_int_init(&membership, 0);
 
-        // igraph 0.10.x API:
-        // igraph_community_leiden(graph, weights, initial, resolution, beta,
-        //                         start, n_iterations, membership, nb_clusters, quality)
         const igraph_real_t beta = 0.01;
         const igraph_bool_t start = 0;
-        //const igraph_integer_t n_iterations = -1; // until stable
-        const igraph_integer_t n_iterations = 50; // cap to avoid rare stalls
 
         igraph_integer_t nb_clusters = 0;
         igraph_real_t quality = 0.0;
 
-        igraph_error_t err = igraph_community_leiden(
-             &G,
-             /*weights*/      nullptr,
-             /*initial*/      nullptr,
-             /*resolution*/   resolution,
-             /*beta*/         beta,
-             /*start*/        start,
-             /*n_iterations*/ n_iterations,
-             /*membership*/   &membership,
-             /*nb_clusters*/  &nb_clusters,
-             /*quality*/      &quality);
-        if (err) throw std::runtime_error("igraph_community_leiden failed");
-
-        // Normalize to 0..C-1 (then we’ll output 1-indexed)
-        IGRAPH_CHECK(igraph_reindex_membership(&membership, /*new_to_old=*/nullptr, &nb_clusters));
+        if (native) {
+            ConvergenceOptions conv = convergence;
+            conv.log = true;
+            run_native_engine(&G, obj, resolution, conv, seeded ? seed : NativeLeidenOptions().seed, threads, validate,
+                              &membership, &nb_clusters, &quality, &report);
+        } else if (!previous_path.empty()) {
+            const igraph_integer_t n = igraph_vcount(&G);
+            if (igraph_vector_int_resize(&membership, n)) throw std::runtime_error("igraph_vector_int_resize failed");
+            std::copy(previous.begin(), previous.end(), VECTOR(membership));
+            IncrementalOptions iopt;
+            iopt.resolution = resolution;
+            iopt.beta = beta;
+            iopt.hops = delta_hops;
+            iopt.convergence = convergence;
+            iopt.convergence.log = true;
+            iopt.threads = threads;
+            const auto t_inc = std::chrono::steady_clock::now();
+            const IncrementalResult inc = recluster_incremental(&G, obj, touched, iopt, &membership, &nb_clusters,
+                                                                &quality, &report);
+            const double inc_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_inc).count();
+            const int64_t changed = count_moved(previous.data(), VECTOR(membership), (size_t) n);
+            report.set("affected_vertices", inc.affected_vertices);
+            report.set("local_vertices", inc.local_vertices);
+            report.set("local_edges", inc.local_edges);
+            report.set("changed_vertices", changed);
+            report.set("iterations", (int64_t) (inc.local_iterations + inc.global_iterations));
+            report.set("stop_reason", stop_reason_name(inc.stop_reason));
+            report.set("incremental_seconds", inc_s);
+            std::cerr << "Incremental: " << changed << " vertices changed community (" << inc.affected_vertices
+                      << " affected) in " << inc_s << " s\n";
+
+            if (compare_full) {
+                RunReport::Phase full_phase(&report, "full_rerun");
+                full_phase.add_edges((uint64_t) igraph_ecount(&G));
+                igraph_vector_int_t full; igraph_vector_int_init(&full, 0);
+                igraph_integer_t full_clusters = 0;
+                igraph_real_t full_quality = 0.0;
+                const auto t_full = std::chrono::steady_clock::now();
+                try {
+                    run_igraph_leiden_converging(&G, obj, resolution, beta, /*start=*/false, convergence,
+                                                 &full, &full_clusters, &full_quality);
+                } catch (...) {
+                    igraph_vector_int_destroy(&full);
+                    throw;
+                }
+                const double full_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_full).count();
+                igraph_vector_int_destroy(&full);
+                full_phase.finish();
+                const double speedup = inc_s > 0 ? full_s / inc_s : 0.0;
+                report.set("full_seconds", full_s);
+                report.set("full_quality", (double) full_quality);
+                report.set("full_clusters", (int64_t) full_clusters);
+                report.set("speedup", speedup);
+                std::cerr << "Full rerun: " << (long long) full_clusters << " communities, quality=" << full_quality
+                          << " in " << full_s << " s; incremental speedup " << speedup << "x\n";
+            }
+        } else if (split_components) {
+            components.beta = beta;
+            components.convergence = convergence;
+            components.threads = threads;
+            const ComponentStats cs = run_leiden_by_components(&G, obj, resolution, components, &membership,
+                                                               &nb_clusters, &quality, &report);
+            report.set("components", cs.components);
+            report.set("trivial_components", cs.trivial_components);
+            report.set("largest_component", cs.largest);
+        } else if (reduction.mode != Reduction::None) {
+            reduction.beta = beta;
+            reduction.convergence = convergence;
+            reduction.convergence.log = true;
+            reduction.threads = threads;
+            LeidenRunControl control;
+            control.seeded = seeded;
+            control.seed = seed;
+            std::vector<IterationRecord> history;
+            const ReductionStats rs = run_leiden_reduced(&G, obj, resolution, reduction, &membership, &nb_clusters,
+                                                         &quality, &history, &control, &report);
+            report.set("reduce", reduction_name(reduction.mode));
+            report.set("reduced_vertices", rs.reduced_vertices);
+            report.set("reduced_edges", rs.reduced_edges);
+            report.set("reduction_ratio", rs.ratio());
+            report.set("pendants_folded", rs.pendants);
+            report.set("chains_contracted", rs.chains);
+            report.set("groups_dropped", rs.dropped);
+            report.set("iterations", (int64_t) history.size());
+            report.set("stop_reason", stop_reason_name(rs.stop));
+        } else {
+            RunReport::Phase optimise_phase(&report, ensemble > 0 ? "ensemble" : "optimise");
+            optimise_phase.add_edges((uint64_t) igraph_ecount(&G) * std::max(ensemble, 1u));
+            if (ensemble > 0) {
+                run_ensemble(&G, obj, resolution, convergence, ensemble, seeded ? (unsigned long) seed : 1ul, threads,
+                             consensus, consensus_threshold, outdir, &membership, &nb_clusters, &quality);
+            } else {
+                ConvergenceOptions conv = convergence;
+                conv.log = true;
+                LeidenRunControl control;
+                control.seeded = seeded;
+                control.seed = seed;
+                int64_t checkpoints = 0;
+                double checkpoint_s = 0.0;
+                if (!checkpoint_dir.empty()) {
+                    LeidenCheckpoint cp;
+                    cp.seed = seed;
+                    cp.run_key = checkpoint_run_key(&G, obj.modularity, resolution, beta, seed, threads);
+                    const fs::path cp_path = checkpoint_path(checkpoint_dir, cp.run_key);
+                    report.set("checkpoint", cp_path.string());
+                    if (resume && read_checkpoint(cp_path, cp.run_key, &cp)) {
+                        if (igraph_vector_int_resize(&membership, (igraph_integer_t) cp.membership.size()))
+                            throw std::runtime_error("igraph_vector_int_resize failed");
+                        std::copy(cp.membership.begin(), cp.membership.end(), VECTOR(membership));
+                        control.resume = cp.history;
+                        report.set("resumed_iterations", (int64_t) cp.history.size());
+                        std::cerr << "Resuming from " << cp_path << " after iteration " << cp.history.size() << "\n";
+                    } else if (resume) {
+                        std::cerr << "No checkpoint at " << cp_path << "; starting from scratch\n";
+                    }
+                    auto last_write = std::chrono::steady_clock::now();
+                    control.checkpoint = [&, cp_path, run_key = cp.run_key](const igraph_vector_int_t* memb,
+                                                                         const std::vector<IterationRecord>& done) {
+                        const auto now = std::chrono::steady_clock::now();
+                        if (checkpoints > 0 && checkpoint_interval > 0 &&
+                            std::chrono::duration<double>(now - last_write).count() < checkpoint_interval)
+                            return;
+                        LeidenCheckpoint out;
+                        out.run_key = run_key;
+                        out.seed = seed;
+                        out.history = done;
+                        out.membership.assign(VECTOR(*memb), VECTOR(*memb) + igraph_vector_int_size(memb));
+                        write_checkpoint(cp_path, out);
+                        last_write = std::chrono::steady_clock::now();
+                        checkpoint_s += std::chrono::duration<double>(last_write - now).count();
+                        ++checkpoints;
+                    };
+                }
+                std::vector<IterationRecord> history;
+                const StopReason stop = run_igraph_leiden_converging(&G, obj, resolution, beta, start, conv,
+                                                                     &membership, &nb_clusters, &quality, &history,
+                                                                     &control);
+                if (!checkpoint_dir.empty()) {
+                    report.set("checkpoints_written", checkpoints);
+                    report.set("checkpoint_seconds", checkpoint_s);
+                }
+                std::vector<double> iteration_seconds;
+                for (const IterationRecord& r : history) iteration_seconds.push_back(r.seconds);
+                optimise_phase.set_iteration_seconds(std::move(iteration_seconds));
+                report.set("iterations", (int64_t) history.size());
+                report.set("stop_reason", stop_reason_name(stop));
+            }
+        }
+        if (wcc) {
+            const WccStats ws = split_poorly_connected(&G, obj.edge_weights, &membership, &nb_clusters, threads, &report);
+            quality = partition_quality(&G, obj, resolution, &membership, threads);
+            report.set("wcc_min_cuts", ws.checked);
+            report.set("wcc_splits", ws.splits);
+        }
+        report.set("clusters", (int64_t) nb_clusters);
+        report.set("quality", (double) quality);
 
         // std::cout << "Leiden clustering complete. Found " << static_cast<long long>(nb_clusters) << " communities." << std::endl;
         std::cout << "Leiden clustering complete. Found " << static_cast<long long>(nb_clusters)
             << " communities. Quality=" << quality << std::endl;
         
-        // Compute cluster sizes
-        std::vector<long long> cluster_sizes(nb_clusters, 0);
-        for (igraph_integer_t i = 0; i < igraph_vcount(&G); ++i) {
-            int cid = VECTOR(membership)[i];
-            if (cid >= 0 && cid < nb_clusters)
-                cluster_sizes[cid]++;
+        RunReport::Phase stats_phase(&report, "stats");
+        // Compute cluster sizes (and, with --cluster-stats, every per-cluster metric in the same pass)
+        std::vector<int64_t> cluster_sizes((size_t) nb_clusters, 0);
+        if (!cluster_stats_path.empty()) {
+            stats_phase.add_edges((uint64_t) igraph_ecount(&G));
+            const ClusterStats cs = run_cluster_stats(&G, obj.edge_weights, &membership, nb_clusters,
+                                                      mode == "modularity", resolution, threads);
+            write_cluster_stats(cluster_stats_path, cs, threads);
+            for (size_t c = 0; c < cs.clusters.size(); ++c) cluster_sizes[c] = cs.clusters[c].size;
+            report.set("modularity", cs.modularity);
+            report.set("cpm", cs.cpm);
+            std::cout << "Modularity=" << cs.modularity << " (resolution " << cs.modularity_resolution
+                      << "), CPM=" << cs.cpm << " (resolution " << cs.cpm_resolution << ")" << std::endl;
+            std::cerr << "Saved cluster stats to: " << cluster_stats_path << "\n";
+        } else {
+            for (igraph_integer_t i = 0; i < igraph_vcount(&G); ++i) {
+                igraph_integer_t cid = VECTOR(membership)[i];
+                if (cid >= 0 && cid < nb_clusters)
+                    cluster_sizes[(size_t) cid]++;
+            }
         }
 
         // Print summary of cluster sizes
@@ -307,51 +867,35 @@ int main(int argc, char** argv) {
         // }
 
         auto [min_it, max_it] = std::minmax_element(cluster_sizes.begin(), cluster_sizes.end());
-        long long total = 0;
+        int64_t total = 0;
         for (auto s : cluster_sizes) total += s;
         double avg = static_cast<double>(total) / nb_clusters;
         std::cout << "Smallest cluster: " << *min_it
                 << ", Largest: " << *max_it
                 << ", Average size: " << avg << std::endl;
 
-        // Build histogram: how many clusters have a given size
-        std::unordered_map<long long, long long> size_hist;
-        for (auto s : cluster_sizes) size_hist[s]++;
-
-        // Sort sizes for pretty output
-        std::vector<std::pair<long long, long long>> sorted_hist(size_hist.begin(), size_hist.end());
-        std::sort(sorted_hist.begin(), sorted_hist.end());
-
+        // Histogram: how many clusters have a given size, in size order
+        std::sort(cluster_sizes.begin(), cluster_sizes.end());
         std::cout << "Cluster size distribution:" << std::endl;
-        for (auto [size, count] : sorted_hist) {
-            std::cout << "  Clusters with size " << size << ": " << count << std::endl;
+        for (size_t i = 0; i < cluster_sizes.size(); ) {
+            size_t j = i;
+            while (j < cluster_sizes.size() && cluster_sizes[j] == cluster_sizes[i]) ++j;
+            std::cout << "  Clusters with size " << cluster_sizes[i] << ": " << (int64_t) (j - i) << std::endl;
+            i = j;
         }
+        stats_phase.finish();
 
-        // ----- TSV output (node_id \t community_1indexed) -----
-        fs::path outdir = dataset_path / mode;
-        fs::create_directories(outdir);
-        fs::path out = outdir / "leiden_results.tsv";
-
-        // Build pairs (orig_id, comm+1), sort by orig_id
-        std::vector<std::pair<long long, long long>> rows;
-        rows.reserve((size_t)igraph_vcount(&G));
-        for (igraph_integer_t i=0; i<igraph_vcount(&G); ++i) {
-            long long orig = inv_map[(size_t)i];
-            long long comm = (long long)VECTOR(membership)[i] + 1; // 1-indexed
-            rows.emplace_back(orig, comm);
-        }
-        std::sort(rows.begin(), rows.end(),
-                  [](const auto& a, const auto& b){ return a.first < b.first; });
-
-        std::ofstream jout(out);
-        if (!jout) throw std::runtime_error("Cannot open output for write: " + out.string());
-        for (auto &rc : rows) {
-            jout << rc.first << '\t' << rc.second << '\n';
-        }
-        std::cerr << "Saved TSV to: " << out << "\n";
+        // ----- Output (node_id, community_1indexed) -----
+        fs::path out = outdir / (std::string("leiden_results") + output_format_extension(output_format));
+        RunReport::Phase write_phase(&report, "write");
+        write_results(out, output_format, membership, inv_map, threads);
+        write_phase.add_bytes((uint64_t) fs::file_size(out));
+        write_phase.finish();
+        std::cerr << "Saved results to: " << out << "\n";
 
         igraph_vector_int_destroy(&membership);
         igraph_destroy(&G);
+        finish_report();
         return 0;
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
@@ -0,0 +1,743 @@
+// leiden_server: long-running clustering daemon.
+//
+// Graphs are loaded once (through the same loader, graph cache and id
+// remapping as leiden_igraph) into an in-memory registry and clustered on
+// request, so repeat queries pay only for the optimisation and the output.
+// The registry evicts its least recently used graphs once their estimated
+// footprint exceeds --memory-budget-mb; a graph still being clustered is
+// freed when its last job finishes.
+//
+// Protocol: one JSON object per line over a Unix domain socket, each
+// answered with one JSON line, {"ok":true,...} or {"ok":false,"error":"..."}.
+// Values are strings, numbers or booleans; paths are resolved by the server.
+//
+//   {"op":"load","graph":"g1","path":"/data/edges.parquet"}
+//       optional: weighted, dedup ("sum"|"max"|"first"),
+//       self_loops ("keep"|"drop"), reorder ("degree"|"bfs"|"rcm"|"rabbit"),
+//       cache (true), reload (false)
+//   {"op":"cluster","graph":"g1","objective":"cpm","resolution":0.01}
+//       optional: seed, beta (0.01), max_iterations (50), min_gain,
+//       output (path), format ("tsv"|"parquet"), cluster_stats (path)
+//   {"op":"stats"}  or  {"op":"stats","graph":"g1"}
+//   {"op":"evict","graph":"g1"}
+//   {"op":"shutdown"}
+//
+// Load and cluster requests run on a pool of --workers jobs, each with
+// --threads threads; stats, evict and shutdown are answered immediately.
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <igraph/igraph.h>
+
+#include "cluster_stats.h"
+#include "graph_loader.h"
+#include "igraph_backend.h"
+#include "parallel.h"
+#include "result_writer.h"
+#include "run_report.h"
+#include "thread_pool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// ---------- JSON (flat objects only) ----------
+
+struct JsonValue {
+    enum Kind { Null, Bool, Number, String } kind = Null;
+    bool b = false;
+    double num = 0.0;
+    std::string str;    // Number: the token as written, for exact integers
+};
+
+// A request: one JSON object whose values are scalars.
+class JsonRequest {
+public:
+    explicit JsonRequest(const std::string& text) : p_(text.data()), end_(text.data() + text.size()) {
+        skip_ws();
+        expect('{');
+        skip_ws();
+        if (peek() == '}') { ++p_; return; }
+        for (;;) {
+            skip_ws();
+            std::string key = parse_string();
+            skip_ws();
+            expect(':');
+            skip_ws();
+            fields_[key] = parse_value();
+            skip_ws();
+            if (peek() == ',') { ++p_; continue; }
+            expect('}');
+            break;
+        }
+        skip_ws();
+        if (p_ != end_) throw std::invalid_argument("trailing characters after JSON object");
+    }
+
+    bool has(const std::string& key) const { return fields_.count(key) != 0; }
+
+    std::string str(const std::string& key, const std::string& def = std::string()) const {
+        const JsonValue* v = find(key, JsonValue::String, "a string");
+        return v ? v->str : def;
+    }
+    double num(const std::string& key, double def) const {
+        const JsonValue* v = find(key, JsonValue::Number, "a number");
+        return v ? v->num : def;
+    }
+    // A non-negative integer, parsed from the token itself so values beyond
+    // 2^53 survive; fractions, exponents and signs are rejected.
+    uint64_t uint(const std::string& key, uint64_t def) const {
+        const JsonValue* v = find(key, JsonValue::Number, "a number");
+        if (!v) return def;
+        const std::string& t = v->str;
+        const bool digits = !t.empty() && std::all_of(t.begin(), t.end(), [](char c) { return c >= '0' && c <= '9'; });
+        if (!digits) throw std::invalid_argument("\"" + key + "\" must be a non-negative integer");
+        errno = 0;
+        const unsigned long long x = std::strtoull(t.c_str(), nullptr, 10);
+        if (errno == ERANGE) throw std::invalid_argument("\"" + key + "\" is out of range");
+        return (uint64_t) x;
+    }
+    bool flag(const std::string& key, bool def) const {
+        const JsonValue* v = find(key, JsonValue::Bool, "true or false");
+        return v ? v->b : def;
+    }
+    std::string required(const std::string& key) const {
+        if (!has(key)) throw std::invalid_argument("missing \"" + key + "\"");
+        return str(key);
+    }
+
+private:
+    const JsonValue* find(const std::string& key, JsonValue::Kind kind, const char* what) const {
+        auto it = fields_.find(key);
+        if (it == fields_.end() || it->second.kind == JsonValue::Null) return nullptr;
+        if (it->second.kind != kind) throw std::invalid_argument("\"" + key + "\" must be " + what);
+        return &it->second;
+    }
+
+    char peek() const { return p_ < end_ ? *p_ : '\0'; }
+    void skip_ws() { while (p_ < end_ && std::isspace((unsigned char) *p_)) ++p_; }
+    void expect(char c) {
+        if (peek() != c) throw std::invalid_argument(std::string("malformed JSON: expected '") + c + "'");
+        ++p_;
+    }
+    bool consume(const char* word) {
+        const size_t n = std::strlen(word);
+        if ((size_t) (end_ - p_) < n || std::strncmp(p_, word, n) != 0) return false;
+        p_ += n;
+        return true;
+    }
+
+    std::string parse_string() {
+        expect('"');
+        std::string out;
+        while (p_ < end_ && *p_ != '"') {
+            char c = *p_++;
+            if (c != '\\') { out += c; continue; }
+            if (p_ >= end_) break;
+            switch (char e = *p_++) {
+                case '"': case '\\': case '/': out += e; break;
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if (end_ - p_ < 4) throw std::invalid_argument("malformed JSON: bad \\u escape");
+                    const unsigned cp = (unsigned) std::stoul(std::string(p_, 4), nullptr, 16);
+                    p_ += 4;
+                    if (cp < 0x80) { out += (char) cp; }
+                    else if (cp < 0x800) { out += (char) (0xC0 | (cp >> 6)); out += (char) (0x80 | (cp & 0x3F)); }
+                    else {
+                        out += (char) (0xE0 | (cp >> 12));
+                        out += (char) (0x80 | ((cp >> 6) & 0x3F));
+                        out += (char) (0x80 | (cp & 0x3F));
+                    }
+                    break;
+                }
+                default: throw std::invalid_argument("malformed JSON: bad escape");
+            }
+        }
+        expect('"');
+        return out;
+    }
+
+    JsonValue parse_value() {
+        JsonValue v;
+        const char c = peek();
+        if (c == '"') { v.kind = JsonValue::String; v.str = parse_string(); }
+        else if (consume("true")) { v.kind = JsonValue::Bool; v.b = true; }
+        else if (consume("false")) { v.kind = JsonValue::Bool; v.b = false; }
+        else if (consume("null")) { v.kind = JsonValue::Null; }
+        else if (c == '{' || c == '[') throw std::invalid_argument("nested JSON values are not supported");
+        else {
+            char* stop = nullptr;
+            v.num = std::strtod(p_, &stop);
+            if (stop == p_ || stop > end_) throw std::invalid_argument("malformed JSON value");
+            v.kind = JsonValue::Number;
+            v.str.assign(p_, (size_t) (stop - p_));
+            p_ = stop;
+        }
+        return v;
+    }
+
+    const char* p_;
+    const char* end_;
+    std::map<std::string, JsonValue> fields_;
+};
+
+// A response line, fields in insertion order.
+class JsonResponse {
+public:
+    explicit JsonResponse(bool ok) { os_ << "{\"ok\":" << (ok ? "true" : "false"); }
+    JsonResponse& set(const std::string& key, const std::string& v) { return raw(key, json_string(v)); }
+    JsonResponse& set(const std::string& key, const char* v) { return raw(key, json_string(v)); }
+    JsonResponse& set(const std::string& key, bool v) { return raw(key, v ? "true" : "false"); }
+    JsonResponse& set(const std::string& key, int64_t v) { return raw(key, std::to_string(v)); }
+    JsonResponse& set(const std::string& key, double v) {
+        if (!std::isfinite(v)) return raw(key, "null");
+        std::ostringstream os;
+        os.precision(15);
+        os << v;
+        return raw(key, os.str());
+    }
+    JsonResponse& raw(const std::string& key, const std::string& json) {
+        os_ << ',' << json_string(key) << ':' << json;
+        return *this;
+    }
+    std::string line() const { return os_.str() + "}\n"; }
+
+private:
+    std::ostringstream os_;
+};
+
+std::string error_line(const std::string& what) {
+    return JsonResponse(false).set("error", what).line();
+}
+
+// ---------- Graph registry ----------
+
+struct GraphEntry {
+    std::string name;
+    fs::path path;
+    uint64_t build_key = 0;  // graph_build_key of the options it was loaded with
+    igraph_t g;
+    bool built = false;
+    std::vector<long long> inv_map;
+    std::vector<double> weights;
+    double load_seconds = 0.0;
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<int64_t> clusterings{0};
+
+    std::mutex objective_mu;
+    std::shared_ptr<const LeidenObjective> objectives[2];  // CPM, modularity; built on first use
+
+    GraphEntry() = default;
+    GraphEntry(const GraphEntry&) = delete;
+    GraphEntry& operator=(const GraphEntry&) = delete;
+    ~GraphEntry() { if (built) igraph_destroy(&g); }
+
+    // igraph keeps from/to and two sorted edge indices (four ids per edge)
+    // plus two per-vertex offset vectors; weights and the id map add theirs.
+    void estimate_bytes() {
+        const uint64_t n = (uint64_t) igraph_vcount(&g), m = (uint64_t) igraph_ecount(&g);
+        bytes = sizeof(igraph_integer_t) * (4 * m + 2 * (n + 1)) + sizeof(double) * weights.size() +
+                sizeof(long long) * inv_map.size();
+    }
+
+    std::shared_ptr<const LeidenObjective> objective(bool modularity) {
+        std::lock_guard<std::mutex> lk(objective_mu);
+        auto& obj = objectives[modularity ? 1 : 0];
+        if (!obj) {
+            auto made = std::make_shared<const LeidenObjective>(make_objective(&g, modularity, weights));
+            bytes += sizeof(double) * (made->edge_weights.size() + made->node_weights.size());
+            obj = std::move(made);
+        }
+        return obj;
+    }
+};
+
+class GraphRegistry {
+public:
+    explicit GraphRegistry(uint64_t budget) : budget_(budget) {}
+
+    // The named graph, marked most recently used; null when not loaded.
+    std::shared_ptr<GraphEntry> get(const std::string& name) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = index_.find(name);
+        if (it == index_.end()) return nullptr;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return *it->second;
+    }
+
+    // Adds (or replaces) e as the most recently used graph.
+    void insert(std::shared_ptr<GraphEntry> e) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = index_.find(e->name);
+        if (it != index_.end()) lru_.erase(it->second);
+        lru_.push_front(std::move(e));
+        index_[lru_.front()->name] = lru_.begin();
+    }
+
+    bool evict(const std::string& name) {
+        std::lock_guard<std::mutex> lk(mu_);
+        auto it = index_.find(name);
+        if (it == index_.end()) return false;
+        lru_.erase(it->second);
+        index_.erase(it);
+        return true;
+    }
+
+    // Evicts least recently used graphs other than `keep` until the total
+    // estimate fits the budget (0 = unlimited); returns their names.
+    std::vector<std::string> enforce_budget(const GraphEntry* keep) {
+        std::vector<std::string> evicted;
+        std::lock_guard<std::mutex> lk(mu_);
+        if (budget_ == 0) return evicted;
+        uint64_t total = total_locked();
+        for (auto it = lru_.end(); total > budget_ && it != lru_.begin(); ) {
+            --it;
+            if (it->get() == keep) continue;
+            total -= (*it)->bytes;
+            evicted.push_back((*it)->name);
+            index_.erase((*it)->name);
+            it = lru_.erase(it);
+        }
+        return evicted;
+    }
+
+    uint64_t bytes() const {
+        std::lock_guard<std::mutex> lk(mu_);
+        return total_locked();
+    }
+    uint64_t budget() const { return budget_; }
+
+    // Most recently used first.
+    std::vector<std::shared_ptr<GraphEntry>> list() const {
+        std::lock_guard<std::mutex> lk(mu_);
+        return std::vector<std::shared_ptr<GraphEntry>>(lru_.begin(), lru_.end());
+    }
+
+private:
+    uint64_t total_locked() const {
+        uint64_t total = 0;
+        for (const auto& e : lru_) total += e->bytes;
+        return total;
+    }
+
+    const uint64_t budget_;
+    mutable std::mutex mu_;
+    std::list<std::shared_ptr<GraphEntry>> lru_;  // front = most recently used
+    std::unordered_map<std::string, std::list<std::shared_ptr<GraphEntry>>::iterator> index_;
+};
+
+// ---------- Requests ----------
+
+struct ServerOptions {
+    fs::path socket_path = "leiden_server.sock";
+    uint64_t memory_budget = 0;  // bytes, 0 = unlimited
+    unsigned workers = 2;        // concurrent load / cluster jobs
+    unsigned threads = 0;        // per job
+};
+
+void describe(JsonResponse& r, const GraphEntry& e) {
+    r.set("graph", e.name)
+     .set("path", e.path.string())
+     .set("vertices", (int64_t) igraph_vcount(&e.g))
+     .set("edges", (int64_t) igraph_ecount(&e.g))
+     .set("weighted", !e.weights.empty())
+     .set("bytes", (int64_t) e.bytes.load())
+     .set("load_seconds", e.load_seconds)
+     .set("clusterings", e.clusterings.load());
+}
+
+void add_evicted(JsonResponse& r, const std::vector<std::string>& evicted) {
+    std::string list = "[";
+    for (size_t i = 0; i < evicted.size(); ++i) list += (i ? "," : "") + json_string(evicted[i]);
+    r.raw("evicted", list + "]");
+}
+
+std::string handle_load(const JsonRequest& req, GraphRegistry& registry, const ServerOptions& so) {
+    const std::string name = req.required("graph");
+    const fs::path path = req.required("path");
+    GraphLoadOptions lo;
+    // igraph_community_leiden rejects directed graphs, so one could never be clustered.
+    if (req.flag("directed", false)) throw std::invalid_argument("directed graphs are not supported");
+    lo.build.threads = so.threads;
+    if (req.has("dedup")) {
+        lo.build.merge_duplicates = true;
+        lo.build.duplicates = parse_duplicate_policy(req.str("dedup"));
+    }
+    if (req.has("self_loops")) lo.build.self_loops = parse_self_loop_policy(req.str("self_loops"));
+    if (req.has("reorder")) lo.build.reorder = parse_vertex_order(req.str("reorder"));
+    lo.weighted = req.flag("weighted", false);
+    lo.use_cache = req.flag("cache", true);
+    const uint64_t build_key = graph_build_key(lo.build, lo.weighted);
+
+    // A held graph is reused only if it was built the same way; a load with
+    // other options replaces it.
+    if (!req.flag("reload", false)) {
+        if (auto e = registry.get(name)) {
+            if (e->path == path && e->build_key == build_key) {
+                JsonResponse r(true);
+                describe(r, *e);
+                return r.set("cached", true).line();
+            }
+        }
+    }
+
+    auto e = std::make_shared<GraphEntry>();
+    e->name = name;
+    e->path = path;
+    e->build_key = build_key;
+    const auto t0 = std::chrono::steady_clock::now();
+    load_graph(path, lo, &e->g, &e->inv_map, &e->weights, nullptr);
+    e->built = true;
+    prime_graph_cache(&e->g);  // concurrent jobs only read the graph
+    e->load_seconds = seconds_since(t0);
+    e->estimate_bytes();
+
+    registry.insert(e);
+    const std::vector<std::string> evicted = registry.enforce_budget(e.get());
+    std::cerr << "Loaded graph '" << name << "' from " << path << " in " << e->load_seconds << " s ("
+              << e->bytes / 1e6 << " MB)\n";
+    JsonResponse r(true);
+    describe(r, *e);
+    r.set("cached", false);
+    add_evicted(r, evicted);
+    return r.line();
+}
+
+std::string handle_cluster(const JsonRequest& req, GraphRegistry& registry, const ServerOptions& so) {
+    const std::string name = req.required("graph");
+    auto e = registry.get(name);
+    if (!e) throw std::invalid_argument("graph '" + name + "' is not loaded");
+
+    std::string objective = req.str("objective", "cpm");
+    std::transform(objective.begin(), objective.end(), objective.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (objective != "modularity" && objective != "cpm")
+        throw std::invalid_argument("objective must be modularity or cpm");
+    const bool modularity = objective == "modularity";
+    const double resolution = req.num("resolution", 1.0);
+    const double beta = req.num("beta", 0.01);
+    ConvergenceOptions conv;
+    conv.max_iterations = (int) req.num("max_iterations", conv.max_iterations);
+    if (conv.max_iterations == 0) throw std::invalid_argument("max_iterations must be non-zero");
+    conv.min_quality_gain = req.num("min_gain", conv.min_quality_gain);
+    const OutputFormat format = parse_output_format(req.str("format", "tsv"));
+
+    std::shared_ptr<const LeidenObjective> obj = e->objective(modularity);
+    const std::vector<std::string> evicted = registry.enforce_budget(e.get());
+
+    igraph_vector_int_t membership;
+    igraph_vector_int_init(&membership, 0);
+    igraph_integer_t nb_clusters = 0;
+    igraph_real_t quality = 0.0;
+    JsonResponse r(true);
+    try {
+        // igraph's default RNG is per thread (igraph built with thread-local
+        // storage), so seeding here only affects this job. A seeded job is
+        // reseeded per iteration exactly as `leiden_igraph --seed` is, so
+        // both give the same partition.
+        LeidenRunControl control;
+        if (req.has("seed")) {
+            control.seeded = true;
+            control.seed = req.uint("seed", 0);
+        }
+        const auto t0 = std::chrono::steady_clock::now();
+        std::vector<IterationRecord> history;
+        const StopReason stop = run_igraph_leiden_converging(&e->g, *obj, resolution, beta, /*start=*/false, conv,
+                                                             &membership, &nb_clusters, &quality, &history, &control);
+        const double cluster_s = seconds_since(t0);
+        e->clusterings.fetch_add(1);
+        r.set("graph", name)
+         .set("objective", objective)
+         .set("resolution", resolution)
+         .set("clusters", (int64_t) nb_clusters)
+         .set("quality", (double) quality)
+         .set("iterations", (int64_t) history.size())
+         .set("stop_reason", stop_reason_name(stop))
+         .set("cluster_seconds", cluster_s);
+
+        if (req.has("output")) {
+            const fs::path out = req.str("output");
+            const auto tw = std::chrono::steady_clock::now();
+            write_clusters(out, format, reinterpret_cast<const int64_t*>(VECTOR(membership)),
+                           (size_t) igraph_vector_int_size(&membership),
+                           e->inv_map.empty() ? nullptr : reinterpret_cast<const int64_t*>(e->inv_map.data()),
+                           /*community_base=*/1, so.threads);
+            r.set("output", out.string()).set("write_seconds", seconds_since(tw));
+        }
+        if (req.has("cluster_stats")) {
+            const fs::path out = req.str("cluster_stats");
+            const ClusterStats cs = run_cluster_stats(&e->g, obj->edge_weights, &membership, nb_clusters, modularity,
+                                                      resolution, so.threads);
+            write_cluster_stats(out, cs, so.threads);
+            r.set("cluster_stats", out.string()).set("modularity", cs.modularity).set("cpm", cs.cpm);
+        }
+    } catch (...) {
+        igraph_vector_int_destroy(&membership);
+        throw;
+    }
+    igraph_vector_int_destroy(&membership);
+    add_evicted(r, evicted);
+    return r.line();
+}
+
+std::string handle_stats(const JsonRequest& req, GraphRegistry& registry) {
+    JsonResponse r(true);
+    if (req.has("graph")) {
+        auto e = registry.get(req.str("graph"));
+        if (!e) throw std::invalid_argument("graph '" + req.str("graph") + "' is not loaded");
+        describe(r, *e);
+        return r.line();
+    }
+    std::string graphs = "[";
+    bool first = true;
+    for (const auto& e : registry.list()) {
+        JsonResponse g(true);
+        describe(g, *e);
+        std::string line = g.line();
+        line.pop_back();                                   // newline
+        graphs += (first ? "" : ",") + ("{" + line.substr(line.find(',') + 1));  // drop "ok"
+        first = false;
+    }
+    r.set("bytes", (int64_t) registry.bytes()).set("budget", (int64_t) registry.budget()).raw("graphs", graphs + "]");
+    return r.line();
+}
+
+// ---------- Socket server ----------
+
+int stop_pipe[2] = {-1, -1};
+
+void request_stop() {
+    const char c = 1;
+    (void) !::write(stop_pipe[1], &c, 1);
+}
+
+void on_signal(int) { request_stop(); }
+
+bool send_all(int fd, const std::string& s) {
+    for (size_t off = 0; off < s.size(); ) {
+        const ssize_t n = ::send(fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        off += (size_t) n;
+    }
+    return true;
+}
+
+class Server {
+public:
+    explicit Server(const ServerOptions& so) : so_(so), registry_(so.memory_budget), pool_(so.workers) {}
+
+    void serve_connection(int fd) {
+        constexpr size_t kMaxRequest = size_t(1) << 20;
+        std::string buf;
+        char chunk[4096];
+        for (;;) {
+            const ssize_t n = ::recv(fd, chunk, sizeof chunk, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            buf.append(chunk, (size_t) n);
+            for (size_t nl; (nl = buf.find('\n')) != std::string::npos; ) {
+                const std::string line = buf.substr(0, nl);
+                buf.erase(0, nl + 1);
+                if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+                if (!send_all(fd, handle(line))) return;
+            }
+            if (buf.size() > kMaxRequest) {
+                send_all(fd, error_line("request longer than 1 MB"));
+                return;
+            }
+        }
+    }
+
+private:
+    std::string handle(const std::string& line) {
+        try {
+            const JsonRequest req(line);
+            const std::string op = req.required("op");
+            if (op == "load") return run_job([&] { return handle_load(req, registry_, so_); });
+            if (op == "cluster") return run_job([&] { return handle_cluster(req, registry_, so_); });
+            if (op == "stats") return handle_stats(req, registry_);
+            if (op == "evict") {
+                const std::string name = req.required("graph");
+                return JsonResponse(true).set("graph", name).set("evicted", registry_.evict(name)).line();
+            }
+            if (op == "shutdown") {
+                request_stop();
+                return JsonResponse(true).line();
+            }
+            return error_line("unknown op '" + op + "'");
+        } catch (const std::exception& e) {
+            return error_line(e.what());
+        }
+    }
+
+    // Runs fn on the job pool and waits for its response line.
+    template <class Fn>
+    std::string run_job(Fn&& fn) {
+        std::promise<std::string> done;
+        std::future<std::string> result = done.get_future();
+        pool_.submit([&](unsigned) {
+            // igraph's default handler aborts the process; with this one an
+            // igraph error comes back as an error code, which the job turns
+            // into an exception and the client into an error reply. The
+            // handler is thread-local when igraph is built with TLS, so every
+            // job sets it on the worker it runs on.
+            igraph_set_error_handler(igraph_error_handler_printignore);
+            try { done.set_value(fn()); }
+            catch (...) { done.set_exception(std::current_exception()); }
+        });
+        return result.get();
+    }
+
+    const ServerOptions so_;
+    GraphRegistry registry_;
+    ThreadPool pool_;
+};
+
+struct Connection {
+    int fd;
+    std::thread thread;
+    std::shared_ptr<std::atomic<bool>> finished;
+};
+
+int run_server(const ServerOptions& so) {
+    if (::pipe(stop_pipe) != 0) throw std::runtime_error("pipe failed");
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    const int lfd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0) throw std::runtime_error("socket failed");
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    const std::string sp = so.socket_path.string();
+    if (sp.size() >= sizeof addr.sun_path) throw std::runtime_error("socket path too long: " + sp);
+    std::memcpy(addr.sun_path, sp.c_str(), sp.size() + 1);
+    ::unlink(sp.c_str());
+    if (::bind(lfd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0 || ::listen(lfd, 64) != 0) {
+        ::close(lfd);
+        throw std::runtime_error("cannot listen on " + sp + ": " + std::strerror(errno));
+    }
+    std::cerr << "leiden_server listening on " << sp << " (" << so.workers << " workers x "
+              << resolve_threads(so.threads) << " threads, memory budget "
+              << (so.memory_budget ? std::to_string(so.memory_budget >> 20) + " MB" : std::string("unlimited"))
+              << ")\n";
+
+    Server server(so);
+    std::list<Connection> conns;
+    auto reap = [&](bool all) {
+        for (auto it = conns.begin(); it != conns.end(); ) {
+            if (all || *it->finished) {
+                if (all) ::shutdown(it->fd, SHUT_RDWR);  // unblocks a pending recv
+                it->thread.join();
+                ::close(it->fd);
+                it = conns.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    };
+    for (;;) {
+        pollfd fds[2] = {{lfd, POLLIN, 0}, {stop_pipe[0], POLLIN, 0}};
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+        const int cfd = ::accept(lfd, nullptr, nullptr);
+        if (cfd < 0) continue;
+        reap(false);
+        auto finished = std::make_shared<std::atomic<bool>>(false);
+        conns.push_back(Connection{cfd, std::thread([&server, cfd, finished] {
+            server.serve_connection(cfd);
+            *finished = true;
+        }), finished});
+    }
+    std::cerr << "leiden_server shutting down\n";
+    ::close(lfd);
+    ::unlink(sp.c_str());
+    reap(true);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    auto print_usage = [&](const char* prog) {
+        std::cerr
+          << "Usage: " << prog << " [options]\n"
+          << "Options:\n"
+          << "  --socket PATH           Unix socket to listen on (default leiden_server.sock)\n"
+          << "  --memory-budget-mb N    Evict least recently used graphs above N MB (default: half of RAM, 0 = no limit)\n"
+          << "  --workers N             Load / cluster jobs run at once (default 2)\n"
+          << "  --threads N             Threads per job for loading, stats and output (default: cores / workers)\n"
+          << "Requests are JSON lines: {\"op\":\"load\"|\"cluster\"|\"stats\"|\"evict\"|\"shutdown\", ...};\n"
+          << "see the comment at the top of src/leiden_server.cpp or the README.\n";
+    };
+
+    ServerOptions so;
+    const long pages = ::sysconf(_SC_PHYS_PAGES), page_size = ::sysconf(_SC_PAGE_SIZE);
+    if (pages > 0 && page_size > 0) so.memory_budget = (uint64_t) pages * (uint64_t) page_size / 2;
+    bool threads_set = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + flag);
+            return argv[++i];
+        };
+        try {
+            if (flag == "--socket") so.socket_path = value();
+            else if (flag == "--memory-budget-mb") so.memory_budget = (uint64_t) std::stoull(value()) << 20;
+            else if (flag == "--workers") so.workers = std::max(1u, (unsigned) std::stoul(value()));
+            else if (flag == "--threads") { so.threads = (unsigned) std::stoul(value()); threads_set = true; }
+            else if (flag == "--help" || flag == "-h") { print_usage(argv[0]); return 0; }
+            else { std::cerr << "Unknown argument: " << flag << "\n"; print_usage(argv[0]); return 1; }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+    if (!threads_set) so.threads = std::max(1u, resolve_threads(0) / so.workers);
+
+    try {
+        return run_server(so);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 2;
+    }
+}
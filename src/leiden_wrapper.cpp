@@ -1,26 +1,28 @@
 #include <iostream>
+#include <vector>
 #include "run_leiden.h"
 
-void test_modularity_option(int64_t modularity_option, const std::string& name) {
-    std::cout << "Testing Leiden algorithm with " << name << "..." << std::endl;
+static const int64_t NumNodes = 8; // Number of nodes
 
-    // Example graph
-    int64_t src[] = {0, 1, 2, 3, 4, 5, 6, 7};
-    int64_t dst[] = {1, 2, 3, 4, 5, 6, 7, 0};
-    int64_t NumEdges = sizeof(src) / sizeof(src[0]);  // Number of edges
-    int64_t NumNodes = 8; // Number of nodes
+void test_modularity_option(LeidenGraph* graph, int64_t modularity_option, const std::string& name) {
+    std::cout << "Testing Leiden algorithm with " << name << "..." << std::endl;
 
     // Array to store community assignments
     int64_t communities[NumNodes];
 
-    // Variable to store number of communities
+    // Variables to store number of communities and partition quality
     int64_t numCommunities = 0;
+    double quality = 0.0;
 
-    // Run Leiden with the selected modularity option
-    run_leiden(src, dst, NumEdges, NumNodes, modularity_option, static_cast<double>(0.1), communities, numCommunities);
+    // Run Leiden with the selected modularity option on the shared graph
+    if (c_leidenRun(graph, modularity_option, static_cast<double>(0.1), communities, &numCommunities, &quality) != 0) {
+        std::cout << name << " run failed" << std::endl;
+        return;
+    }
 
     // Print community assignments
-    std::cout << name << " Community Assignments (" << numCommunities + 1 << " communities found):" << std::endl;
+    std::cout << name << " Community Assignments (" << numCommunities << " communities found, quality "
+              << quality << "):" << std::endl;
     for (int64_t i = 0; i < NumNodes; i++) {
         std::cout << "Node " << i << " -> Community " << communities[i] << std::endl;
     }
@@ -30,12 +32,62 @@ void test_modularity_option(int64_t modularity_option, const std::string& name)
 int main() {
     std::cout << "Starting Leiden algorithm tests..." << std::endl;
 
-    test_modularity_option(CPM, "CPM");
-    test_modularity_option(MODULARITY, "Modularity");
-    test_modularity_option(SIGNIFICANCE, "Significance");
-    test_modularity_option(SURPRISE, "Surprise");
-    test_modularity_option(RBCONFIGURATION, "RBConfiguration");
-    test_modularity_option(RBER, "RBER");
+    // Example graph, built once and reused for every objective
+    int64_t src[] = {0, 1, 2, 3, 4, 5, 6, 7};
+    int64_t dst[] = {1, 2, 3, 4, 5, 6, 7, 0};
+    int64_t NumEdges = sizeof(src) / sizeof(src[0]);  // Number of edges
+    LeidenGraph* graph = c_leidenGraphCreate(src, dst, NumEdges, NumNodes);
+    if (!graph) return 1;
+
+    test_modularity_option(graph, CPM, "CPM");
+    test_modularity_option(graph, MODULARITY, "Modularity");
+    test_modularity_option(graph, SIGNIFICANCE, "Significance");
+    test_modularity_option(graph, SURPRISE, "Surprise");
+    test_modularity_option(graph, RBCONFIGURATION, "RBConfiguration");
+    test_modularity_option(graph, RBER, "RBER");
+
+    // Native multithreaded engine on the same handle
+    for (int64_t option : {CPM, MODULARITY}) {
+        int64_t communities[NumNodes];
+        int64_t numCommunities = 0;
+        double quality = 0.0;
+        if (c_leidenRunNative(graph, option, 0.1, 2, communities, &numCommunities, &quality) != 0 || numCommunities <= 0) {
+            std::cout << "Native run failed" << std::endl;
+            return 1;
+        }
+        std::cout << "Native " << (option == CPM ? "CPM" : "Modularity") << ": " << numCommunities
+                  << " communities, quality " << quality << std::endl;
+    }
+
+    c_leidenGraphDestroy(graph);
+
+    // The one-shot wrapper must report the same kind of count
+    int64_t communities[NumNodes];
+    int64_t found = c_runLeiden(src, dst, NumEdges, NumNodes, CPM, 0.1, communities, 0);
+    if (found <= 0) {
+        std::cout << "c_runLeiden failed" << std::endl;
+        return 1;
+    }
+
+    // Batch API: the ring twice plus an edgeless 3-node graph in one call
+    {
+        const int64_t edgeOffsets[] = {0, NumEdges, NumEdges, 2 * NumEdges};
+        const int64_t nodeCounts[] = {NumNodes, 3, NumNodes};
+        std::vector<int64_t> batchSrc(2 * NumEdges), batchDst(2 * NumEdges);
+        for (int64_t i = 0; i < 2 * NumEdges; i++) {
+            batchSrc[i] = src[i % NumEdges];
+            batchDst[i] = dst[i % NumEdges];
+        }
+        int64_t batchCommunities[2 * NumNodes + 3];
+        int64_t batchCounts[3];
+        if (c_runLeidenBatch(batchSrc.data(), batchDst.data(), nullptr, edgeOffsets, nodeCounts, 3, CPM, 0.1, nullptr, 2,
+                             batchCommunities, batchCounts, nullptr) != 0 || batchCounts[1] != 3) {
+            std::cout << "c_runLeidenBatch failed" << std::endl;
+            return 1;
+        }
+        std::cout << "Batch: " << batchCounts[0] << ", " << batchCounts[1] << " and " << batchCounts[2]
+                  << " communities" << std::endl;
+    }
 
     std::cout << "All modularity tests completed!" << std::endl;
     return 0;
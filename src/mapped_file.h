@@ -0,0 +1,48 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+// Read-only memory mapping of a whole file (RAII).
+
+#include <cstddef>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFile {
+public:
+    // `advice` is passed to madvise (MADV_SEQUENTIAL for one-pass parsing,
+    // MADV_WILLNEED to prefetch a file that is about to be read in full).
+    explicit MappedFile(const std::filesystem::path& path, int advice = MADV_SEQUENTIAL) {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) throw std::runtime_error("Cannot open: " + path.string());
+        struct stat st;
+        if (::fstat(fd_, &st) != 0) { ::close(fd_); throw std::runtime_error("Cannot stat: " + path.string()); }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ == 0) return;
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (p == MAP_FAILED) { ::close(fd_); throw std::runtime_error("Cannot mmap: " + path.string()); }
+        ::madvise(p, size_, advice);
+        data_ = static_cast<const char*>(p);
+    }
+    ~MappedFile() {
+        if (data_) ::munmap(const_cast<char*>(data_), size_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    int fd_ = -1;
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif // MAPPED_FILE_H
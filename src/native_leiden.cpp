@@ -0,0 +1,557 @@
+// Native multithreaded Leiden.
+//
+// Each iteration follows Traag et al.: local moving, refinement of every
+// community into well-connected sub-communities, aggregation of the refined
+// partition, repeated on the aggregate until local moving stops merging.
+// Work is split over std::threads with parallel_for:
+//   - local moving runs asynchronously: threads sweep their vertex blocks,
+//     reading neighbours' labels and community totals through relaxed atomics
+//     and re-activating neighbours of every moved vertex;
+//   - refinement merges singletons only, claiming a singleton with a CAS so
+//     two threads can never pull a vertex into two communities;
+//   - aggregation builds each super-vertex row in thread-local buffers that
+//     are concatenated after a prefix sum.
+// Per-thread scratch is a small open-addressing community -> weight map
+// sized to the vertex degree, not to the number of communities.
+
+#include "native_leiden.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "parallel.h"
+#include "radix_sort.h"
+
+namespace {
+
+template <class T>
+using AtomicArray = std::unique_ptr<std::atomic<T>[]>;
+
+template <class T>
+AtomicArray<T> make_atomic_array(int64_t n, T init, unsigned threads) {
+    AtomicArray<T> a(new std::atomic<T>[(size_t) n]);
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) a[i].store(init, std::memory_order_relaxed);
+    });
+    return a;
+}
+
+inline void atomic_add(std::atomic<double>& a, double v) {
+    double cur = a.load(std::memory_order_relaxed);
+    while (!a.compare_exchange_weak(cur, cur + v, std::memory_order_relaxed)) {}
+}
+
+inline uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Community -> summed edge weight for the neighbourhood of one vertex.
+class DeltaMap {
+public:
+    void prepare(size_t degree) {
+        size_t cap = 16;
+        while (cap < 2 * degree + 2) cap <<= 1;
+        if (cap > keys_.size()) {
+            keys_.assign(cap, -1);
+            vals_.assign(cap, 0.0);
+        }
+        mask_ = keys_.size() - 1;
+    }
+
+    void add(int64_t key, double w) {
+        size_t h = splitmix64((uint64_t) key) & mask_;
+        while (keys_[h] != key) {
+            if (keys_[h] < 0) {
+                keys_[h] = key;
+                vals_[h] = 0.0;
+                used_.push_back(h);
+                break;
+            }
+            h = (h + 1) & mask_;
+        }
+        vals_[h] += w;
+    }
+
+    double get(int64_t key) const {
+        for (size_t h = splitmix64((uint64_t) key) & mask_; keys_[h] >= 0; h = (h + 1) & mask_)
+            if (keys_[h] == key) return vals_[h];
+        return 0.0;
+    }
+
+    size_t size() const { return used_.size(); }
+    int64_t key(size_t i) const { return keys_[used_[i]]; }
+    double value(size_t i) const { return vals_[used_[i]]; }
+
+    void clear() {
+        for (size_t h : used_) keys_[h] = -1;
+        used_.clear();
+    }
+
+private:
+    std::vector<int64_t> keys_;
+    std::vector<double> vals_;
+    std::vector<size_t> used_;
+    size_t mask_ = 0;
+};
+
+struct Scratch {
+    DeltaMap map;
+    std::vector<std::pair<int64_t, double>> candidates;
+};
+
+// Relabels labels[i] in 0..range-1 to 0..k-1 keeping their order; returns k.
+int64_t renumber(std::vector<int64_t>& labels, int64_t range, unsigned threads) {
+    AtomicArray<uint8_t> seen = make_atomic_array<uint8_t>(range, 0, threads);
+    parallel_for(labels.size(), threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) seen[(size_t) labels[i]].store(1, std::memory_order_relaxed);
+    });
+    std::vector<int64_t> id((size_t) range);
+    int64_t k = 0;
+    for (int64_t c = 0; c < range; ++c) id[(size_t) c] = seen[(size_t) c].load(std::memory_order_relaxed) ? k++ : -1;
+    parallel_for(labels.size(), threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) labels[i] = id[(size_t) labels[i]];
+    });
+    return k;
+}
+
+AtomicArray<double> community_weights(const std::vector<int64_t>& comm, const std::vector<double>& node_w,
+                                      unsigned threads) {
+    AtomicArray<double> cw = make_atomic_array<double>((int64_t) comm.size(), 0.0, threads);
+    parallel_for(comm.size(), threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) atomic_add(cw[(size_t) comm[v]], node_w[v]);
+    });
+    return cw;
+}
+
+// Moves vertices to the neighbouring community with the largest gain
+//   k_v,c - gamma * w_v * W_c      (staying: k_v,a - gamma * w_v * (W_a - w_v))
+// until a sweep moves nothing or max_passes is reached. Returns the number of moves.
+int64_t local_move(const CsrGraph& g, const std::vector<double>& node_w, double gamma,
+                   std::vector<int64_t>& labels, std::vector<Scratch>& scratch,
+                   int max_passes, unsigned threads) {
+    const int64_t n = g.n;
+    AtomicArray<int64_t> comm(new std::atomic<int64_t>[(size_t) n]);
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) comm[v].store(labels[v], std::memory_order_relaxed);
+    });
+    AtomicArray<double> cw = community_weights(labels, node_w, threads);
+    AtomicArray<uint8_t> active = make_atomic_array<uint8_t>(n, 1, threads);
+
+    std::vector<int64_t> moved(threads);
+    int64_t total = 0;
+    for (int pass = 0; pass < max_passes; ++pass) {
+        std::fill(moved.begin(), moved.end(), 0);
+        parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned t) {
+            DeltaMap& map = scratch[t].map;
+            for (size_t v = b; v < e; ++v) {
+                if (!active[v].exchange(0, std::memory_order_relaxed)) continue;
+                const int64_t row = g.offsets[v], end = g.offsets[v + 1];
+                const int64_t a = comm[v].load(std::memory_order_relaxed);
+                const double wv = node_w[v];
+                map.prepare((size_t) (end - row));
+                for (int64_t i = row; i < end; ++i) {
+                    const int64_t u = g.adj[(size_t) i];
+                    if (u != (int64_t) v) map.add(comm[(size_t) u].load(std::memory_order_relaxed), g.weights[(size_t) i]);
+                }
+                int64_t best = a;
+                double best_gain = map.get(a) - gamma * wv * (cw[(size_t) a].load(std::memory_order_relaxed) - wv);
+                for (size_t k = 0; k < map.size(); ++k) {
+                    const int64_t c = map.key(k);
+                    if (c == a) continue;
+                    const double gain = map.value(k) - gamma * wv * cw[(size_t) c].load(std::memory_order_relaxed);
+                    if (gain > best_gain) { best_gain = gain; best = c; }
+                }
+                map.clear();
+                if (best == a) continue;
+
+                atomic_add(cw[(size_t) a], -wv);
+                atomic_add(cw[(size_t) best], wv);
+                comm[v].store(best, std::memory_order_relaxed);
+                ++moved[t];
+                for (int64_t i = row; i < end; ++i) {
+                    const int64_t u = g.adj[(size_t) i];
+                    if (comm[(size_t) u].load(std::memory_order_relaxed) != best)
+                        active[(size_t) u].store(1, std::memory_order_relaxed);
+                }
+            }
+        });
+        int64_t pass_moves = std::accumulate(moved.begin(), moved.end(), (int64_t) 0);
+        total += pass_moves;
+        if (pass_moves == 0) break;
+    }
+
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) labels[v] = comm[v].load(std::memory_order_relaxed);
+    });
+    return total;
+}
+
+// Refines the communities in `bound` (dense labels): starting from singletons,
+// each well-connected vertex that is still alone may join a refined community
+// inside its own bound community, chosen at random with probability
+// proportional to exp(gain / beta) among non-negative gains. Writes dense
+// refined labels to `ref` and returns their count.
+int64_t refine(const CsrGraph& g, const std::vector<double>& node_w, double gamma, double beta,
+               uint64_t seed, const std::vector<int64_t>& bound, std::vector<int64_t>& ref,
+               std::vector<Scratch>& scratch, unsigned threads) {
+    const int64_t n = g.n;
+    AtomicArray<double> bound_w = community_weights(bound, node_w, threads);
+    AtomicArray<int64_t> rc(new std::atomic<int64_t>[(size_t) n]);
+    AtomicArray<double> rw(new std::atomic<double>[(size_t) n]);
+    // 0: untouched singleton, 1: its vertex left, 2: another vertex joined it.
+    AtomicArray<uint8_t> state = make_atomic_array<uint8_t>(n, 0, threads);
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) {
+            rc[v].store((int64_t) v, std::memory_order_relaxed);
+            rw[v].store(node_w[v], std::memory_order_relaxed);
+        }
+    });
+
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned t) {
+        DeltaMap& map = scratch[t].map;
+        auto& cand = scratch[t].candidates;
+        for (size_t v = b; v < e; ++v) {
+            if (state[v].load(std::memory_order_relaxed) != 0) continue;
+            const int64_t row = g.offsets[v], end = g.offsets[v + 1];
+            const int64_t s = bound[v];
+            const double wv = node_w[v];
+
+            double k_in = 0.0;
+            map.prepare((size_t) (end - row));
+            for (int64_t i = row; i < end; ++i) {
+                const int64_t u = g.adj[(size_t) i];
+                if (u == (int64_t) v || bound[(size_t) u] != s) continue;
+                k_in += g.weights[(size_t) i];
+                map.add(rc[(size_t) u].load(std::memory_order_relaxed), g.weights[(size_t) i]);
+            }
+            // Only well-connected vertices may leave their singleton.
+            if (map.size() == 0 || k_in < gamma * wv * (bound_w[(size_t) s].load(std::memory_order_relaxed) - wv)) {
+                map.clear();
+                continue;
+            }
+
+            cand.clear();
+            cand.emplace_back((int64_t) v, 0.0);   // staying alone
+            double max_gain = 0.0;
+            for (size_t k = 0; k < map.size(); ++k) {
+                const int64_t c = map.key(k);
+                if (c == (int64_t) v) continue;
+                const double gain = map.value(k) - gamma * wv * rw[(size_t) c].load(std::memory_order_relaxed);
+                if (gain < 0) continue;
+                cand.emplace_back(c, gain);
+                max_gain = std::max(max_gain, gain);
+            }
+            map.clear();
+            if (cand.size() == 1) continue;
+
+            double total = 0.0;
+            for (auto& c : cand) total += (c.second = std::exp((c.second - max_gain) / beta));
+            const double r = (double) (splitmix64(seed ^ splitmix64((uint64_t) v)) >> 11) * 0x1.0p-53 * total;
+            int64_t target = cand.back().first;
+            double acc = 0.0;
+            for (auto& c : cand) {
+                acc += c.second;
+                if (r < acc) { target = c.first; break; }
+            }
+            if (target == (int64_t) v) continue;
+
+            uint8_t expected = 0;
+            if (!state[v].compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) continue;
+            uint8_t ts = state[(size_t) target].load(std::memory_order_acquire);
+            while (ts == 0 && !state[(size_t) target].compare_exchange_weak(ts, 2, std::memory_order_acq_rel)) {}
+            if (ts == 1) {   // target's vertex left first; its community is empty now
+                state[v].store(0, std::memory_order_release);
+                continue;
+            }
+            rc[v].store(target, std::memory_order_relaxed);
+            atomic_add(rw[(size_t) target], wv);
+            rw[v].store(0.0, std::memory_order_relaxed);
+        }
+    });
+
+    ref.resize((size_t) n);
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) ref[v] = rc[v].load(std::memory_order_relaxed);
+    });
+    return renumber(ref, n, threads);
+}
+
+// Collapses each refined community into one vertex. Fills the aggregate's
+// node weights and, for each super-vertex, one member (`rep`) so the caller
+// can carry over community labels.
+CsrGraph aggregate(const CsrGraph& g, const std::vector<double>& node_w, const std::vector<int64_t>& ref,
+                   int64_t k, std::vector<double>& agg_w, std::vector<int64_t>& rep,
+                   std::vector<Scratch>& scratch, unsigned threads) {
+    const int64_t n = g.n;
+    std::vector<int64_t> members((size_t) n), tmp((size_t) n);
+    std::iota(members.begin(), members.end(), (int64_t) 0);
+    radix_sort(members.data(), tmp.data(), (size_t) n, bit_width_u64((uint64_t) k),
+               [&](int64_t v) { return (uint64_t) ref[(size_t) v]; }, threads);
+    std::vector<int64_t> start((size_t) k + 1);
+    start[(size_t) k] = n;
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i)
+            if (i == 0 || ref[(size_t) members[i]] != ref[(size_t) members[i - 1]])
+                start[(size_t) ref[(size_t) members[i]]] = (int64_t) i;
+    });
+
+    CsrGraph out;
+    out.n = k;
+    out.offsets.assign((size_t) k + 1, 0);
+    agg_w.assign((size_t) k, 0.0);
+    rep.assign((size_t) k, 0);
+    threads = std::min<unsigned>(threads, (unsigned) std::max<int64_t>(k, 1));
+    std::vector<std::vector<int64_t>> local_adj(threads);
+    std::vector<std::vector<double>> local_w(threads);
+    parallel_for((size_t) k, threads, [&](size_t b, size_t e, unsigned t) {
+        DeltaMap& map = scratch[t].map;
+        for (size_t s = b; s < e; ++s) {
+            size_t degree = 0;
+            for (int64_t i = start[s]; i < start[s + 1]; ++i) {
+                const size_t v = (size_t) members[(size_t) i];
+                degree += (size_t) (g.offsets[v + 1] - g.offsets[v]);
+            }
+            map.prepare(degree);
+            double w = 0.0;
+            for (int64_t i = start[s]; i < start[s + 1]; ++i) {
+                const size_t v = (size_t) members[(size_t) i];
+                w += node_w[v];
+                for (int64_t j = g.offsets[v]; j < g.offsets[v + 1]; ++j)
+                    map.add(ref[(size_t) g.adj[(size_t) j]], g.weights[(size_t) j]);
+            }
+            agg_w[s] = w;
+            rep[s] = members[(size_t) start[s]];
+            out.offsets[s + 1] = (int64_t) map.size();
+            for (size_t i = 0; i < map.size(); ++i) {
+                local_adj[t].push_back(map.key(i));
+                local_w[t].push_back(map.value(i));
+            }
+            map.clear();
+        }
+    });
+
+    for (int64_t s = 0; s < k; ++s) out.offsets[(size_t) s + 1] += out.offsets[(size_t) s];
+    out.adj.resize((size_t) out.offsets[(size_t) k]);
+    out.weights.resize(out.adj.size());
+    parallel_for((size_t) k, threads, [&](size_t b, size_t, unsigned t) {
+        std::copy(local_adj[t].begin(), local_adj[t].end(), out.adj.begin() + out.offsets[b]);
+        std::copy(local_w[t].begin(), local_w[t].end(), out.weights.begin() + out.offsets[b]);
+    });
+    return out;
+}
+
+// One Leiden iteration starting from (and updating) `membership`, which
+// holds dense labels. Returns whether any vertex moved at any level.
+bool leiden_iteration(const CsrGraph& g0, const std::vector<double>& w0, double gamma,
+                      const NativeLeidenOptions& opt, int iteration, std::vector<int64_t>& membership,
+                      std::vector<Scratch>& scratch, unsigned threads) {
+    const int64_t n0 = g0.n;
+    std::vector<int64_t> top((size_t) n0);
+    std::iota(top.begin(), top.end(), (int64_t) 0);
+    std::vector<int64_t> comm = membership;
+
+    CsrGraph agg;
+    std::vector<double> agg_w;
+    const CsrGraph* g = &g0;
+    const std::vector<double>* nw = &w0;
+    bool changed = false;
+    for (uint64_t level = 0;; ++level) {
+        if (local_move(*g, *nw, gamma, comm, scratch, opt.max_passes, threads) > 0) changed = true;
+        if (renumber(comm, g->n, threads) == g->n) break;   // nothing merged
+
+        std::vector<int64_t> ref;
+        const uint64_t seed = splitmix64(opt.seed ^ splitmix64(((uint64_t) iteration << 32) | level));
+        const int64_t k = refine(*g, *nw, gamma, opt.beta, seed, comm, ref, scratch, threads);
+        if (k == g->n) break;   // refinement kept every vertex alone
+
+        std::vector<double> next_w;
+        std::vector<int64_t> rep;
+        CsrGraph next = aggregate(*g, *nw, ref, k, next_w, rep, scratch, threads);
+        std::vector<int64_t> next_comm((size_t) k);
+        parallel_for((size_t) k, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t s = b; s < e; ++s) next_comm[s] = comm[(size_t) rep[s]];
+        });
+        parallel_for((size_t) n0, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t v = b; v < e; ++v) top[v] = ref[(size_t) top[v]];
+        });
+        agg = std::move(next);
+        agg_w = std::move(next_w);
+        comm = std::move(next_comm);
+        g = &agg;
+        nw = &agg_w;
+    }
+
+    parallel_for((size_t) n0, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) membership[v] = comm[(size_t) top[v]];
+    });
+    return changed;
+}
+
+std::vector<double> strengths(const CsrGraph& g, unsigned threads) {
+    std::vector<double> s((size_t) g.n);
+    parallel_for((size_t) g.n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) {
+            double w = 0.0;
+            for (int64_t i = g.offsets[v]; i < g.offsets[v + 1]; ++i) w += g.weights[(size_t) i];
+            s[v] = w;
+        }
+    });
+    return s;
+}
+
+} // namespace
+
+CsrGraph build_csr(int64_t n, int64_t m, const int64_t* src, const int64_t* dst,
+                   const double* w, unsigned threads) {
+    if (n < 0 || m < 0) throw std::invalid_argument("build_csr: negative vertex or edge count");
+    threads = resolve_threads(threads);
+    CsrGraph g;
+    g.n = n;
+
+    AtomicArray<int64_t> degree = make_atomic_array<int64_t>(n + 1, 0, threads);
+    parallel_for((size_t) m, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) {
+            const int64_t u = src[i], v = dst[i];
+            if (u < 0 || u >= n || v < 0 || v >= n)
+                throw std::invalid_argument("build_csr: edge endpoint out of range");
+            degree[(size_t) u].fetch_add(1, std::memory_order_relaxed);
+            if (u != v) degree[(size_t) v].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    g.offsets.resize((size_t) n + 1);
+    g.offsets[0] = 0;
+    for (int64_t v = 0; v < n; ++v)
+        g.offsets[(size_t) v + 1] = g.offsets[(size_t) v] + degree[(size_t) v].load(std::memory_order_relaxed);
+
+    AtomicArray<int64_t>& cursor = degree;
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) cursor[v].store(g.offsets[v], std::memory_order_relaxed);
+    });
+    g.adj.resize((size_t) g.offsets[(size_t) n]);
+    g.weights.resize(g.adj.size());
+    parallel_for((size_t) m, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) {
+            const int64_t u = src[i], v = dst[i];
+            const double wi = w ? w[i] : 1.0;
+            size_t p = (size_t) cursor[(size_t) u].fetch_add(1, std::memory_order_relaxed);
+            g.adj[p] = v;
+            if (u == v) {
+                g.weights[p] = 2.0 * wi;
+                continue;
+            }
+            g.weights[p] = wi;
+            p = (size_t) cursor[(size_t) v].fetch_add(1, std::memory_order_relaxed);
+            g.adj[p] = u;
+            g.weights[p] = wi;
+        }
+    });
+
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned) {
+        std::vector<std::pair<int64_t, double>> row;
+        for (size_t v = b; v < e; ++v) {
+            const size_t lo = (size_t) g.offsets[v], hi = (size_t) g.offsets[v + 1];
+            row.clear();
+            for (size_t i = lo; i < hi; ++i) row.emplace_back(g.adj[i], g.weights[i]);
+            std::sort(row.begin(), row.end());
+            for (size_t i = lo; i < hi; ++i) {
+                g.adj[i] = row[i - lo].first;
+                g.weights[i] = row[i - lo].second;
+            }
+        }
+    });
+    return g;
+}
+
+NativeLeidenResult native_leiden(const CsrGraph& g, const NativeLeidenOptions& opt, const int64_t* initial) {
+    if (opt.beta <= 0) throw std::invalid_argument("native_leiden: beta must be positive");
+    const unsigned threads = resolve_threads(opt.threads);
+    const int64_t n = g.n;
+
+    NativeLeidenResult res;
+    res.membership.resize((size_t) n);
+    if (initial) {
+        for (int64_t v = 0; v < n; ++v) {
+            if (initial[v] < 0 || initial[v] >= n)
+                throw std::invalid_argument("native_leiden: initial label out of range");
+            res.membership[(size_t) v] = initial[v];
+        }
+    } else {
+        std::iota(res.membership.begin(), res.membership.end(), (int64_t) 0);
+    }
+    if (n == 0) return res;
+
+    std::vector<double> node_w;
+    double gamma = opt.resolution;
+    if (opt.modularity) {
+        node_w = strengths(g, threads);
+        const double two_m = std::accumulate(node_w.begin(), node_w.end(), 0.0);
+        if (two_m > 0) gamma = opt.resolution / two_m;
+    } else {
+        node_w.assign((size_t) n, 1.0);
+    }
+
+    std::vector<Scratch> scratch(threads);
+    std::vector<int64_t> before;
+    ConvergenceTracker conv(opt.convergence, n);
+    for (int it = 0;; ++it) {
+        renumber(res.membership, n, threads);
+        before = res.membership;
+        const bool changed = leiden_iteration(g, node_w, gamma, opt, it, res.membership, scratch, threads);
+        const int64_t moved = changed ? count_moved(before.data(), res.membership.data(), (size_t) n) : 0;
+        const double q = native_quality(g, opt.modularity, opt.resolution, res.membership.data(), threads);
+        if (!conv.record(q, moved)) break;
+    }
+    if (conv.reverted()) res.membership.swap(before);
+    res.iterations = conv.iterations();
+    res.iteration_seconds = conv.iteration_seconds();
+    res.history = conv.history();
+    res.stop_reason = conv.reason();
+    res.clusters = renumber(res.membership, n, threads);
+    res.quality = conv.best_quality();
+    return res;
+}
+
+double native_quality(const CsrGraph& g, bool modularity, double resolution,
+                      const int64_t* membership, unsigned threads) {
+    threads = resolve_threads(threads);
+    const int64_t n = g.n;
+    if (g.adj.empty()) return 0.0;
+
+    std::vector<double> internal(threads, 0.0), strength(threads, 0.0);
+    int64_t c_max = 0;
+    for (int64_t v = 0; v < n; ++v) c_max = std::max(c_max, membership[v]);
+    AtomicArray<double> cw = make_atomic_array<double>(c_max + 1, 0.0, threads);
+    parallel_for((size_t) n, threads, [&](size_t b, size_t e, unsigned t) {
+        double in = 0.0, total = 0.0;
+        for (size_t v = b; v < e; ++v) {
+            double s = 0.0;
+            for (int64_t i = g.offsets[v]; i < g.offsets[v + 1]; ++i) {
+                const double w = g.weights[(size_t) i];
+                s += w;
+                if (membership[(size_t) g.adj[(size_t) i]] == membership[v]) in += w;
+            }
+            total += s;
+            atomic_add(cw[(size_t) membership[v]], modularity ? s : 1.0);
+        }
+        internal[t] = in;
+        strength[t] = total;
+    });
+
+    const double two_m = std::accumulate(strength.begin(), strength.end(), 0.0);
+    const double gamma = (modularity && two_m > 0) ? resolution / two_m : resolution;
+    double q = std::accumulate(internal.begin(), internal.end(), 0.0);
+    for (int64_t c = 0; c <= c_max; ++c) {
+        const double w = cw[(size_t) c].load(std::memory_order_relaxed);
+        q -= gamma * w * w;
+    }
+    return q / two_m;
+}
@@ -0,0 +1,63 @@
+#ifndef NATIVE_LEIDEN_H
+#define NATIVE_LEIDEN_H
+
+// Multithreaded Leiden (parallel local moving, refinement and aggregation)
+// over a CSR graph. Independent of igraph and libleidenalg; used by
+// leiden_igraph --engine native and the c_leidenRunNative C API.
+
+#include <cstdint>
+#include <vector>
+
+#include "convergence.h"
+
+// Undirected weighted graph. An edge {u,v} with u != v is stored in the rows
+// of both endpoints; a self-loop is stored once with twice its weight, so a
+// row sums to the vertex strength and all rows to 2 * total edge weight.
+struct CsrGraph {
+    int64_t n = 0;
+    std::vector<int64_t> offsets;   // n + 1
+    std::vector<int64_t> adj;
+    std::vector<double> weights;
+};
+
+// Builds the CSR from m endpoint pairs in 0..n-1 (direction is ignored).
+// `w` may be null for unit weights. Rows are sorted by neighbour, so the
+// layout does not depend on the thread count.
+CsrGraph build_csr(int64_t n, int64_t m, const int64_t* src, const int64_t* dst,
+                   const double* w = nullptr, unsigned threads = 0);
+
+struct NativeLeidenOptions {
+    bool modularity = false;   // otherwise CPM
+    double resolution = 1.0;
+    double beta = 0.01;        // refinement randomness, as in igraph
+    ConvergenceOptions convergence;  // when to stop iterating (default: stable or 50 iterations)
+    int max_passes = 20;       // local-moving sweeps per level
+    uint64_t seed = 1;
+    unsigned threads = 0;      // 0 = all cores
+};
+
+struct NativeLeidenResult {
+    std::vector<int64_t> membership;   // 0..clusters-1
+    int64_t clusters = 0;
+    double quality = 0.0;
+    int iterations = 0;                // iterations actually run
+    std::vector<double> iteration_seconds;  // wall time of each iteration
+    std::vector<IterationRecord> history;   // quality, moves and time per iteration
+    StopReason stop_reason = StopReason::Stable;
+};
+
+// Runs Leiden on g. `initial` (optional, n labels in 0..n-1) is the starting
+// partition; otherwise every vertex starts alone. Iterates until
+// opt.convergence says stop; an iteration that lowers quality is undone.
+// Throws std::invalid_argument on bad input.
+NativeLeidenResult native_leiden(const CsrGraph& g, const NativeLeidenOptions& opt,
+                                 const int64_t* initial = nullptr);
+
+// Quality in igraph_community_leiden's convention:
+//   (2 * internal edge weight - gamma * sum_c W_c^2) / (2 * total edge weight)
+// where W_c sums strengths with gamma = resolution / 2m (modularity), or
+// counts vertices with gamma = resolution (CPM).
+double native_quality(const CsrGraph& g, bool modularity, double resolution,
+                      const int64_t* membership, unsigned threads = 0);
+
+#endif // NATIVE_LEIDEN_H
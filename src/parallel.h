@@ -0,0 +1,47 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// Small std::thread helpers shared by the loaders and graph stages.
+
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 0 means "use every hardware thread".
+inline unsigned resolve_threads(unsigned requested) {
+    if (requested) return requested;
+    unsigned hc = std::thread::hardware_concurrency();
+    return hc ? hc : 1;
+}
+
+// Runs fn(tid) on `threads` threads (the caller is tid 0) and rethrows the
+// first exception raised by any of them.
+template <class Fn>
+void run_parallel(unsigned threads, Fn&& fn) {
+    if (threads <= 1) { fn(0u); return; }
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            try { fn(t); } catch (...) { errors[t] = std::current_exception(); }
+        });
+    }
+    try { fn(0u); } catch (...) { errors[0] = std::current_exception(); }
+    for (auto& th : pool) th.join();
+    for (auto& e : errors) if (e) std::rethrow_exception(e);
+}
+
+// Splits [0, n) into one contiguous block per thread and runs fn(begin, end, tid).
+template <class Fn>
+void parallel_for(size_t n, unsigned threads, Fn&& fn) {
+    if (threads > n) threads = n ? (unsigned) n : 1;
+    run_parallel(threads, [&](unsigned t) {
+        size_t b = n * t / threads, e = n * (t + 1) / threads;
+        fn(b, e, t);
+    });
+}
+
+#endif // PARALLEL_H
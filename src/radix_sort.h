@@ -0,0 +1,69 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+// Stable parallel LSD radix sort (8-bit digits) over arbitrary records.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+
+// Sorts data[0..n) by key(x), an unsigned integer with at most key_bits
+// significant bits. tmp must have room for n elements; the result is left in
+// data. Digits on which every key agrees are skipped.
+template <class T, class KeyFn>
+void radix_sort(T* data, T* tmp, size_t n, unsigned key_bits, KeyFn key, unsigned threads) {
+    constexpr size_t kBuckets = 256;
+    threads = resolve_threads(threads);
+    if (n < (size_t(1) << 16)) threads = 1;
+    if (threads > n) threads = n ? (unsigned) n : 1;
+
+    std::vector<size_t> hist(threads * kBuckets);
+    T* src = data;
+    T* dst = tmp;
+    for (unsigned shift = 0; shift < key_bits; shift += 8) {
+        std::fill(hist.begin(), hist.end(), 0);
+        parallel_for(n, threads, [&](size_t b, size_t e, unsigned t) {
+            size_t* h = &hist[t * kBuckets];
+            for (size_t i = b; i < e; ++i) ++h[(uint64_t(key(src[i])) >> shift) & 0xff];
+        });
+
+        // Exclusive offsets, digit-major then thread, which keeps the sort stable.
+        bool trivial = false;
+        size_t sum = 0;
+        for (size_t d = 0; d < kBuckets; ++d) {
+            size_t digit_total = 0;
+            for (unsigned t = 0; t < threads; ++t) {
+                size_t c = hist[t * kBuckets + d];
+                hist[t * kBuckets + d] = sum;
+                sum += c; digit_total += c;
+            }
+            if (digit_total == n) trivial = true;
+        }
+        if (trivial) continue;
+
+        parallel_for(n, threads, [&](size_t b, size_t e, unsigned t) {
+            size_t* h = &hist[t * kBuckets];
+            for (size_t i = b; i < e; ++i) dst[h[(uint64_t(key(src[i])) >> shift) & 0xff]++] = src[i];
+        });
+        std::swap(src, dst);
+    }
+    if (src != data) {
+        parallel_for(n, threads, [&](size_t b, size_t e, unsigned) {
+            std::memcpy(data + b, src + b, (e - b) * sizeof(T));
+        });
+    }
+}
+
+// Number of bits needed to represent x.
+inline unsigned bit_width_u64(uint64_t x) {
+    unsigned w = 0;
+    while (x) { ++w; x >>= 1; }
+    return w;
+}
+
+#endif // RADIX_SORT_H
@@ -0,0 +1,273 @@
+// Vertex renumbering for locality: degree sort, BFS, reverse Cuthill-McKee
+// and Rabbit Order over an undirected adjacency array.
+
+#include "reorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <stdexcept>
+
+#include "parallel.h"
+
+namespace {
+
+// Undirected adjacency (self-loops left out): the neighbours of v are
+// adj[off[v] .. off[v+1]), edge[] holding the edge each entry came from.
+// Filled in edge order, so every order below is deterministic.
+struct Adjacency {
+    std::vector<int64_t> off, adj, edge;
+
+    int64_t degree(int64_t v) const { return off[(size_t) v + 1] - off[(size_t) v]; }
+};
+
+Adjacency build_adjacency(const int64_t* es, size_t m, int64_t n, bool with_edges) {
+    Adjacency a;
+    a.off.assign((size_t) n + 1, 0);
+    for (size_t e = 0; e < m; ++e) {
+        const int64_t u = es[2 * e], v = es[2 * e + 1];
+        if (u == v) continue;
+        ++a.off[(size_t) u + 1];
+        ++a.off[(size_t) v + 1];
+    }
+    std::partial_sum(a.off.begin(), a.off.end(), a.off.begin());
+    a.adj.resize((size_t) a.off[(size_t) n]);
+    if (with_edges) a.edge.resize(a.adj.size());
+    std::vector<int64_t> cursor(a.off.begin(), a.off.end() - 1);
+    for (size_t e = 0; e < m; ++e) {
+        const int64_t u = es[2 * e], v = es[2 * e + 1];
+        if (u == v) continue;
+        const int64_t iu = cursor[(size_t) u]++, iv = cursor[(size_t) v]++;
+        a.adj[(size_t) iu] = v;
+        a.adj[(size_t) iv] = u;
+        if (with_edges) a.edge[(size_t) iu] = a.edge[(size_t) iv] = (int64_t) e;
+    }
+    return a;
+}
+
+// Vertices by degree (stable counting sort), descending or ascending.
+std::vector<int64_t> by_degree(const std::vector<int64_t>& deg, bool descending) {
+    const int64_t n = (int64_t) deg.size();
+    const int64_t max_deg = n ? *std::max_element(deg.begin(), deg.end()) : 0;
+    std::vector<int64_t> start((size_t) max_deg + 2, 0);
+    for (int64_t d : deg) ++start[(size_t) (descending ? max_deg - d : d) + 1];
+    std::partial_sum(start.begin(), start.end(), start.begin());
+    std::vector<int64_t> order((size_t) n);
+    for (int64_t v = 0; v < n; ++v) order[(size_t) start[(size_t) (descending ? max_deg - deg[(size_t) v] : deg[(size_t) v])]++] = v;
+    return order;
+}
+
+std::vector<int64_t> degrees(const Adjacency& a, int64_t n) {
+    std::vector<int64_t> deg((size_t) n);
+    for (int64_t v = 0; v < n; ++v) deg[(size_t) v] = a.degree(v);
+    return deg;
+}
+
+std::vector<int64_t> degree_only(const int64_t* es, size_t m, int64_t n) {
+    std::vector<int64_t> deg((size_t) n, 0);
+    for (size_t e = 0; e < m; ++e) {
+        if (es[2 * e] == es[2 * e + 1]) continue;
+        ++deg[(size_t) es[2 * e]];
+        ++deg[(size_t) es[2 * e + 1]];
+    }
+    return by_degree(deg, /*descending=*/true);
+}
+
+// Visit order of a breadth-first search started from each unvisited vertex
+// of `seeds` in turn. With sort_by_degree, each vertex's unvisited
+// neighbours are queued in ascending degree (Cuthill-McKee).
+std::vector<int64_t> bfs_order(const Adjacency& a, int64_t n, const std::vector<int64_t>& seeds,
+                               const std::vector<int64_t>& deg, bool sort_by_degree) {
+    std::vector<int64_t> order;
+    order.reserve((size_t) n);
+    std::vector<char> seen((size_t) n, 0);
+    std::vector<int64_t> next;
+    for (int64_t s : seeds) {
+        if (seen[(size_t) s]) continue;
+        seen[(size_t) s] = 1;
+        size_t head = order.size();
+        order.push_back(s);
+        while (head < order.size()) {
+            const int64_t u = order[head++];
+            next.clear();
+            for (int64_t i = a.off[(size_t) u]; i < a.off[(size_t) u + 1]; ++i) {
+                const int64_t v = a.adj[(size_t) i];
+                if (seen[(size_t) v]) continue;
+                seen[(size_t) v] = 1;
+                next.push_back(v);
+            }
+            if (sort_by_degree)
+                std::sort(next.begin(), next.end(), [&](int64_t x, int64_t y) {
+                    return deg[(size_t) x] != deg[(size_t) y] ? deg[(size_t) x] < deg[(size_t) y] : x < y;
+                });
+            order.insert(order.end(), next.begin(), next.end());
+        }
+    }
+    return order;
+}
+
+// Rabbit Order (Arai et al., IPDPS 2016), sequential: vertices are visited
+// in ascending degree and each merges into the neighbouring community with
+// the largest positive modularity gain, taking its (lazily aggregated) edges
+// along. A depth-first walk of the resulting merge forest then numbers each
+// community's members consecutively, nested communities inside their parent.
+std::vector<int64_t> rabbit_order(const int64_t* es, size_t m, int64_t n, const double* weights) {
+    const Adjacency a = build_adjacency(es, m, n, weights != nullptr);
+    std::vector<double> strength((size_t) n, 0.0);
+    double two_m = 0.0;
+    for (int64_t v = 0; v < n; ++v) {
+        for (int64_t i = a.off[(size_t) v]; i < a.off[(size_t) v + 1]; ++i)
+            strength[(size_t) v] += weights ? weights[(size_t) a.edge[(size_t) i]] : 1.0;
+        two_m += strength[(size_t) v];
+    }
+
+    std::vector<int64_t> parent((size_t) n);
+    std::iota(parent.begin(), parent.end(), (int64_t) 0);
+    auto root = [&](int64_t x) {
+        int64_t r = x;
+        while (parent[(size_t) r] != r) r = parent[(size_t) r];
+        while (parent[(size_t) x] != r) { const int64_t up = parent[(size_t) x]; parent[(size_t) x] = r; x = up; }
+        return r;
+    };
+    std::vector<std::vector<std::pair<int64_t, double>>> merged((size_t) n);  // edges inherited from members
+    std::vector<std::vector<int64_t>> children((size_t) n);
+    std::vector<char> done((size_t) n, 0);
+    std::vector<double> acc((size_t) n, 0.0);
+    std::vector<char> seen((size_t) n, 0);
+    std::vector<int64_t> touched;
+
+    if (two_m > 0.0) {
+        for (int64_t u : by_degree(degrees(a, n), /*descending=*/false)) {
+            // Aggregate u's edges by the community now holding the other end.
+            touched.clear();
+            auto add = [&](int64_t x, double w) {
+                const int64_t r = root(x);
+                if (r == u) return;
+                if (!seen[(size_t) r]) { seen[(size_t) r] = 1; touched.push_back(r); }
+                acc[(size_t) r] += w;
+            };
+            for (int64_t i = a.off[(size_t) u]; i < a.off[(size_t) u + 1]; ++i)
+                add(a.adj[(size_t) i], weights ? weights[(size_t) a.edge[(size_t) i]] : 1.0);
+            for (const auto& [x, w] : merged[(size_t) u]) add(x, w);
+            std::vector<std::pair<int64_t, double>>().swap(merged[(size_t) u]);
+            done[(size_t) u] = 1;
+
+            // Half the modularity gain of merging u into v: w_uv / 2m - d_u d_v / (2m)^2.
+            int64_t best = -1;
+            double best_gain = 0.0;
+            for (int64_t v : touched) {
+                const double gain = acc[(size_t) v] / two_m -
+                                    strength[(size_t) u] * strength[(size_t) v] / (two_m * two_m);
+                if (gain > best_gain || (gain == best_gain && best >= 0 && v < best)) { best = v; best_gain = gain; }
+            }
+            if (best >= 0) {
+                parent[(size_t) u] = best;
+                strength[(size_t) best] += strength[(size_t) u];
+                children[(size_t) best].push_back(u);
+                if (!done[(size_t) best]) {  // only a community still to be visited needs the edges
+                    auto& dst = merged[(size_t) best];
+                    for (int64_t v : touched)
+                        if (v != best) dst.emplace_back(v, acc[(size_t) v]);
+                }
+            }
+            for (int64_t v : touched) { acc[(size_t) v] = 0.0; seen[(size_t) v] = 0; }
+        }
+    }
+
+    std::vector<int64_t> order;
+    order.reserve((size_t) n);
+    std::vector<int64_t> stack;
+    for (int64_t r = 0; r < n; ++r) {
+        if (parent[(size_t) r] != r) continue;
+        stack.push_back(r);
+        while (!stack.empty()) {
+            const int64_t x = stack.back();
+            stack.pop_back();
+            order.push_back(x);
+            const auto& ch = children[(size_t) x];
+            stack.insert(stack.end(), ch.rbegin(), ch.rend());
+        }
+    }
+    return order;
+}
+
+} // namespace
+
+VertexOrder parse_vertex_order(const std::string& name) {
+    if (name == "none") return VertexOrder::None;
+    if (name == "degree") return VertexOrder::Degree;
+    if (name == "bfs") return VertexOrder::Bfs;
+    if (name == "rcm") return VertexOrder::Rcm;
+    if (name == "rabbit") return VertexOrder::Rabbit;
+    throw std::invalid_argument("Unknown vertex order: " + name);
+}
+
+const char* vertex_order_name(VertexOrder o) {
+    switch (o) {
+        case VertexOrder::None:   return "none";
+        case VertexOrder::Degree: return "degree";
+        case VertexOrder::Bfs:    return "bfs";
+        case VertexOrder::Rcm:    return "rcm";
+        case VertexOrder::Rabbit: return "rabbit";
+    }
+    return "?";
+}
+
+std::vector<int64_t> vertex_order(const int64_t* es, size_t m, int64_t n, const double* weights,
+                                  VertexOrder order, unsigned threads) {
+    std::vector<int64_t> visit;  // vertices in their new order
+    switch (order) {
+        case VertexOrder::None:
+            visit.resize((size_t) n);
+            std::iota(visit.begin(), visit.end(), (int64_t) 0);
+            break;
+        case VertexOrder::Degree:
+            visit = degree_only(es, m, n);
+            break;
+        case VertexOrder::Bfs:
+        case VertexOrder::Rcm: {
+            const Adjacency a = build_adjacency(es, m, n, /*with_edges=*/false);
+            const std::vector<int64_t> deg = degrees(a, n);
+            const bool rcm = order == VertexOrder::Rcm;
+            visit = bfs_order(a, n, by_degree(deg, /*descending=*/!rcm), deg, rcm);
+            if (rcm) std::reverse(visit.begin(), visit.end());
+            break;
+        }
+        case VertexOrder::Rabbit:
+            visit = rabbit_order(es, m, n, weights);
+            break;
+    }
+    if ((int64_t) visit.size() != n) throw std::logic_error("vertex order does not cover every vertex");
+    std::vector<int64_t> perm((size_t) n);
+    parallel_for((size_t) n, resolve_threads(threads), [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) perm[(size_t) visit[i]] = (int64_t) i;
+    });
+    return perm;
+}
+
+void apply_vertex_order(int64_t* es, size_t m, const std::vector<int64_t>& perm,
+                        std::vector<long long>* inv_map, unsigned threads) {
+    threads = resolve_threads(threads);
+    parallel_for(2 * m, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) es[i] = perm[(size_t) es[i]];
+    });
+    const size_t n = perm.size();
+    std::vector<long long> moved(n);
+    parallel_for(n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t v = b; v < e; ++v) moved[(size_t) perm[v]] = inv_map->empty() ? (long long) v : (*inv_map)[v];
+    });
+    *inv_map = std::move(moved);
+}
+
+double edge_id_gap(const int64_t* es, size_t m, unsigned threads) {
+    if (m == 0) return 0.0;
+    threads = resolve_threads(threads);
+    std::vector<double> sum(threads, 0.0);
+    parallel_for(m, threads, [&](size_t b, size_t e, unsigned t) {
+        double s = 0.0;
+        for (size_t i = b; i < e; ++i) s += std::log2(1.0 + (double) std::llabs(es[2 * i] - es[2 * i + 1]));
+        sum[t] = s;
+    });
+    return std::accumulate(sum.begin(), sum.end(), 0.0) / (double) m;
+}
@@ -0,0 +1,42 @@
+#ifndef REORDER_H
+#define REORDER_H
+
+// Locality-improving vertex renumbering (--reorder). Remapped ids follow
+// first appearance in the input, which scatters neighbours across memory;
+// renumbering so that neighbours get nearby ids makes the optimiser's reads
+// of neighbour memberships mostly cache hits.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum class VertexOrder {
+    None,
+    Degree,  // descending degree (hubs first, ties keep their order)
+    Bfs,     // breadth-first, each component from its highest-degree vertex
+    Rcm,     // reverse Cuthill-McKee, each component from a minimum-degree vertex
+    Rabbit,  // Rabbit Order: greedy modularity merging, communities numbered contiguously
+};
+
+VertexOrder parse_vertex_order(const std::string& name);
+const char* vertex_order_name(VertexOrder o);
+
+// New id of every vertex (perm[old] = new) for the graph with edges
+// es[2i], es[2i+1] in 0..n-1, treated as undirected. weights (one per edge,
+// null = unit) only steer Rabbit Order. Degree is a counting sort; the
+// traversal orders build an adjacency array of 2m ids.
+std::vector<int64_t> vertex_order(const int64_t* es, size_t m, int64_t n, const double* weights,
+                                  VertexOrder order, unsigned threads = 0);
+
+// Renumbers es by perm and permutes inv_map to match, so inv_map[new] is
+// still the original id; an empty inv_map (ids used as-is) becomes the
+// inverse permutation.
+void apply_vertex_order(int64_t* es, size_t m, const std::vector<int64_t>& perm,
+                        std::vector<long long>* inv_map, unsigned threads = 0);
+
+// Mean log2(1 + |u - v|) over the edges: the average id distance between
+// neighbours, a cheap proxy for how well an order keeps them together.
+double edge_id_gap(const int64_t* es, size_t m, unsigned threads = 0);
+
+#endif // REORDER_H
@@ -0,0 +1,194 @@
+// Result writer: orders rows by original id (radix sort, skipped when ids
+// are already in order), formats them in parallel per-thread buffers and
+// writes the buffers out in order; or streams Parquet row groups.
+
+#include "result_writer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#ifdef LEIDEN_WITH_PARQUET
+#include <arrow/api.h>
+#include <arrow/io/api.h>
+#include <parquet/arrow/writer.h>
+#endif
+
+#include "edge_io.h"
+#include "parallel.h"
+#include "radix_sort.h"
+
+namespace fs = std::filesystem;
+
+OutputFormat parse_output_format(const std::string& name) {
+    if (name == "tsv") return OutputFormat::Tsv;
+    if (name == "parquet") return OutputFormat::Parquet;
+    throw std::invalid_argument("Unknown output format: " + name);
+}
+
+const char* output_format_extension(OutputFormat f) {
+    switch (f) {
+        case OutputFormat::Tsv:     return ".tsv";
+        case OutputFormat::Parquet: return ".parquet";
+    }
+    return "";
+}
+
+namespace {
+
+constexpr size_t kRowsPerBlock = size_t(1) << 20;   // rows one thread formats per round
+constexpr size_t kMaxLine = 2 * 20 + 2;             // two int64s, a tab and a newline
+constexpr size_t kParquetRowGroup = size_t(1) << 22;
+
+using VertexOrder = std::vector<int64_t, default_init_allocator<int64_t>>;
+
+struct KeyedVertex { uint64_t key; int64_t v; };
+
+// Vertices in ascending inv_map order, or empty when vertex order already is.
+VertexOrder row_order(const int64_t* inv_map, size_t n, unsigned threads) {
+    if (!inv_map || n < 2) return {};
+
+    std::vector<char> sorted(threads, 1);
+    std::vector<int64_t> lo(threads, std::numeric_limits<int64_t>::max());
+    std::vector<int64_t> hi(threads, std::numeric_limits<int64_t>::min());
+    parallel_for(n, threads, [&](size_t b, size_t e, unsigned t) {
+        for (size_t i = b; i < e; ++i) {
+            if (i > 0 && inv_map[i - 1] > inv_map[i]) sorted[t] = 0;
+            lo[t] = std::min(lo[t], inv_map[i]);
+            hi[t] = std::max(hi[t], inv_map[i]);
+        }
+    });
+    if (std::all_of(sorted.begin(), sorted.end(), [](char s) { return s != 0; })) return {};
+
+    // Keys are offsets from the smallest id, so negative ids sort correctly
+    // and only the digits the id range actually spans are processed.
+    const uint64_t min_id = (uint64_t) *std::min_element(lo.begin(), lo.end());
+    const uint64_t span = (uint64_t) *std::max_element(hi.begin(), hi.end()) - min_id;
+    std::vector<KeyedVertex, default_init_allocator<KeyedVertex>> recs(n), tmp(n);
+    parallel_for(n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) recs[i] = KeyedVertex{(uint64_t) inv_map[i] - min_id, (int64_t) i};
+    });
+    radix_sort(recs.data(), tmp.data(), n, bit_width_u64(span), [](const KeyedVertex& r) { return r.key; }, threads);
+    tmp = decltype(tmp)();
+
+    VertexOrder order(n);
+    parallel_for(n, threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; ++i) order[i] = recs[i].v;
+    });
+    return order;
+}
+
+// Row r of the output, resolved through the (possibly empty) order.
+struct Rows {
+    const int64_t* membership;
+    const int64_t* inv_map;
+    const VertexOrder& order;
+    int64_t community_base;
+
+    int64_t vertex(size_t r) const { return order.empty() ? (int64_t) r : order[r]; }
+    int64_t node(int64_t v) const { return inv_map ? inv_map[v] : v; }
+    int64_t community(int64_t v) const { return membership[v] + community_base; }
+};
+
+void write_tsv(const fs::path& path, const Rows& rows, size_t n, unsigned threads) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Cannot open output for write: " + path.string());
+
+    std::vector<std::vector<char, default_init_allocator<char>>> bufs(threads);
+    std::vector<size_t> lens(threads);
+    const size_t round = kRowsPerBlock * threads;
+    for (size_t r0 = 0; r0 < n; r0 += round) {
+        const size_t rn = std::min(round, n - r0);
+        std::fill(lens.begin(), lens.end(), 0);
+        parallel_for(rn, threads, [&](size_t b, size_t e, unsigned t) {
+            auto& buf = bufs[t];
+            buf.resize((e - b) * kMaxLine);
+            char* p = buf.data();
+            char* const end = p + buf.size();
+            for (size_t i = r0 + b; i < r0 + e; ++i) {
+                const int64_t v = rows.vertex(i);
+                p = std::to_chars(p, end, rows.node(v)).ptr;
+                *p++ = '\t';
+                p = std::to_chars(p, end, rows.community(v)).ptr;
+                *p++ = '\n';
+            }
+            lens[t] = (size_t) (p - buf.data());
+        });
+        for (unsigned t = 0; t < threads; ++t) out.write(bufs[t].data(), (std::streamsize) lens[t]);
+    }
+    out.flush();
+    if (!out) throw std::runtime_error("Failed writing output: " + path.string());
+}
+
+#ifdef LEIDEN_WITH_PARQUET
+void check(const arrow::Status& st) {
+    if (!st.ok()) throw std::runtime_error(st.ToString());
+}
+
+void write_parquet(const fs::path& path, const Rows& rows, size_t n, unsigned threads) {
+    auto schema = arrow::schema({arrow::field("node", arrow::int64(), /*nullable=*/false),
+                                 arrow::field("community", arrow::int32(), /*nullable=*/false)});
+    auto sink = arrow::io::FileOutputStream::Open(path.string());
+    check(sink.status());
+    auto opened = parquet::arrow::FileWriter::Open(*schema, arrow::default_memory_pool(), *sink);
+    check(opened.status());
+    std::unique_ptr<parquet::arrow::FileWriter> writer = std::move(opened).ValueOrDie();
+
+    const size_t group = std::min(n, kParquetRowGroup);
+    std::vector<int64_t, default_init_allocator<int64_t>> nodes(group);
+    std::vector<int32_t, default_init_allocator<int32_t>> comms(group);
+    for (size_t r0 = 0; r0 < n; r0 += group) {
+        const size_t rn = std::min(group, n - r0);
+        parallel_for(rn, threads, [&](size_t b, size_t e, unsigned) {
+            for (size_t i = b; i < e; ++i) {
+                const int64_t v = rows.vertex(r0 + i);
+                const int64_t c = rows.community(v);
+                if (c < std::numeric_limits<int32_t>::min() || c > std::numeric_limits<int32_t>::max())
+                    throw std::out_of_range("Community id " + std::to_string(c) + " does not fit the int32 Parquet column");
+                nodes[i] = rows.node(v);
+                comms[i] = (int32_t) c;
+            }
+        });
+        arrow::Int64Builder node_builder;
+        arrow::Int32Builder comm_builder;
+        std::shared_ptr<arrow::Array> node_col, comm_col;
+        check(node_builder.AppendValues(nodes.data(), (int64_t) rn));
+        check(comm_builder.AppendValues(comms.data(), (int64_t) rn));
+        check(node_builder.Finish(&node_col));
+        check(comm_builder.Finish(&comm_col));
+        auto table = arrow::Table::Make(schema, {node_col, comm_col}, (int64_t) rn);
+        check(writer->WriteTable(*table, (int64_t) rn));
+    }
+    check(writer->Close());
+    check((*sink)->Close());
+}
+#endif
+
+} // namespace
+
+void write_clusters(const fs::path& out, OutputFormat format, const int64_t* membership, size_t n,
+                    const int64_t* inv_map, int64_t community_base, unsigned threads) {
+    auto t_start = std::chrono::steady_clock::now();
+    threads = resolve_threads(threads);
+#ifndef LEIDEN_WITH_PARQUET
+    if (format == OutputFormat::Parquet)
+        throw std::runtime_error("Parquet output requested but this binary was built without Parquet support");
+#endif
+
+    const VertexOrder order = row_order(inv_map, n, threads);
+    const Rows rows{membership, inv_map, order, community_base};
+    if (format == OutputFormat::Tsv) write_tsv(out, rows, n, threads);
+#ifdef LEIDEN_WITH_PARQUET
+    else write_parquet(out, rows, n, threads);
+#endif
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+    std::cerr << "Wrote " << n << " rows to " << out << (order.empty() ? "" : " (sorted by id)") << " in "
+              << secs << " s\n";
+}
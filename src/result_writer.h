@@ -0,0 +1,30 @@
+#ifndef RESULT_WRITER_H
+#define RESULT_WRITER_H
+
+// Clustering result output: one (node id, community) row per vertex, ordered
+// by original node id.
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+enum class OutputFormat {
+    Tsv,      // "<node>\t<community>\n"
+    Parquet,  // int64 "node", int32 "community"
+};
+
+OutputFormat parse_output_format(const std::string& name);
+const char* output_format_extension(OutputFormat f);  // ".tsv" / ".parquet"
+
+// Writes membership[0..n) to `out`. Vertex v is reported as inv_map[v]
+// (or v itself when inv_map is null) with community membership[v] +
+// community_base. Rows are ordered by node id: dense ids and already-sorted
+// maps are written as they are, anything else is radix-sorted first.
+// Formatting is split across `threads`; throws on I/O errors, and for
+// Parquet when a community id does not fit in int32 or the binary was built
+// without Parquet support.
+void write_clusters(const std::filesystem::path& out, OutputFormat format, const int64_t* membership,
+                    size_t n, const int64_t* inv_map, int64_t community_base, unsigned threads = 0);
+
+#endif // RESULT_WRITER_H
@@ -1,7 +1,15 @@
+#include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <random>
+#include <stdexcept>
+#include <vector>
 
 #include "igraph/igraph.h"
+#include "libleidenalg/GraphHelper.h"
 #include "libleidenalg/Optimiser.h"
 #include "libleidenalg/CPMVertexPartition.h"
 #include "libleidenalg/ModularityVertexPartition.h"
@@ -9,85 +17,381 @@
 #include "libleidenalg/SurpriseVertexPartition.h"
 #include "libleidenalg/RBConfigurationVertexPartition.h"
 #include "libleidenalg/RBERVertexPartition.h"
+#include "convergence.h"
+#include "edge_merge.h"
+#include "graph_reduction.h"
+#include "igraph_backend.h"
+#include "native_leiden.h"
+#include "parallel.h"
 #include "run_leiden.h"
+#include "run_report.h"
 
-void run_leiden(
+// A graph built once and reused across runs. The libleidenalg Graph caches
+// degrees, strengths and total weight, so every c_leidenRun on the handle
+// skips igraph_create and that precomputation. The CSR used by the native
+// engine is built on its first native run.
+struct LeidenGraph {
+    igraph_t g;
+    Graph* graph = nullptr;
+    int64_t num_nodes = 0;
+    std::vector<double> weights;   // one per igraph edge, empty when unweighted
+    std::unique_ptr<CsrGraph> csr;
+    std::once_flag csr_once;
+};
+
+static MutableVertexPartition* make_partition(Graph* graph, int64_t modularity_option, float64_t resolution) {
+    switch (modularity_option) {
+        case CPM:             return new CPMVertexPartition(graph, resolution);
+        case MODULARITY:      return new ModularityVertexPartition(graph);
+        case SIGNIFICANCE:    return new SignificanceVertexPartition(graph);
+        case SURPRISE:        return new SurpriseVertexPartition(graph);
+        case RBCONFIGURATION: return new RBConfigurationVertexPartition(graph, resolution);
+        case RBER:            return new RBERVertexPartition(graph, resolution);
+        default:              return nullptr;
+    }
+}
+
+void c_leidenConvergenceDefaults(LeidenConvergence* convergence) {
+    convergence->max_iterations = 0;
+    convergence->min_quality_gain = 0.0;
+    convergence->min_moved_fraction = 0.0;
+    convergence->time_budget_seconds = 0.0;
+    convergence->log_iterations = 0;
+    convergence->seed = 0;
+    convergence->reduce = 0;
+}
+
+// The seed a run uses: the caller's, or a fresh one from std::random_device.
+static uint64_t run_seed(const LeidenConvergence* convergence) {
+    if (convergence && convergence->seed != 0) return (uint64_t) convergence->seed;
+    return std::random_device{}();
+}
+
+static_assert((int64_t) StopReason::Stable == LEIDEN_STOP_STABLE &&
+              (int64_t) StopReason::QualityGain == LEIDEN_STOP_QUALITY_GAIN &&
+              (int64_t) StopReason::MovedFraction == LEIDEN_STOP_MOVED_FRACTION &&
+              (int64_t) StopReason::MaxIterations == LEIDEN_STOP_MAX_ITERATIONS &&
+              (int64_t) StopReason::TimeBudget == LEIDEN_STOP_TIME_BUDGET,
+              "LeidenStopReason mirrors StopReason");
+
+// libleidenalg's optimise_partition already iterates each level to a local
+// optimum, so two calls is what c_runLeiden has always run.
+constexpr int kLibleidenalgIterations = 2;
+
+static ConvergenceOptions convergence_options(const LeidenConvergence* convergence, int default_iterations) {
+    LeidenConvergence c;
+    if (convergence) c = *convergence;
+    else c_leidenConvergenceDefaults(&c);
+    ConvergenceOptions opt;
+    opt.max_iterations = c.max_iterations < 0 ? -1
+                       : c.max_iterations == 0 ? default_iterations
+                       : (int) std::min<int64_t>(c.max_iterations, INT32_MAX);
+    opt.min_quality_gain = c.min_quality_gain;
+    opt.min_moved_fraction = c.min_moved_fraction;
+    opt.time_budget_seconds = c.time_budget_seconds;
+    opt.log = c.log_iterations != 0;
+    return opt;
+}
+
+// Creates the igraph graph and the libleidenalg Graph over es (two ids per
+// edge) and w (empty = unit weights). node_sizes (CPM vertex sizes, null =
+// 1 each) comes with an explicit correct_self_loops; without it libleidenalg
+// turns that on exactly when the graph has self-loops.
+static LeidenGraph* create_handle(std::vector<igraph_integer_t>& es, std::vector<double> w, int64_t NumNodes,
+                                  const std::vector<double>* node_sizes = nullptr, bool correct_self_loops = false);
+
+LeidenGraph* c_leidenGraphCreate(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes
+) {
+    return c_leidenGraphCreateWeighted(src, dst, nullptr, NumEdges, NumNodes, 0);
+}
+
+LeidenGraph* c_leidenGraphCreateWeighted(
     const int64_t src[], 
     const int64_t dst[], 
+    const float64_t weights[], 
     int64_t NumEdges, 
     int64_t NumNodes, 
-    int64_t modularity_option, 
-    float64_t resolution, 
-    int64_t communities[], 
-    int64_t numCommunities
+    int64_t mergeDuplicates
 ) {
-    igraph_t g;
-    igraph_vector_int_t edges;
-    igraph_vector_int_init(&edges, NumEdges * 2);
+    std::vector<igraph_integer_t> es;
+    std::vector<double> w;
+    try {
+        es.resize(NumEdges * 2);
+        if (weights) w.assign(weights, weights + NumEdges);
+    } catch (const std::bad_alloc&) {
+        std::cerr << "Error: Cannot allocate edge vector." << std::endl;
+        return nullptr;
+    }
 
     for (int64_t i = 0; i < NumEdges; i++) {
-        VECTOR(edges)[2 * i] = src[i];
-        VECTOR(edges)[2 * i + 1] = dst[i];
+        if (src[i] < 0 || src[i] >= NumNodes || dst[i] < 0 || dst[i] >= NumNodes) {
+            std::cerr << "Error: Edge endpoint out of range." << std::endl;
+            return nullptr;
+        }
+        es[2 * i] = src[i];
+        es[2 * i + 1] = dst[i];
     }
 
-    igraph_create(&g, &edges, NumNodes, IGRAPH_DIRECTED);
-    igraph_vector_int_destroy(&edges);
+    size_t m = (size_t) NumEdges;
+    if (mergeDuplicates) {
+        try {
+            m = merge_duplicate_edges(es.data(), m, NumNodes, /*directed=*/mergeDuplicates == 1,
+                                      DuplicatePolicy::Sum, SelfLoopPolicy::Keep, w);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return nullptr;
+        }
+        es.resize(2 * m);
+    }
 
-    Graph graph(&g);
+    return create_handle(es, std::move(w), NumNodes);
+}
 
-    MutableVertexPartition* partition = nullptr;
-    switch (modularity_option) {
-        case CPM:
-            partition = new CPMVertexPartition(&graph, resolution);
-            break;
-        case MODULARITY:
-            partition = new ModularityVertexPartition(&graph);
-            break;
-        case SIGNIFICANCE:
-            partition = new SignificanceVertexPartition(&graph);
-            break;
-        case SURPRISE:
-            partition = new SurpriseVertexPartition(&graph);
-            break;
-        case RBCONFIGURATION:
-            partition = new RBConfigurationVertexPartition(&graph, resolution);
-            break;
-        case RBER:
-            partition = new RBERVertexPartition(&graph, resolution);
-            break;
-        default:
-            std::cerr << "Error: Invalid modularity option selected." << std::endl;
-            igraph_destroy(&g);
-            return;
+static LeidenGraph* create_handle(std::vector<igraph_integer_t>& es, std::vector<double> w, int64_t NumNodes,
+                                  const std::vector<double>* node_sizes, bool correct_self_loops) {
+    igraph_vector_int_t edges;
+    igraph_vector_int_view(&edges, es.data(), (igraph_integer_t) es.size());
+
+    LeidenGraph* handle = new LeidenGraph;
+    handle->num_nodes = NumNodes;
+    igraph_error_t err = igraph_create(&handle->g, &edges, NumNodes, IGRAPH_DIRECTED);
+    if (err) {
+        std::cerr << "Error: igraph_create failed." << std::endl;
+        delete handle;
+        return nullptr;
     }
 
-    // Optimiser optimiser;
-    // optimiser.optimise_partition(partition);
-    
-    // Generate a seed internally
-    int seed = std::random_device{}();
+    try {
+        handle->weights = std::move(w);
+        if (node_sizes)
+            handle->graph = new Graph(&handle->g, handle->weights, *node_sizes, correct_self_loops ? 1 : 0);
+        else
+            handle->graph = handle->weights.empty() ? new Graph(&handle->g) : new Graph(&handle->g, handle->weights);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        igraph_destroy(&handle->g);
+        delete handle;
+        return nullptr;
+    }
+    return handle;
+}
 
-    Optimiser optimiser;
-    optimiser.set_rng_seed(seed);
-    for (int i = 0; i < 2; ++i) { // match 2 iterations
+// Runs `optimiser` on `partition` (n vertices) until `conv` says stop,
+// leaving the best membership seen. `before` is scratch space; history and
+// stop (optional) receive the per-iteration records and the reason it
+// stopped. Throws on libleidenalg errors.
+static void run_optimiser(Optimiser& optimiser, MutableVertexPartition* partition, int64_t n,
+                          const ConvergenceOptions& conv, std::vector<size_t>& before,
+                          std::vector<IterationRecord>* history, StopReason* stop) {
+    ConvergenceTracker tracker(conv, n);
+    before = partition->membership();
+    for (;;) {
         optimiser.optimise_partition(partition);
+        const std::vector<size_t>& after = partition->membership();
+        if (!tracker.record(partition->quality(), count_moved(before.data(), after.data(), before.size())))
+            break;
+        before = after;
+    }
+    if (tracker.reverted()) partition->set_membership(before);
+    if (history) *history = tracker.history();
+    if (stop) *stop = tracker.reason();
+}
+
+// Runs the optimiser on a fresh partition of the handle's graph until `conv`
+// says stop. Returns null on error; history and stop (optional) receive the
+// per-iteration records and the reason it stopped.
+static std::unique_ptr<MutableVertexPartition> optimise(LeidenGraph* handle, int64_t modularity_option,
+                                                        float64_t resolution, const ConvergenceOptions& conv,
+                                                        uint64_t seed, std::vector<IterationRecord>* history,
+                                                        StopReason* stop) {
+    std::unique_ptr<MutableVertexPartition> partition(make_partition(handle->graph, modularity_option, resolution));
+    if (!partition) {
+        std::cerr << "Error: Invalid modularity option selected." << std::endl;
+        return nullptr;
     }
 
+    try {
+        Optimiser optimiser;
+        optimiser.set_rng_seed(seed);
+        std::vector<size_t> before;
+        run_optimiser(optimiser, partition.get(), handle->num_nodes, conv, before, history, stop);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return nullptr;
+    }
+    return partition;
+}
 
-    numCommunities = 0;
-    for (int64_t i = 0; i < NumNodes; i++) {
-        communities[i] = partition->membership(i);
-        if (communities[i] > numCommunities) {
-            numCommunities = communities[i];
+static void extract(const LeidenGraph* handle, MutableVertexPartition& partition, int64_t communities[],
+                    int64_t* numCommunities, float64_t* quality) {
+    int64_t count = 0;
+    for (int64_t i = 0; i < handle->num_nodes; i++) {
+        communities[i] = partition.membership(i);
+        if (communities[i] > count) {
+            count = communities[i];
         }
     }
+    if (numCommunities) *numCommunities = count + 1;
+    if (quality) *quality = partition.quality();
+}
 
-    numCommunities += 1;
+int64_t c_leidenRun(
+    LeidenGraph* handle, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t communities[], 
+    int64_t* numCommunities, 
+    float64_t* quality
+) {
+    return c_leidenRunWithOptions(handle, modularity_option, resolution, nullptr, communities, numCommunities, quality);
+}
 
-    std::cout << "Leiden clustering complete. Found " << numCommunities << " communities." << std::endl;
+int64_t c_leidenRunWithOptions(
+    LeidenGraph* handle, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    const LeidenConvergence* convergence, 
+    int64_t communities[], 
+    int64_t* numCommunities, 
+    float64_t* quality
+) {
+    if (!handle) return -1;
+    std::unique_ptr<MutableVertexPartition> partition =
+        optimise(handle, modularity_option, resolution, convergence_options(convergence, kLibleidenalgIterations),
+                 run_seed(convergence), nullptr, nullptr);
+    if (!partition) return -1;
+    extract(handle, *partition, communities, numCommunities, quality);
+    return 0;
+}
 
-    delete partition;
-    igraph_destroy(&g);
+int64_t c_leidenRunWithStats(
+    LeidenGraph* handle, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    const LeidenConvergence* convergence, 
+    int64_t communities[], 
+    LeidenRunStats* stats
+) {
+    if (!handle) return -1;
+    RunReport report;
+    RunReport* rp = stats ? &report : nullptr;
+
+    RunReport::Phase optimise_phase(rp, "optimise");
+    std::vector<IterationRecord> history;
+    StopReason stop = StopReason::Stable;
+    std::unique_ptr<MutableVertexPartition> partition =
+        optimise(handle, modularity_option, resolution, convergence_options(convergence, kLibleidenalgIterations),
+                 run_seed(convergence), &history, &stop);
+    optimise_phase.finish();
+    if (!partition) return -1;
+
+    int64_t numCommunities = -1;
+    float64_t quality = 0.0;
+    RunReport::Phase extract_phase(rp, "extract");
+    extract(handle, *partition, communities, &numCommunities, &quality);
+    extract_phase.finish();
+
+    if (stats) {
+        const std::vector<PhaseStats>& ph = report.phases();   // optimise, extract
+        const int64_t numEdges = (int64_t) igraph_ecount(&handle->g);
+        *stats = LeidenRunStats();
+        stats->optimise_seconds = ph[0].wall_seconds;
+        stats->optimise_cpu_seconds = ph[0].cpu_seconds;
+        stats->optimise_peak_rss_bytes = (int64_t) ph[0].peak_rss_bytes;
+        stats->extract_seconds = ph[1].wall_seconds;
+        stats->total_seconds = ph[0].wall_seconds + ph[1].wall_seconds;
+        stats->total_cpu_seconds = ph[0].cpu_seconds + ph[1].cpu_seconds;
+        stats->peak_rss_bytes = std::max((int64_t) ph[0].peak_rss_bytes, (int64_t) ph[1].peak_rss_bytes);
+        stats->num_nodes = handle->num_nodes;
+        stats->num_edges = numEdges;
+        stats->edges_per_second = ph[0].wall_seconds > 0 ? (double) numEdges / ph[0].wall_seconds : 0.0;
+        stats->iterations = (int64_t) history.size();
+        stats->num_communities = numCommunities;
+        stats->quality = quality;
+        stats->stop_reason = (int64_t) stop;
+        stats->reduced_nodes = handle->num_nodes;
+        stats->reduced_edges = numEdges;
+    }
+    return numCommunities;
+}
+
+static int64_t native_run(const CsrGraph& csr, int64_t modularity_option, float64_t resolution,
+                          int64_t numThreads, const LeidenConvergence* convergence, int64_t communities[],
+                          int64_t* numCommunities, float64_t* quality) {
+    if (modularity_option != CPM && modularity_option != MODULARITY) {
+        std::cerr << "Error: Native engine supports only CPM and modularity." << std::endl;
+        return -1;
+    }
+    NativeLeidenOptions opt;
+    opt.modularity = modularity_option == MODULARITY;
+    opt.resolution = resolution;
+    opt.threads = numThreads > 0 ? (unsigned) numThreads : 0;
+    opt.seed = run_seed(convergence);
+    opt.convergence = convergence_options(convergence, NativeLeidenOptions().convergence.max_iterations);
+    NativeLeidenResult res = native_leiden(csr, opt);
+    std::copy(res.membership.begin(), res.membership.end(), communities);
+    if (numCommunities) *numCommunities = res.clusters;
+    if (quality) *quality = res.quality;
+    return 0;
+}
+
+int64_t c_leidenRunNative(
+    LeidenGraph* handle, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t numThreads, 
+    int64_t communities[], 
+    int64_t* numCommunities, 
+    float64_t* quality
+) {
+    if (!handle) return -1;
+    try {
+        const unsigned threads = numThreads > 0 ? (unsigned) numThreads : 0;
+        std::call_once(handle->csr_once, [&] {
+            std::vector<int64_t> src, dst;
+            edge_endpoints(&handle->g, src, dst, threads);
+            handle->csr.reset(new CsrGraph(build_csr(
+                handle->num_nodes, (int64_t) src.size(), src.data(), dst.data(),
+                handle->weights.empty() ? nullptr : handle->weights.data(), threads)));
+        });
+        return native_run(*handle->csr, modularity_option, resolution, numThreads, nullptr,
+                          communities, numCommunities, quality);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+void c_leidenGraphDestroy(LeidenGraph* handle) {
+    if (!handle) return;
+    delete handle->graph;
+    igraph_destroy(&handle->g);
+    delete handle;
+}
+
+void run_leiden(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t communities[], 
+    int64_t numCommunities
+) {
+    LeidenGraph* handle = c_leidenGraphCreate(src, dst, NumEdges, NumNodes);
+    if (!handle) return;
+
+    numCommunities = 0;
+    if (c_leidenRun(handle, modularity_option, resolution, communities, &numCommunities, nullptr) == 0) {
+        std::cout << "Leiden clustering complete. Found " << numCommunities << " communities." << std::endl;
+    }
+
+    c_leidenGraphDestroy(handle);
 }
 
 // C-compatible wrapper for Chapel
@@ -102,6 +406,333 @@ int64_t c_runLeiden(
     int64_t numCommunities
 ) {
     //std::cout << "Calling run_leiden from Chapel..." << std::endl;
-    run_leiden(src, dst, NumEdges, NumNodes, modularity_option, resolution, communities, numCommunities);
+    (void) numCommunities;
+    return c_runLeidenWithStats(src, dst, NumEdges, NumNodes, modularity_option, resolution, communities, nullptr);
+}
+
+int64_t c_runLeidenWithStats(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t communities[], 
+    LeidenRunStats* stats
+) {
+    return c_runLeidenWithOptions(src, dst, NumEdges, NumNodes, modularity_option, resolution, nullptr,
+                                  communities, stats);
+}
+
+// Folds pendant vertices (reduce >= 2: also degree-2 chains) out of the edge
+// list and builds the libleidenalg graph over what is left, node sizes
+// carrying the folded vertices for CPM. Groups folded into isolation stay in
+// the graph, and bare isolated vertices are dropped only where they add
+// nothing to the quality, so the quality libleidenalg reports is exactly
+// that of the expanded partition. Returns null on error.
+static LeidenGraph* reduced_graph_create(const int64_t src[], const int64_t dst[], int64_t NumEdges, int64_t NumNodes,
+                                         int64_t modularity_option, float64_t resolution, int64_t reduce,
+                                         GraphReduction* reduction) {
+    if (modularity_option != CPM && modularity_option != MODULARITY) {
+        std::cerr << "Error: Graph reduction supports only CPM and modularity." << std::endl;
+        return nullptr;
+    }
+    bool loops = false;
+    for (int64_t i = 0; i < NumEdges; i++) {
+        if (src[i] < 0 || src[i] >= NumNodes || dst[i] < 0 || dst[i] >= NumNodes) {
+            std::cerr << "Error: Edge endpoint out of range." << std::endl;
+            return nullptr;
+        }
+        loops = loops || src[i] == dst[i];
+    }
+
+    ReductionOptions opt;
+    opt.mode = reduce >= 2 ? Reduction::Chains : Reduction::Pendants;
+    opt.drop_folded = false;
+    opt.drop_isolated = modularity_option == MODULARITY || !loops;
+    std::vector<igraph_integer_t> es;
+    try {
+        // The fold guard compares against degrees for modularity (1 / 2m per
+        // unit of strength), against vertex counts for CPM.
+        std::vector<double> strength;
+        double gamma = resolution;
+        if (modularity_option == MODULARITY) {
+            strength.assign((size_t) NumNodes, 0.0);
+            for (int64_t i = 0; i < NumEdges; i++) {
+                strength[(size_t) src[i]] += 1.0;
+                strength[(size_t) dst[i]] += 1.0;
+            }
+            gamma = NumEdges > 0 ? 1.0 / (2.0 * (double) NumEdges) : 0.0;
+        }
+        *reduction = reduce_graph(src, dst, (size_t) NumEdges, NumNodes, nullptr,
+                                  strength.empty() ? nullptr : strength.data(), gamma, opt);
+        es.assign(reduction->edges.begin(), reduction->edges.end());
+        std::vector<int64_t>().swap(reduction->edges);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return nullptr;
+    }
+    return create_handle(es, std::move(reduction->weights), reduction->n,
+                         modularity_option == CPM ? &reduction->node_weights : nullptr, loops);
+}
+
+int64_t c_runLeidenWithOptions(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    const LeidenConvergence* convergence, 
+    int64_t communities[], 
+    LeidenRunStats* stats
+) {
+    // Phases are only measured when someone asked for them.
+    RunReport report;
+    RunReport* rp = stats ? &report : nullptr;
+
+    RunReport::Phase build_phase(rp, "build");
+    const bool reduce = convergence && convergence->reduce != 0;
+    GraphReduction reduction;
+    LeidenGraph* handle = reduce ? reduced_graph_create(src, dst, NumEdges, NumNodes, modularity_option, resolution,
+                                                        convergence->reduce, &reduction)
+                                 : c_leidenGraphCreate(src, dst, NumEdges, NumNodes);
+    if (!handle) return -1;
+    build_phase.finish();
+    if (reduce) {
+        const ReductionStats& rs = reduction.stats;
+        std::cout << "Reduced graph: " << rs.reduced_vertices << " of " << rs.vertices << " nodes, "
+                  << rs.reduced_edges << " of " << rs.edges << " edges (" << rs.pendants << " pendants folded, "
+                  << rs.chains << " chain nodes contracted, " << rs.dropped << " isolated dropped)" << std::endl;
+    }
+
+    RunReport::Phase optimise_phase(rp, "optimise");
+    std::vector<IterationRecord> history;
+    StopReason stop = StopReason::Stable;
+    std::unique_ptr<MutableVertexPartition> partition =
+        optimise(handle, modularity_option, resolution, convergence_options(convergence, kLibleidenalgIterations),
+                 run_seed(convergence), &history, &stop);
+    optimise_phase.finish();
+
+    int64_t numCommunities = -1;
+    float64_t quality = 0.0;
+    RunReport::Phase extract_phase(rp, "extract");
+    if (partition && reduce) {
+        std::vector<int64_t> reduced((size_t) handle->num_nodes);
+        extract(handle, *partition, reduced.data(), &numCommunities, &quality);
+        numCommunities = expand_membership(reduction, reduced.data(), numCommunities, communities);
+    } else if (partition) {
+        extract(handle, *partition, communities, &numCommunities, &quality);
+    }
+    if (partition) {
+        std::cout << "Leiden clustering complete. Found " << numCommunities << " communities." << std::endl;
+    }
+    partition.reset();
+    c_leidenGraphDestroy(handle);
+    extract_phase.finish();
+
+    if (stats) {
+        const std::vector<PhaseStats>& ph = report.phases();   // build, optimise, extract
+        *stats = LeidenRunStats();
+        stats->build_seconds = ph[0].wall_seconds;
+        stats->build_cpu_seconds = ph[0].cpu_seconds;
+        stats->build_peak_rss_bytes = (int64_t) ph[0].peak_rss_bytes;
+        stats->optimise_seconds = ph[1].wall_seconds;
+        stats->optimise_cpu_seconds = ph[1].cpu_seconds;
+        stats->optimise_peak_rss_bytes = (int64_t) ph[1].peak_rss_bytes;
+        stats->extract_seconds = ph[2].wall_seconds;
+        stats->total_seconds = ph[0].wall_seconds + ph[1].wall_seconds + ph[2].wall_seconds;
+        stats->total_cpu_seconds = ph[0].cpu_seconds + ph[1].cpu_seconds + ph[2].cpu_seconds;
+        for (const PhaseStats& p : ph)
+            stats->peak_rss_bytes = std::max(stats->peak_rss_bytes, (int64_t) p.peak_rss_bytes);
+        stats->num_nodes = NumNodes;
+        stats->num_edges = NumEdges;
+        stats->edges_per_second = ph[1].wall_seconds > 0 ? (double) NumEdges / ph[1].wall_seconds : 0.0;
+        stats->iterations = (int64_t) history.size();
+        stats->num_communities = numCommunities;
+        stats->quality = quality;
+        stats->stop_reason = (int64_t) stop;
+        stats->reduced_nodes = reduce ? reduction.stats.reduced_vertices : NumNodes;
+        stats->reduced_edges = reduce ? reduction.stats.reduced_edges : NumEdges;
+    }
+    return numCommunities;
+}
+
+int64_t c_runLeidenNative(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t numThreads, 
+    int64_t communities[]
+) {
+    return c_runLeidenNativeWithOptions(src, dst, NumEdges, NumNodes, modularity_option, resolution, numThreads,
+                                        nullptr, communities);
+}
+
+int64_t c_runLeidenNativeWithOptions(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t numThreads, 
+    const LeidenConvergence* convergence, 
+    int64_t communities[]
+) {
+    int64_t numCommunities = -1;
+    try {
+        CsrGraph csr = build_csr(NumNodes, NumEdges, src, dst, nullptr,
+                                 numThreads > 0 ? (unsigned) numThreads : 0);
+        if (native_run(csr, modularity_option, resolution, numThreads, convergence, communities,
+                       &numCommunities, nullptr) != 0)
+            return -1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+    std::cout << "Leiden clustering complete. Found " << numCommunities << " communities." << std::endl;
     return numCommunities;
 }
+
+// ---------- Batch API ----------
+
+// Buffers a batch worker reuses from one graph to the next.
+struct BatchScratch {
+    std::vector<igraph_integer_t> es;
+    std::vector<double> weights;
+    std::vector<size_t> before;
+    Optimiser optimiser;
+};
+
+// Clusters one graph of a batch into out[0..n) and returns its community
+// count. Edgeless graphs are all singletons and skip igraph entirely. Throws
+// on bad input or libleidenalg errors.
+static int64_t cluster_batch_graph(BatchScratch& s, const int64_t src[], const int64_t dst[],
+                                   const float64_t weights[], int64_t m, int64_t n, int64_t modularity_option,
+                                   float64_t resolution, const ConvergenceOptions& conv, int64_t out[],
+                                   float64_t* quality) {
+    *quality = 0.0;
+    if (m == 0) {
+        std::iota(out, out + n, (int64_t) 0);
+        return n;
+    }
+
+    s.es.resize(2 * (size_t) m);
+    for (int64_t i = 0; i < m; i++) {
+        if (src[i] < 0 || src[i] >= n || dst[i] < 0 || dst[i] >= n)
+            throw std::out_of_range("edge endpoint out of range");
+        s.es[2 * i] = src[i];
+        s.es[2 * i + 1] = dst[i];
+    }
+    if (weights) s.weights.assign(weights, weights + m);
+
+    igraph_vector_int_t edges;
+    igraph_vector_int_view(&edges, s.es.data(), (igraph_integer_t) s.es.size());
+    igraph_t g;
+    if (igraph_create(&g, &edges, n, IGRAPH_DIRECTED)) throw std::runtime_error("igraph_create failed");
+
+    int64_t count = 0;
+    try {
+        std::unique_ptr<Graph> graph(weights ? new Graph(&g, s.weights) : new Graph(&g));
+        std::unique_ptr<MutableVertexPartition> partition(make_partition(graph.get(), modularity_option, resolution));
+        run_optimiser(s.optimiser, partition.get(), n, conv, s.before, nullptr, nullptr);
+        for (int64_t i = 0; i < n; i++) {
+            out[i] = partition->membership(i);
+            count = std::max(count, out[i] + 1);
+        }
+        *quality = partition->quality();
+    } catch (...) {
+        igraph_destroy(&g);
+        throw;
+    }
+    igraph_destroy(&g);
+    return count;
+}
+
+int64_t c_runLeidenBatch(
+    const int64_t src[], 
+    const int64_t dst[], 
+    const float64_t weights[], 
+    const int64_t edgeOffsets[], 
+    const int64_t nodeCounts[], 
+    int64_t numGraphs, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    const LeidenConvergence* convergence, 
+    int64_t numThreads, 
+    int64_t communities[], 
+    int64_t numCommunities[], 
+    float64_t quality[]
+) {
+    if (numGraphs < 0 || (numGraphs > 0 && (!edgeOffsets || !nodeCounts || !communities))) return -1;
+    if (modularity_option < CPM || modularity_option > RBER) {
+        std::cerr << "Error: Invalid modularity option selected." << std::endl;
+        return -1;
+    }
+    // The offsets must start at 0 and rise monotonically, so together they
+    // cover src/dst[0 .. edgeOffsets[numGraphs]) exactly once.
+    if (numGraphs > 0 && edgeOffsets[0] != 0) {
+        std::cerr << "Error: Batch edge offsets must start at 0." << std::endl;
+        return -1;
+    }
+    if (numGraphs > 0 && edgeOffsets[numGraphs] > 0 && (!src || !dst)) {
+        std::cerr << "Error: Batch has edges but no src/dst arrays." << std::endl;
+        return -1;
+    }
+    std::vector<int64_t> node_offsets((size_t) numGraphs + 1, 0);
+    for (int64_t i = 0; i < numGraphs; i++) {
+        if (nodeCounts[i] < 0 || edgeOffsets[i + 1] < edgeOffsets[i]) {
+            std::cerr << "Error: Invalid batch offsets for graph " << i << "." << std::endl;
+            return -1;
+        }
+        node_offsets[i + 1] = node_offsets[i] + nodeCounts[i];
+    }
+
+    // Per-graph progress would serialise the workers on stdout.
+    ConvergenceOptions conv = convergence_options(convergence, kLibleidenalgIterations);
+    conv.log = false;
+
+    // Workers claim the next unclaimed graph, largest first, so the batch
+    // ends on the cheapest graphs instead of waiting on one big straggler.
+    std::vector<int64_t> order((size_t) numGraphs);
+    std::iota(order.begin(), order.end(), (int64_t) 0);
+    std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+        return edgeOffsets[a + 1] - edgeOffsets[a] > edgeOffsets[b + 1] - edgeOffsets[b];
+    });
+
+    unsigned threads = resolve_threads(numThreads > 0 ? (unsigned) numThreads : 0);
+    threads = (unsigned) std::max<int64_t>(1, std::min<int64_t>(threads, numGraphs));
+    std::atomic<int64_t> next{0}, failed{0};
+    try {
+        run_parallel(threads, [&](unsigned) {
+            BatchScratch scratch;
+            const bool fixed_seed = convergence && convergence->seed != 0;
+            if (!fixed_seed) scratch.optimiser.set_rng_seed(std::random_device{}());
+            for (int64_t k; (k = next.fetch_add(1, std::memory_order_relaxed)) < numGraphs;) {
+                const int64_t i = order[(size_t) k];
+                // With a fixed seed each graph gets its own, whichever worker runs it.
+                if (fixed_seed) scratch.optimiser.set_rng_seed((size_t) convergence->seed + (size_t) i);
+                const int64_t e0 = edgeOffsets[i];
+                int64_t count = -1;
+                float64_t q = 0.0;
+                try {
+                    count = cluster_batch_graph(scratch, src + e0, dst + e0, weights ? weights + e0 : nullptr,
+                                                edgeOffsets[i + 1] - e0, nodeCounts[i], modularity_option,
+                                                resolution, conv, communities + node_offsets[(size_t) i], &q);
+                } catch (const std::exception&) {
+                    failed.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (numCommunities) numCommunities[i] = count;
+                if (quality) quality[i] = q;
+            }
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return -1;
+    }
+    return failed.load();
+}
@@ -14,10 +14,99 @@ enum ModularityType : int64_t {
     RBER
 };
 
+// Why an optimisation stopped (LeidenRunStats::stop_reason).
+enum LeidenStopReason : int64_t {
+    LEIDEN_STOP_STABLE,          // an iteration moved no vertex
+    LEIDEN_STOP_QUALITY_GAIN,    // gain below min_quality_gain, or quality fell (that iteration is undone)
+    LEIDEN_STOP_MOVED_FRACTION,  // fewer than min_moved_fraction of the vertices moved
+    LEIDEN_STOP_MAX_ITERATIONS,
+    LEIDEN_STOP_TIME_BUDGET
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Opaque handle to a graph that is built once and clustered many times.
+typedef struct LeidenGraph LeidenGraph;
+
+// When the optimiser stops iterating, and how a run is seeded and prepared.
+// Start from c_leidenConvergenceDefaults
+// and change what you need; a NULL LeidenConvergence* means the defaults.
+typedef struct LeidenConvergence {
+    int64_t max_iterations;          // 0 = engine default (libleidenalg 2, native 50), < 0 = until stable
+    float64_t min_quality_gain;      // > 0: stop once an iteration gains less than this, relative to |quality|
+    float64_t min_moved_fraction;    // > 0: stop once an iteration moves fewer than this fraction of vertices
+    float64_t time_budget_seconds;   // > 0: return the best partition found within this wall time
+    int64_t log_iterations;          // non-zero: quality, moves and time of each iteration on stderr
+    int64_t seed;                    // non-zero: fixed optimiser seed, so reruns give the same partition; 0 = random
+    int64_t reduce;                  // c_runLeidenWithOptions, CPM and MODULARITY: 1 = fold pendant nodes into their
+                                     // neighbour first, 2 = also contract degree-2 chains; 0 = cluster the graph as given
+} LeidenConvergence;
+
+void c_leidenConvergenceDefaults(LeidenConvergence* convergence);
+
+// Builds the graph (igraph + libleidenalg, including degree and weight
+// precomputation). Returns NULL on failure.
+LeidenGraph* c_leidenGraphCreate(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes
+);
+
+// Like c_leidenGraphCreate, with optional per-edge weights (NULL = unit) and
+// duplicate merging: mergeDuplicates 0 keeps every edge, 1 merges repeated
+// (u,v) pairs, 2 also treats (u,v) and (v,u) as the same pair. Weights of
+// merged edges are summed. Self-loops are kept.
+LeidenGraph* c_leidenGraphCreateWeighted(
+    const int64_t src[], 
+    const int64_t dst[], 
+    const float64_t weights[], 
+    int64_t NumEdges, 
+    int64_t NumNodes, 
+    int64_t mergeDuplicates
+);
+
+// Clusters the graph behind `handle`; communities[] must hold NumNodes entries.
+// numCommunities and quality are optional outputs. Returns 0 on success.
+int64_t c_leidenRun(
+    LeidenGraph* handle, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t communities[], 
+    int64_t* numCommunities, 
+    float64_t* quality
+);
+
+// c_leidenRun with explicit stopping rules (NULL = defaults). An iteration
+// that lowers quality is undone, so the partition returned is the best seen.
+int64_t c_leidenRunWithOptions(
+    LeidenGraph* handle, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    const LeidenConvergence* convergence, 
+    int64_t communities[], 
+    int64_t* numCommunities, 
+    float64_t* quality
+);
+
+// Same as c_leidenRun but with the native multithreaded engine (CPM and
+// MODULARITY only; edge direction is ignored). numThreads <= 0 uses every
+// core. quality follows igraph_community_leiden's convention, see
+// native_leiden.h. Returns 0 on success.
+int64_t c_leidenRunNative(
+    LeidenGraph* handle, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t numThreads, 
+    int64_t communities[], 
+    int64_t* numCommunities, 
+    float64_t* quality
+);
+
+void c_leidenGraphDestroy(LeidenGraph* handle);
+
 void run_leiden(
     const int64_t src[], 
     const int64_t dst[], 
@@ -29,7 +118,8 @@ void run_leiden(
     int64_t numCommunities
 );
 
-// C wrapper for Chapel
+// C wrapper for Chapel: one-shot create/run/destroy. Returns the number of
+// communities, or -1 on error (numCommunities is unused, kept for ABI).
 int64_t c_runLeiden(
     const int64_t src[], 
     const int64_t dst[], 
@@ -41,6 +131,124 @@ int64_t c_runLeiden(
     int64_t numCommunities
 );
 
+// Where a one-shot run spent its time and memory. Times are wall / CPU
+// seconds (CPU summed over threads); peak RSS is the process high-water mark
+// during the phase.
+typedef struct LeidenRunStats {
+    float64_t build_seconds;          // edge copy, graph reduction, igraph_create, Graph precomputation
+    float64_t build_cpu_seconds;
+    int64_t build_peak_rss_bytes;
+    float64_t optimise_seconds;       // all optimiser iterations
+    float64_t optimise_cpu_seconds;
+    int64_t optimise_peak_rss_bytes;
+    float64_t extract_seconds;        // membership copy-out
+    float64_t total_seconds;
+    float64_t total_cpu_seconds;
+    int64_t peak_rss_bytes;           // max over the phases
+    int64_t num_nodes;
+    int64_t num_edges;
+    float64_t edges_per_second;       // num_edges / optimise_seconds
+    int64_t iterations;
+    int64_t num_communities;
+    float64_t quality;
+    int64_t stop_reason;              // LeidenStopReason
+    int64_t reduced_nodes;            // what the optimiser ran on (num_nodes / num_edges without reduction)
+    int64_t reduced_edges;
+} LeidenRunStats;
+
+// c_runLeiden that also fills *stats (optional, may be NULL). Returns the
+// number of communities, or -1 on error.
+int64_t c_runLeidenWithStats(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t communities[], 
+    LeidenRunStats* stats
+);
+
+// c_leidenRunWithOptions that also fills *stats (optional, may be NULL):
+// optimise / extract timings, iterations, quality and stop reason; the build
+// fields are left 0 since the handle already exists. Returns the number of
+// communities, or -1 on error.
+int64_t c_leidenRunWithStats(
+    LeidenGraph* handle, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    const LeidenConvergence* convergence, 
+    int64_t communities[], 
+    LeidenRunStats* stats
+);
+
+// c_runLeidenWithStats with explicit stopping rules (NULL = defaults).
+int64_t c_runLeidenWithOptions(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    const LeidenConvergence* convergence, 
+    int64_t communities[], 
+    LeidenRunStats* stats
+);
+
+// One-shot native run; builds only the CSR (no igraph/libleidenalg graph).
+// Returns the number of communities, or -1 on error.
+int64_t c_runLeidenNativeWithOptions(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t numThreads, 
+    const LeidenConvergence* convergence, 
+    int64_t communities[]
+);
+
+// c_runLeidenNativeWithOptions with the default stopping rules.
+int64_t c_runLeidenNative(
+    const int64_t src[], 
+    const int64_t dst[], 
+    int64_t NumEdges, 
+    int64_t NumNodes, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    int64_t numThreads, 
+    int64_t communities[]
+);
+
+// Clusters numGraphs independent graphs in one call, e.g. thousands of ego
+// networks or clusters being re-split. Graph i has nodeCounts[i] nodes and
+// the edges src/dst[edgeOffsets[i] .. edgeOffsets[i+1]) (numGraphs + 1
+// non-decreasing offsets, edgeOffsets[0] = 0) with endpoints numbered 0..nodeCounts[i]-1; weights (NULL = unit)
+// is indexed like src. Its membership is written to communities[] starting
+// at nodeCounts[0] + ... + nodeCounts[i-1]. numCommunities[] and quality[]
+// (optional) receive one entry per graph; a graph that fails gets -1
+// communities. Graphs run with libleidenalg on numThreads workers (<= 0:
+// every core), largest first; nothing is printed per graph, and
+// convergence->log_iterations is ignored. Concurrent workers need igraph
+// built with thread-local storage (IGRAPH_ENABLE_TLS). Returns the number of
+// graphs that failed (0 = all clustered), or -1 on invalid arguments.
+int64_t c_runLeidenBatch(
+    const int64_t src[], 
+    const int64_t dst[], 
+    const float64_t weights[], 
+    const int64_t edgeOffsets[], 
+    const int64_t nodeCounts[], 
+    int64_t numGraphs, 
+    int64_t modularity_option, 
+    float64_t resolution, 
+    const LeidenConvergence* convergence, 
+    int64_t numThreads, 
+    int64_t communities[], 
+    int64_t numCommunities[], 
+    float64_t quality[]
+);
+
 #ifdef __cplusplus
 }
 #endif
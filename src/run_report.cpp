@@ -0,0 +1,180 @@
+// Run report: phase timers, resource readings and the JSON writer.
+
+#include "run_report.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include <sys/resource.h>
+
+namespace {
+
+double wall_seconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string json_number(double x) {
+    if (!std::isfinite(x)) return "null";
+    std::ostringstream os;
+    os << std::setprecision(15) << x;
+    return os.str();
+}
+
+// Phases currently open in the process; only the outermost resets the peak.
+std::atomic<int> open_phases{0};
+
+double per_second(uint64_t count, double seconds) {
+    return seconds > 0 ? (double) count / seconds : 0.0;
+}
+
+} // namespace
+
+std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char) c < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof buf, "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+double process_cpu_seconds() {
+    struct rusage ru;
+    if (::getrusage(RUSAGE_SELF, &ru) != 0) return 0.0;
+    return (double) ru.ru_utime.tv_sec + 1e-6 * (double) ru.ru_utime.tv_usec +
+           (double) ru.ru_stime.tv_sec + 1e-6 * (double) ru.ru_stime.tv_usec;
+}
+
+uint64_t peak_rss_bytes() {
+    if (FILE* f = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        unsigned long long kb = 0;
+        bool found = false;
+        while (!found && std::fgets(line, sizeof line, f))
+            found = std::sscanf(line, "VmHWM: %llu kB", &kb) == 1;
+        std::fclose(f);
+        if (found) return (uint64_t) kb * 1024;
+    }
+    struct rusage ru;
+    if (::getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return (uint64_t) ru.ru_maxrss * 1024;
+}
+
+bool reset_peak_rss() {
+    FILE* f = std::fopen("/proc/self/clear_refs", "w");
+    if (!f) return false;
+    const bool ok = std::fputs("5", f) >= 0;
+    return std::fclose(f) == 0 && ok;
+}
+
+// ---------- RunReport::Phase ----------
+
+RunReport::Phase::Phase(RunReport* report, std::string name) : report_(report) {
+    if (!report_) return;
+    stats_.name = std::move(name);
+    if (open_phases.fetch_add(1) == 0) reset_peak_rss();
+    wall_start_ = wall_seconds();
+    cpu_start_ = process_cpu_seconds();
+}
+
+void RunReport::Phase::finish() {
+    if (!report_ || done_) return;
+    done_ = true;
+    stats_.wall_seconds = wall_seconds() - wall_start_;
+    stats_.cpu_seconds = process_cpu_seconds() - cpu_start_;
+    stats_.peak_rss_bytes = peak_rss_bytes();
+    open_phases.fetch_sub(1);
+    report_->phases_.push_back(std::move(stats_));
+}
+
+// ---------- RunReport ----------
+
+RunReport::RunReport() : wall_start_(wall_seconds()), cpu_start_(process_cpu_seconds()) {}
+
+void RunReport::put(const std::string& key, std::string json) {
+    for (auto& kv : info_) if (kv.first == key) { kv.second = std::move(json); return; }
+    info_.emplace_back(key, std::move(json));
+}
+
+void RunReport::set(const std::string& key, const std::string& value) { put(key, json_string(value)); }
+
+void RunReport::set(const std::string& key, double value) { put(key, json_number(value)); }
+
+void RunReport::set(const std::string& key, int64_t value) { put(key, std::to_string(value)); }
+
+double RunReport::total_wall_seconds() const { return wall_seconds() - wall_start_; }
+
+void RunReport::print(std::ostream& os) const {
+    const auto flags = os.flags();
+    const auto prec = os.precision();
+    os << std::fixed << std::setprecision(3);
+    os << std::left << std::setw(14) << "phase" << std::right << std::setw(10) << "wall s" << std::setw(10)
+       << "cpu s" << std::setw(14) << "peak RSS MB" << "   throughput\n";
+    for (const auto& p : phases_) {
+        os << std::left << std::setw(14) << p.name << std::right << std::setw(10) << p.wall_seconds
+           << std::setw(10) << p.cpu_seconds << std::setw(14) << (double) p.peak_rss_bytes / (1 << 20);
+        if (p.edges) os << "   " << std::setprecision(0) << per_second(p.edges, p.wall_seconds) << " edges/s";
+        else if (p.bytes) os << "   " << std::setprecision(1) << per_second(p.bytes, p.wall_seconds) / (1 << 20) << " MB/s";
+        os << std::setprecision(3) << "\n";
+    }
+    os << std::left << std::setw(14) << "total" << std::right << std::setw(10) << total_wall_seconds()
+       << std::setw(10) << process_cpu_seconds() - cpu_start_ << "\n";
+    os.flags(flags);
+    os.precision(prec);
+}
+
+void RunReport::write_json(const std::filesystem::path& path) const {
+    std::ostringstream os;
+    os << "{\n  \"run\": {";
+    for (size_t i = 0; i < info_.size(); ++i)
+        os << (i ? "," : "") << "\n    " << json_string(info_[i].first) << ": " << info_[i].second;
+    os << (info_.empty() ? "" : "\n  ") << "},\n  \"phases\": [";
+    uint64_t peak = 0;
+    for (size_t i = 0; i < phases_.size(); ++i) {
+        const PhaseStats& p = phases_[i];
+        peak = std::max(peak, p.peak_rss_bytes);
+        os << (i ? "," : "") << "\n    {\"name\": " << json_string(p.name)
+           << ", \"wall_seconds\": " << json_number(p.wall_seconds)
+           << ", \"cpu_seconds\": " << json_number(p.cpu_seconds)
+           << ", \"peak_rss_bytes\": " << p.peak_rss_bytes
+           << ", \"bytes\": " << p.bytes
+           << ", \"edges\": " << p.edges
+           << ", \"bytes_per_second\": " << json_number(per_second(p.bytes, p.wall_seconds))
+           << ", \"edges_per_second\": " << json_number(per_second(p.edges, p.wall_seconds));
+        if (!p.iteration_seconds.empty()) {
+            os << ", \"iteration_seconds\": [";
+            for (size_t k = 0; k < p.iteration_seconds.size(); ++k)
+                os << (k ? ", " : "") << json_number(p.iteration_seconds[k]);
+            os << "]";
+        }
+        os << "}";
+    }
+    peak = std::max(peak, peak_rss_bytes());
+    os << (phases_.empty() ? "" : "\n  ") << "],\n  \"total\": {\"wall_seconds\": "
+       << json_number(total_wall_seconds()) << ", \"cpu_seconds\": "
+       << json_number(process_cpu_seconds() - cpu_start_) << ", \"peak_rss_bytes\": " << peak << "}\n}\n";
+
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot open report for write: " + path.string());
+    out << os.str();
+    if (!out) throw std::runtime_error("Failed writing report: " + path.string());
+}
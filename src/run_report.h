@@ -0,0 +1,92 @@
+#ifndef RUN_REPORT_H
+#define RUN_REPORT_H
+
+// Per-phase instrumentation: wall and CPU time, peak RSS and bytes / edges
+// handled, collected into a run report that can be printed or saved as JSON.
+
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct PhaseStats {
+    std::string name;
+    double wall_seconds = 0.0;
+    double cpu_seconds = 0.0;              // user + system over all threads
+    uint64_t peak_rss_bytes = 0;           // RSS high-water mark during the phase
+    uint64_t bytes = 0;                    // bytes read or written, 0 if not applicable
+    uint64_t edges = 0;                    // edges processed, 0 if not applicable
+    std::vector<double> iteration_seconds; // optimisation phases: wall time per iteration
+};
+
+// Process CPU time (user + system, all threads) in seconds.
+double process_cpu_seconds();
+
+// Peak resident set size so far (VmHWM, falling back to getrusage).
+uint64_t peak_rss_bytes();
+
+// Restarts the peak-RSS high-water mark at the current RSS so the next
+// reading covers only what follows. Returns false where the kernel does not
+// allow it; readings are then process-wide peaks.
+bool reset_peak_rss();
+
+// s as a quoted JSON string, with quotes, backslashes and control
+// characters escaped.
+std::string json_string(const std::string& s);
+
+class RunReport {
+public:
+    // Scoped timer: measures from construction to finish() / destruction and
+    // appends the phase to `report`. A null report makes it a no-op. An
+    // outermost phase restarts the peak-RSS mark; a nested phase reports the
+    // peak since its outermost phase began.
+    class Phase {
+    public:
+        Phase(RunReport* report, std::string name);
+        ~Phase() { finish(); }
+        Phase(const Phase&) = delete;
+        Phase& operator=(const Phase&) = delete;
+
+        void add_bytes(uint64_t b) { stats_.bytes += b; }
+        void add_edges(uint64_t e) { stats_.edges += e; }
+        void set_iteration_seconds(std::vector<double> s) { stats_.iteration_seconds = std::move(s); }
+        void finish();
+
+    private:
+        RunReport* report_;
+        PhaseStats stats_;
+        double wall_start_ = 0.0;
+        double cpu_start_ = 0.0;
+        bool done_ = false;
+    };
+
+    RunReport();
+
+    // Run-level facts (input, objective, sizes, result), kept in insertion
+    // order; setting a key again overwrites it.
+    void set(const std::string& key, const std::string& value);
+    void set(const std::string& key, const char* value) { set(key, std::string(value)); }
+    void set(const std::string& key, double value);
+    void set(const std::string& key, int64_t value);
+
+    const std::vector<PhaseStats>& phases() const { return phases_; }
+    double total_wall_seconds() const;
+
+    // One line per phase: wall, CPU, peak RSS and throughput.
+    void print(std::ostream& os) const;
+
+    // {"run": {...}, "phases": [...], "total": {...}}. Throws on I/O errors.
+    void write_json(const std::filesystem::path& path) const;
+
+private:
+    void put(const std::string& key, std::string json);
+
+    std::vector<std::pair<std::string, std::string>> info_;  // key, JSON-encoded value
+    std::vector<PhaseStats> phases_;
+    double wall_start_;
+    double cpu_start_;
+};
+
+#endif // RUN_REPORT_H
@@ -0,0 +1,93 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Fixed-size worker pool with a FIFO task queue.
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "parallel.h"
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads) {
+        threads = resolve_threads(threads);
+        workers_.reserve(threads);
+        for (unsigned t = 0; t < threads; ++t) workers_.emplace_back([this, t] { loop(t); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& w : workers_) w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return (unsigned) workers_.size(); }
+
+    // Tasks receive the index of the worker running them (0..size()-1), so
+    // callers can keep per-worker scratch space.
+    void submit(std::function<void(unsigned)> task) {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            queue_.push_back(std::move(task));
+            ++pending_;
+        }
+        cv_.notify_one();
+    }
+
+    // Blocks until every submitted task has finished, then rethrows the first
+    // exception any of them raised.
+    void wait() {
+        std::unique_lock<std::mutex> lk(mu_);
+        done_cv_.wait(lk, [this] { return pending_ == 0; });
+        if (error_) {
+            auto e = error_;
+            error_ = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+
+private:
+    void loop(unsigned worker) {
+        for (;;) {
+            std::function<void(unsigned)> task;
+            {
+                std::unique_lock<std::mutex> lk(mu_);
+                cv_.wait(lk, [this] { return stop_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                task = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            std::exception_ptr err;
+            try { task(worker); } catch (...) { err = std::current_exception(); }
+            {
+                std::lock_guard<std::mutex> lk(mu_);
+                if (err && !error_) error_ = err;
+                if (--pending_ == 0) done_cv_.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void(unsigned)>> queue_;
+    std::mutex mu_;
+    std::condition_variable cv_, done_cv_;
+    size_t pending_ = 0;
+    bool stop_ = false;
+    std::exception_ptr error_;
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,49 @@
+#ifndef UNION_FIND_H
+#define UNION_FIND_H
+
+// Lock-free union-find for concurrent unite() calls over an edge array.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "parallel.h"
+
+class ConcurrentUnionFind {
+public:
+    ConcurrentUnionFind(int64_t n, unsigned threads) : n_(n), parent_(new std::atomic<int64_t>[n]) {
+        parallel_for((size_t) n, resolve_threads(threads), [&](size_t b, size_t e, unsigned) {
+            for (size_t i = b; i < e; ++i) parent_[i].store((int64_t) i, std::memory_order_relaxed);
+        });
+    }
+
+    int64_t size() const { return n_; }
+
+    // Root with path halving. Roots are always the smallest index of their set,
+    // so the result does not depend on the order of unite() calls.
+    int64_t find(int64_t x) {
+        for (;;) {
+            int64_t p = parent_[x].load(std::memory_order_relaxed);
+            if (p == x) return x;
+            int64_t gp = parent_[p].load(std::memory_order_relaxed);
+            if (gp != p) parent_[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            x = gp;
+        }
+    }
+
+    void unite(int64_t a, int64_t b) {
+        for (;;) {
+            a = find(a); b = find(b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);   // link the larger root under the smaller
+            int64_t expected = a;
+            if (parent_[a].compare_exchange_strong(expected, b, std::memory_order_acq_rel)) return;
+        }
+    }
+
+private:
+    int64_t n_;
+    std::unique_ptr<std::atomic<int64_t>[]> parent_;
+};
+
+#endif // UNION_FIND_H
@@ -0,0 +1,186 @@
+// Well-connectedness check and minimum-cut splitting of clusters.
+
+#include "wcc.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+
+#include "parallel.h"
+#include "thread_pool.h"
+
+namespace {
+
+// A cluster still to be checked: either a slice of the cluster-sorted index
+// or, after a split, vertex and edge lists of its own.
+struct WccTask {
+    const int64_t* verts = nullptr;
+    size_t nv = 0;
+    const int64_t* edges = nullptr;
+    size_t ne = 0;
+    std::vector<int64_t> own_verts, own_edges;
+
+    void adopt() {
+        verts = own_verts.data(); nv = own_verts.size();
+        edges = own_edges.data(); ne = own_edges.size();
+    }
+};
+
+bool well_connected(double cut, size_t n) {
+    return cut > std::log10((double) n);
+}
+
+} // namespace
+
+WccStats split_poorly_connected(const igraph_t* g, const std::vector<double>& edge_weights,
+                                igraph_vector_int_t* membership, igraph_integer_t* nb_clusters,
+                                unsigned threads, RunReport* report) {
+    threads = resolve_threads(threads);
+    const int64_t n = igraph_vcount(g), m = igraph_ecount(g);
+    const igraph_integer_t* memb = VECTOR(*membership);
+    WccStats st;
+
+    RunReport::Phase wcc_phase(report, "wcc");
+    wcc_phase.add_edges((uint64_t) m);
+
+    // Cluster-sorted index: vertices and internal (non-loop) edges grouped
+    // by cluster, in original order within each cluster.
+    int64_t k = 0;
+    for (int64_t v = 0; v < n; ++v) k = std::max<int64_t>(k, memb[v] + 1);
+    std::vector<int64_t> vstart((size_t) k + 1, 0), estart((size_t) k + 1, 0);
+    for (int64_t v = 0; v < n; ++v) ++vstart[(size_t) memb[v] + 1];
+    auto internal = [&](int64_t e) {
+        const igraph_integer_t u = IGRAPH_FROM(g, e), v = IGRAPH_TO(g, e);
+        return u != v && memb[u] == memb[v];
+    };
+    for (int64_t e = 0; e < m; ++e)
+        if (internal(e)) ++estart[(size_t) memb[IGRAPH_FROM(g, e)] + 1];
+    std::partial_sum(vstart.begin(), vstart.end(), vstart.begin());
+    std::partial_sum(estart.begin(), estart.end(), estart.begin());
+    std::vector<int64_t> verts((size_t) n), edges((size_t) estart[(size_t) k]);
+    {
+        std::vector<int64_t> cursor(vstart.begin(), vstart.end() - 1);
+        for (int64_t v = 0; v < n; ++v) verts[(size_t) cursor[(size_t) memb[v]]++] = v;
+        cursor.assign(estart.begin(), estart.end() - 1);
+        for (int64_t e = 0; e < m; ++e)
+            if (internal(e)) edges[(size_t) cursor[(size_t) memb[IGRAPH_FROM(g, e)]]++] = e;
+    }
+
+    // local[v]: v's index within the task that currently holds it. Tasks
+    // hold disjoint vertex sets, so workers never write the same entry.
+    std::vector<int64_t> local((size_t) n);
+    std::vector<int64_t> final_of((size_t) n);    // final cluster of each vertex, by its first vertex
+    std::atomic<int64_t> checked{0}, splits{0};
+
+    std::vector<int64_t> order;
+    for (int64_t c = 0; c < k; ++c) if (vstart[(size_t) c + 1] > vstart[(size_t) c]) order.push_back(c);
+    st.clusters_in = (int64_t) order.size();
+    std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+        return vstart[(size_t) a + 1] - vstart[(size_t) a] > vstart[(size_t) b + 1] - vstart[(size_t) b];
+    });
+
+    // Sized by threads, not order.size(): splits queue new tasks, so even a
+    // single oversized cluster fans out across the pool as it is cut.
+    ThreadPool pool(threads);
+    std::function<void(std::shared_ptr<WccTask>)> check;
+    check = [&](std::shared_ptr<WccTask> task) {
+        const size_t nv = task->nv;
+        if (nv == 0) return;
+        auto accept = [&] {
+            const int64_t id = *std::min_element(task->verts, task->verts + nv);
+            for (size_t i = 0; i < nv; ++i) final_of[(size_t) task->verts[i]] = id;
+        };
+        if (nv < 2) { accept(); return; }
+
+        for (size_t i = 0; i < nv; ++i) local[(size_t) task->verts[i]] = (int64_t) i;
+        std::vector<igraph_integer_t> es(2 * task->ne);
+        std::vector<double> cap(edge_weights.empty() ? 0 : task->ne);
+        for (size_t i = 0; i < task->ne; ++i) {
+            const int64_t e = task->edges[i];
+            es[2 * i] = local[(size_t) IGRAPH_FROM(g, e)];
+            es[2 * i + 1] = local[(size_t) IGRAPH_TO(g, e)];
+            if (!cap.empty()) cap[i] = edge_weights[(size_t) e];
+        }
+        igraph_t sg;
+        igraph_vector_int_t ev;
+        igraph_vector_int_view(&ev, es.data(), (igraph_integer_t) es.size());
+        if (igraph_create(&sg, &ev, (igraph_integer_t) nv, IGRAPH_UNDIRECTED))
+            throw std::runtime_error("igraph_create failed");
+        igraph_vector_t capv;
+        const igraph_vector_t* capacity =
+            cap.empty() ? nullptr : igraph_vector_view(&capv, cap.data(), (igraph_integer_t) cap.size());
+        igraph_real_t value = 0.0;
+        igraph_vector_int_t side1, side2;
+        igraph_vector_int_init(&side1, 0);
+        igraph_vector_int_init(&side2, 0);
+        const igraph_error_t err = igraph_mincut(&sg, &value, &side1, &side2, /*cut=*/nullptr, capacity);
+        igraph_destroy(&sg);
+        checked.fetch_add(1, std::memory_order_relaxed);
+        if (err) {
+            igraph_vector_int_destroy(&side1);
+            igraph_vector_int_destroy(&side2);
+            throw std::runtime_error("igraph_mincut failed");
+        }
+        if (well_connected(value, nv)) {
+            igraph_vector_int_destroy(&side1);
+            igraph_vector_int_destroy(&side2);
+            accept();
+            return;
+        }
+
+        // Split along the cut; edges crossing it are dropped.
+        std::vector<char> in_first(nv, 0);
+        const size_t first = (size_t) igraph_vector_int_size(&side1);
+        for (size_t i = 0; i < first; ++i) in_first[(size_t) VECTOR(side1)[i]] = 1;
+        igraph_vector_int_destroy(&side1);
+        igraph_vector_int_destroy(&side2);
+        if (first == 0 || first == nv) { accept(); return; }
+        splits.fetch_add(1, std::memory_order_relaxed);
+        auto parts = std::make_shared<WccTask>(), rest = std::make_shared<WccTask>();
+        for (size_t i = 0; i < nv; ++i) (in_first[i] ? parts : rest)->own_verts.push_back(task->verts[i]);
+        for (size_t i = 0; i < task->ne; ++i) {
+            const int64_t e = task->edges[i];
+            const bool a = in_first[(size_t) local[(size_t) IGRAPH_FROM(g, e)]] != 0;
+            const bool b = in_first[(size_t) local[(size_t) IGRAPH_TO(g, e)]] != 0;
+            if (a == b) (a ? parts : rest)->own_edges.push_back(e);
+        }
+        task.reset();
+        for (auto& t : {parts, rest}) {
+            t->adopt();
+            pool.submit([&check, t](unsigned) { check(t); });
+        }
+    };
+
+    for (int64_t c : order) {
+        auto t = std::make_shared<WccTask>();
+        t->verts = verts.data() + vstart[(size_t) c];
+        t->nv = (size_t) (vstart[(size_t) c + 1] - vstart[(size_t) c]);
+        t->edges = edges.data() + estart[(size_t) c];
+        t->ne = (size_t) (estart[(size_t) c + 1] - estart[(size_t) c]);
+        pool.submit([&check, t](unsigned) { check(t); });
+    }
+    pool.wait();
+
+    // Number final clusters by their smallest vertex, which is the first
+    // vertex that refers to itself.
+    std::vector<int64_t> id((size_t) n, -1);
+    int64_t next = 0;
+    for (int64_t v = 0; v < n; ++v) {
+        int64_t& c = id[(size_t) final_of[(size_t) v]];
+        if (c < 0) c = next++;
+        VECTOR(*membership)[v] = c;
+    }
+    *nb_clusters = next;
+    st.checked = checked.load();
+    st.splits = splits.load();
+    st.clusters_out = next;
+    wcc_phase.finish();
+    std::cerr << "WCC: " << st.clusters_in << " clusters, " << st.checked << " min cuts, " << st.splits
+              << " splits -> " << st.clusters_out << " clusters\n";
+    return st;
+}
@@ -0,0 +1,34 @@
+#ifndef WCC_H
+#define WCC_H
+
+// Well-connected-cluster post-processing for leiden_igraph --wcc: every
+// cluster's induced subgraph must have a minimum cut above log10(size);
+// clusters that fail are split along their minimum cut, and the parts are
+// checked again until every cluster passes or is a singleton.
+
+#include <cstdint>
+#include <vector>
+
+#include <igraph/igraph.h>
+
+#include "run_report.h"
+
+struct WccStats {
+    int64_t clusters_in = 0;
+    int64_t checked = 0;       // mincut computations, including on split parts
+    int64_t splits = 0;        // clusters split along a minimum cut
+    int64_t clusters_out = 0;
+};
+
+// Rewrites *membership (labels in 0..n-1) so that every cluster is
+// well-connected, and reindexes it to 0..nb_clusters-1 ordered by each
+// cluster's smallest vertex. Clusters are read from a cluster-sorted index
+// of the internal edges (one id per edge, no graph copy); each check
+// builds only that cluster's subgraph. Clusters run largest first on
+// `threads` workers (igraph must be built with thread-local storage).
+// edge_weights (one per edge, empty = unit) are used as cut capacities.
+WccStats split_poorly_connected(const igraph_t* g, const std::vector<double>& edge_weights,
+                                igraph_vector_int_t* membership, igraph_integer_t* nb_clusters,
+                                unsigned threads = 0, RunReport* report = nullptr);
+
+#endif // WCC_H
@@ -0,0 +1,850 @@
+// leiden_checks: assertions on the graph pipeline, run by ctest one case at a
+// time (leiden_checks <case>) or all together without an argument.
+//
+//   remap_merge   id compaction round-trips through inv_map for every
+//                 strategy, and duplicate merging keeps each pair's summed weight
+//   reduce        expand_membership(reduce_graph(...)) scores the same on the
+//                 original graph as the reduced partition on the reduced graph
+//   checkpoint    write / read round-trip, a resumed run ends where an
+//                 uninterrupted one does, and another run's key is rejected
+//   components    clustering by component matches a whole-graph CPM run
+//   reorder       every vertex order is a permutation and keeps the edges
+//   cluster_stats the stats header carries both global scores and their
+//                 resolutions, equal to the optimiser's quality function
+//   native        the native engine's reported quality equals partition_quality
+//                 and native_quality of its membership, for both objectives
+//   batch         c_runLeidenBatch clusters each graph into its own slice, the
+//                 same at any thread count, counts a bad graph as failed, and
+//                 rejects missing edge arrays and offsets not starting at 0
+//   compressed    a .gz (and .zst when Arrow has it) edge list larger than one
+//                 decompression block parses the same as the plain file
+//   shards        a directory or glob of shards, one compressed, expands to
+//                 its edge files and reads as their concatenation
+//   wcc           a barbell cluster is split at its bridge, a clique is kept,
+//                 and a heavy bridge (edge weights as capacities) is kept
+//
+// Graphs are small planted partitions (the bench's "planted" model) with
+// pendant trees and chains hung off them, from a fixed seed.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include <arrow/util/compression.h>
+#include <igraph/igraph.h>
+
+#include "checkpoint.h"
+#include "cluster_stats.h"
+#include "components.h"
+#include "edge_io.h"
+#include "edge_merge.h"
+#include "graph_reduction.h"
+#include "id_remap.h"
+#include "igraph_backend.h"
+#include "native_leiden.h"
+#include "reorder.h"
+#include "run_leiden.h"
+#include "wcc.h"
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                      \
+    do {                                                                                 \
+        if (!(cond)) {                                                                   \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": CHECK(" #cond ") failed\n";  \
+            ++failures;                                                                  \
+        }                                                                                \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                                              \
+    do {                                                                                                   \
+        const double a_ = (a), b_ = (b);                                                                   \
+        if (!(std::fabs(a_ - b_) <= (tol))) {                                                              \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": " #a " = " << a_ << ", " #b " = " << b_ << '\n'; \
+            ++failures;                                                                                    \
+        }                                                                                                  \
+    } while (0)
+
+// ---------- Graphs ----------
+
+// Edge list with endpoints in 0..n-1.
+struct TestGraph {
+    int64_t n = 0;
+    std::vector<int64_t> src, dst;
+    std::vector<double> weights;   // one per edge
+};
+
+// Planted partition: `blocks` equal blocks, about `degree` edges per vertex,
+// a fraction `mu` of them leaving the block. With `trees`, a pendant path of
+// one to three vertices hangs off every fifth vertex.
+static TestGraph planted(int64_t n, int64_t blocks, double degree, double mu, bool trees, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    TestGraph g;
+    g.n = n;
+    const int64_t block = std::max<int64_t>(1, n / blocks);
+    const int64_t m = (int64_t) (degree * (double) n / 2);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (int64_t e = 0; e < m; ++e) {
+        const int64_t u = (int64_t) (rng() % (uint64_t) n);
+        int64_t v = unit(rng) < mu ? (int64_t) (rng() % (uint64_t) n)
+                                   : std::min(n - 1, (u / block) * block + (int64_t) (rng() % (uint64_t) block));
+        if (v == u) v = (u + 1) % n;
+        g.src.push_back(u);
+        g.dst.push_back(v);
+        g.weights.push_back(1.0 + (double) (rng() % 3));
+    }
+    if (trees) {
+        for (int64_t v = 0; v < n; v += 5) {
+            int64_t prev = v;
+            for (int64_t k = (int64_t) (rng() % 3); k >= 0; --k) {
+                g.src.push_back(prev);
+                g.dst.push_back(g.n);
+                g.weights.push_back(1.0);
+                prev = g.n++;
+            }
+        }
+    }
+    return g;
+}
+
+static void build(const TestGraph& tg, igraph_t* g) {
+    std::vector<igraph_integer_t> es(tg.src.size() * 2);
+    for (size_t e = 0; e < tg.src.size(); ++e) {
+        es[2 * e] = tg.src[e];
+        es[2 * e + 1] = tg.dst[e];
+    }
+    igraph_vector_int_t view;
+    igraph_vector_int_view(&view, es.data(), (igraph_integer_t) es.size());
+    if (igraph_create(g, &view, tg.n, IGRAPH_UNDIRECTED)) throw std::runtime_error("igraph_create failed");
+}
+
+// Destroys a built igraph graph when the scope ends.
+struct IgraphGuard {
+    igraph_t* g;
+    ~IgraphGuard() { igraph_destroy(g); }
+};
+
+struct Membership {
+    igraph_vector_int_t v;
+    Membership() {
+        if (igraph_vector_int_init(&v, 0)) throw std::runtime_error("igraph_vector_int_init failed");
+    }
+    ~Membership() { igraph_vector_int_destroy(&v); }
+    Membership(const Membership&) = delete;
+    Membership& operator=(const Membership&) = delete;
+
+    std::vector<igraph_integer_t> values() const { return {VECTOR(v), VECTOR(v) + igraph_vector_int_size(&v)}; }
+};
+
+// True when a and b put the same vertices together, whatever the labels.
+static bool same_partition(const std::vector<igraph_integer_t>& a, const std::vector<igraph_integer_t>& b) {
+    if (a.size() != b.size()) return false;
+    std::map<igraph_integer_t, igraph_integer_t> ab, ba;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (ab.emplace(a[i], b[i]).first->second != b[i]) return false;
+        if (ba.emplace(b[i], a[i]).first->second != a[i]) return false;
+    }
+    return true;
+}
+
+// ---------- Cases ----------
+
+static void check_remap_merge() {
+    std::mt19937_64 rng(11);
+    // Sparse ids far from 0 (over a range Dense can still table), pairs
+    // repeated and in both orientations.
+    std::vector<long long> ids(500);
+    for (auto& id : ids) id = 1000000007LL + (long long) (rng() % 2000000);
+    EdgeList edges;
+    std::vector<double> w;
+    std::map<std::pair<long long, long long>, double> expected;   // undirected pair -> summed weight
+    for (int e = 0; e < 4000; ++e) {
+        long long u = ids[rng() % ids.size()], v = ids[rng() % ids.size()];
+        if (u == v) continue;
+        const double x = 1.0 + (double) (rng() % 4);
+        edges.push_back({u, v});
+        w.push_back(x);
+        expected[{std::min(u, v), std::max(u, v)}] += x;
+    }
+    const size_t m = edges.size();
+
+    std::vector<int64_t> reference;
+    for (RemapStrategy s : {RemapStrategy::Auto, RemapStrategy::Dense, RemapStrategy::Sort, RemapStrategy::Hash}) {
+        std::vector<int64_t> out(2 * m);
+        std::vector<long long> inv;
+        const int64_t n = remap_edge_ids(edges, out.data(), &inv, s, 4);
+        CHECK((size_t) n == inv.size());
+        bool round_trip = true, dense = true;
+        for (size_t i = 0; i < m; ++i) {
+            round_trip &= inv[(size_t) out[2 * i]] == edges[i].u && inv[(size_t) out[2 * i + 1]] == edges[i].v;
+            dense &= out[2 * i] >= 0 && out[2 * i] < n && out[2 * i + 1] >= 0 && out[2 * i + 1] < n;
+        }
+        CHECK(round_trip);
+        CHECK(dense);
+        CHECK(out[0] == 0);   // first-appearance numbering
+        if (reference.empty()) reference = out;
+        CHECK(out == reference);
+    }
+    EdgeList in_place = edges;
+    std::vector<long long> inv;
+    const int64_t n = remap_edge_ids_in_place(in_place, &inv, RemapStrategy::Auto, 4);
+    const int64_t* ip = edge_id_array(in_place);
+    CHECK(std::equal(reference.begin(), reference.end(), ip));
+
+    // Undirected merge: one edge per pair, weights summed, ids still valid.
+    std::vector<int64_t> es = reference;
+    std::vector<double> mw = w;
+    const size_t merged = merge_duplicate_edges(es.data(), m, n, /*directed=*/false, DuplicatePolicy::Sum,
+                                                SelfLoopPolicy::Keep, mw, 4);
+    CHECK(merged == expected.size());
+    CHECK(mw.size() == merged);
+    std::map<std::pair<long long, long long>, double> got;
+    for (size_t e = 0; e < merged; ++e) {
+        const long long u = inv[(size_t) es[2 * e]], v = inv[(size_t) es[2 * e + 1]];
+        got[{std::min(u, v), std::max(u, v)}] += mw[e];
+    }
+    CHECK(got == expected);
+
+    // Directed merge keeps (u,v) and (v,u) apart; Max keeps the largest weight.
+    es = reference;
+    mw = w;
+    std::map<std::pair<int64_t, int64_t>, double> directed_max;
+    for (size_t e = 0; e < m; ++e) {
+        double& x = directed_max[{reference[2 * e], reference[2 * e + 1]}];
+        x = std::max(x, w[e]);
+    }
+    const size_t merged_directed = merge_duplicate_edges(es.data(), m, n, /*directed=*/true, DuplicatePolicy::Max,
+                                                         SelfLoopPolicy::Keep, mw, 4);
+    CHECK(merged_directed == directed_max.size());
+    bool max_ok = mw.size() == merged_directed;
+    for (size_t e = 0; max_ok && e < merged_directed; ++e) max_ok = directed_max[{es[2 * e], es[2 * e + 1]}] == mw[e];
+    CHECK(max_ok);
+}
+
+static void check_reduce() {
+    for (int trial = 0; trial < 8; ++trial) {
+        const bool modularity = trial % 2 == 1;
+        const double resolution = modularity ? 1.0 : 0.05;
+        const TestGraph tg = planted(300, 10, 6.0, 0.1, /*trees=*/true, 100 + (uint64_t) trial);
+        igraph_t g;
+        build(tg, &g);
+        IgraphGuard guard{&g};
+        const LeidenObjective obj = make_objective(&g, modularity, tg.weights);
+        const size_t m = tg.src.size();
+
+        // Keep every group in the reduced graph so its quality is comparable as is.
+        ReductionOptions opt;
+        opt.mode = trial < 4 ? Reduction::Pendants : Reduction::Chains;
+        opt.drop_isolated = false;
+        opt.drop_folded = false;
+        const double gamma = modularity ? resolution / obj.two_m : resolution;
+        GraphReduction r = reduce_graph(tg.src.data(), tg.dst.data(), m, tg.n, tg.weights.data(),
+                                        modularity ? obj.node_weights.data() : nullptr, gamma, opt);
+        CHECK(r.n < tg.n);
+        CHECK(r.stats.pendants > 0);
+        CHECK((int64_t) r.group.size() == tg.n);
+
+        TestGraph rg;
+        rg.n = r.n;
+        for (size_t e = 0; e < r.weights.size(); ++e) {
+            rg.src.push_back(r.edges[2 * e]);
+            rg.dst.push_back(r.edges[2 * e + 1]);
+        }
+        igraph_t reduced;
+        build(rg, &reduced);
+        IgraphGuard reduced_guard{&reduced};
+        LeidenObjective robj;
+        robj.modularity = modularity;
+        robj.edge_weights = r.weights;
+        robj.node_weights = r.node_weights;
+        robj.two_m = obj.two_m;
+
+        // Any partition of the reduced graph, expanded, scores the same on the original.
+        std::mt19937_64 rng(7 + (uint64_t) trial);
+        for (int p = 0; p < 4; ++p) {
+            const int64_t k = 1 + (int64_t) (rng() % (uint64_t) r.n);
+            std::vector<igraph_integer_t> rm((size_t) r.n);
+            for (auto& c : rm) c = (igraph_integer_t) (rng() % (uint64_t) k);
+            igraph_vector_int_t rview;
+            igraph_vector_int_view(&rview, rm.data(), (igraph_integer_t) rm.size());
+            igraph_integer_t nb = 0;
+            if (igraph_reindex_membership(&rview, nullptr, &nb)) throw std::runtime_error("reindex failed");
+
+            std::vector<int64_t> reduced_memb(rm.begin(), rm.end());
+            std::vector<int64_t> expanded((size_t) tg.n);
+            const int64_t clusters = expand_membership(r, reduced_memb.data(), nb, expanded.data(), 2);
+            CHECK(clusters == nb);
+            CHECK(*std::max_element(expanded.begin(), expanded.end()) == clusters - 1);
+
+            std::vector<igraph_integer_t> em(expanded.begin(), expanded.end());
+            igraph_vector_int_t eview;
+            igraph_vector_int_view(&eview, em.data(), (igraph_integer_t) em.size());
+            CHECK_NEAR(partition_quality(&g, obj, resolution, &eview, 2),
+                       partition_quality(&reduced, robj, resolution, &rview, 2), 1e-9);
+        }
+
+        // The end-to-end path scores its result on the original graph.
+        Membership memb;
+        igraph_integer_t nb = 0;
+        igraph_real_t q = 0.0;
+        opt.drop_isolated = opt.drop_folded = true;
+        opt.threads = 2;
+        const ReductionStats st = run_leiden_reduced(&g, obj, resolution, opt, &memb.v, &nb, &q);
+        CHECK(st.reduced_vertices < st.vertices);
+        CHECK(igraph_vector_int_size(&memb.v) == tg.n);
+        CHECK_NEAR(q, partition_quality(&g, obj, resolution, &memb.v, 2), 1e-9);
+    }
+}
+
+static void check_checkpoint() {
+    const TestGraph tg = planted(400, 8, 8.0, 0.15, /*trees=*/false, 5);
+    igraph_t g;
+    build(tg, &g);
+    IgraphGuard guard{&g};
+    const LeidenObjective obj = make_objective(&g, /*modularity=*/true, tg.weights);
+    const double resolution = 1.0, beta = 0.01;
+    const uint64_t seed = 1234;
+    ConvergenceOptions conv;
+    conv.max_iterations = 6;
+
+    const fs::path dir = fs::temp_directory_path() / ("leiden_checks." + std::to_string(::getpid()));
+    fs::create_directories(dir);
+    const uint64_t key = checkpoint_run_key(&g, obj.modularity, resolution, beta, seed, 2);
+    CHECK(key == checkpoint_run_key(&g, obj.modularity, resolution, beta, seed, 1));
+    CHECK(key != checkpoint_run_key(&g, obj.modularity, resolution, beta, seed + 1, 2));
+    CHECK(key != checkpoint_run_key(&g, obj.modularity, resolution * 2, beta, seed, 2));
+    const fs::path path = checkpoint_path(dir, key);
+
+    // Uninterrupted seeded run.
+    LeidenRunControl control;
+    control.seeded = true;
+    control.seed = seed;
+    Membership full;
+    igraph_integer_t nb_full = 0;
+    igraph_real_t q_full = 0.0;
+    std::vector<IterationRecord> history_full;
+    run_igraph_leiden_converging(&g, obj, resolution, beta, false, conv, &full.v, &nb_full, &q_full, &history_full,
+                                 &control);
+
+    // Same run, killed at the first checkpoint: iteration 1 always moves
+    // vertices, so another iteration follows it and the checkpoint is written.
+    struct Interrupted {};
+    LeidenRunControl first = control;
+    first.checkpoint = [&](const igraph_vector_int_t* memb, const std::vector<IterationRecord>& done) {
+        LeidenCheckpoint cp;
+        cp.run_key = key;
+        cp.seed = seed;
+        cp.history = done;
+        cp.membership.assign(VECTOR(*memb), VECTOR(*memb) + igraph_vector_int_size(memb));
+        write_checkpoint(path, cp);
+        throw Interrupted{};
+    };
+    Membership partial;
+    igraph_integer_t nb = 0;
+    igraph_real_t q = 0.0;
+    bool interrupted = false;
+    try {
+        run_igraph_leiden_converging(&g, obj, resolution, beta, false, conv, &partial.v, &nb, &q, nullptr, &first);
+    } catch (const Interrupted&) {
+        interrupted = true;
+    }
+    CHECK(interrupted);
+
+    LeidenCheckpoint cp;
+    CHECK(read_checkpoint(path, key, &cp));
+    CHECK(cp.run_key == key);
+    CHECK(cp.seed == seed);
+    CHECK(cp.history.size() == 1);
+    CHECK((int64_t) cp.membership.size() == tg.n);
+    bool history_ok = cp.history.size() == 1;
+    for (size_t i = 0; history_ok && i < cp.history.size(); ++i)
+        history_ok = cp.history[i].iteration == history_full[i].iteration &&
+                     cp.history[i].quality == history_full[i].quality && cp.history[i].moved == history_full[i].moved;
+    CHECK(history_ok);
+
+    // Resumed from the checkpoint, the run ends where the uninterrupted one did.
+    LeidenRunControl second = control;
+    second.resume = cp.history;
+    Membership resumed;
+    if (igraph_vector_int_resize(&resumed.v, (igraph_integer_t) cp.membership.size()))
+        throw std::runtime_error("igraph_vector_int_resize failed");
+    std::copy(cp.membership.begin(), cp.membership.end(), VECTOR(resumed.v));
+    std::vector<IterationRecord> history_resumed;
+    run_igraph_leiden_converging(&g, obj, resolution, beta, true, conv, &resumed.v, &nb, &q, &history_resumed,
+                                 &second);
+    CHECK(resumed.values() == full.values());
+    CHECK(nb == nb_full);
+    CHECK(q == q_full);
+    CHECK(history_resumed.size() == history_full.size());
+
+    // Another run's key, a missing file and a truncated file.
+    bool rejected = false;
+    try {
+        read_checkpoint(path, key ^ 1, &cp);
+    } catch (const std::exception&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+    CHECK(!read_checkpoint(dir / "missing.ckpt", key, &cp));
+    fs::resize_file(path, fs::file_size(path) - 3);
+    rejected = false;
+    try {
+        read_checkpoint(path, key, &cp);
+    } catch (const std::exception&) {
+        rejected = true;
+    }
+    CHECK(rejected);
+    fs::remove_all(dir);
+}
+
+static void check_components() {
+    // Disjoint cliques, from pairs (solved exactly) to sizes Leiden has to
+    // cluster, plus isolated vertices; CPM keeps each clique whole.
+    TestGraph tg;
+    for (int64_t size : {1, 2, 3, 3, 5, 8, 12, 1, 20, 7, 2}) {
+        const int64_t base = tg.n;
+        for (int64_t u = 0; u < size; ++u)
+            for (int64_t v = u + 1; v < size; ++v) {
+                tg.src.push_back(base + u);
+                tg.dst.push_back(base + v);
+                tg.weights.push_back(1.0);
+            }
+        tg.n += size;
+    }
+    igraph_t g;
+    build(tg, &g);
+    IgraphGuard guard{&g};
+    const LeidenObjective obj = make_objective(&g, /*modularity=*/false);
+    const double resolution = 0.1;
+
+    std::vector<int64_t> comp;
+    CHECK(connected_components(&g, comp, 2) == 11);
+
+    igraph_rng_seed(igraph_rng_default(), 42);
+    ConvergenceOptions conv;
+    conv.max_iterations = -1;
+    Membership whole;
+    igraph_integer_t nb_whole = 0;
+    igraph_real_t q_whole = 0.0;
+    run_igraph_leiden_converging(&g, obj, resolution, 0.01, false, conv, &whole.v, &nb_whole, &q_whole);
+
+    ComponentOptions opt;
+    opt.convergence = conv;
+    opt.threads = 1;   // igraph may be built without thread-local storage
+    Membership split;
+    igraph_integer_t nb_split = 0;
+    igraph_real_t q_split = 0.0;
+    const ComponentStats st = run_leiden_by_components(&g, obj, resolution, opt, &split.v, &nb_split, &q_split);
+    CHECK(st.components == 11);
+    CHECK(st.trivial_components == 6);
+    CHECK(st.largest == 20);
+
+    CHECK(nb_split == nb_whole);
+    CHECK(nb_split == 11);
+    CHECK(same_partition(split.values(), whole.values()));
+    CHECK_NEAR(q_split, q_whole, 1e-9);
+    CHECK_NEAR(q_split, partition_quality(&g, obj, resolution, &split.v), 1e-9);
+}
+
+// "# key\tvalue" lines at the top of a --cluster-stats file.
+static std::map<std::string, double> stats_header(const fs::path& path) {
+    std::map<std::string, double> out;
+    std::ifstream f(path);
+    for (std::string line; std::getline(f, line) && line.rfind("# ", 0) == 0;) {
+        const size_t tab = line.find('\t');
+        if (tab != std::string::npos) out[line.substr(2, tab - 2)] = std::stod(line.substr(tab + 1));
+    }
+    return out;
+}
+
+static void check_cluster_stats() {
+    const TestGraph tg = planted(300, 6, 8.0, 0.2, /*trees=*/false, 21);
+    igraph_t g;
+    build(tg, &g);
+    IgraphGuard guard{&g};
+    // Blocks as the partition; both scores must be in the header whatever the run's objective.
+    std::vector<igraph_integer_t> blocks((size_t) tg.n);
+    for (int64_t v = 0; v < tg.n; ++v) blocks[(size_t) v] = (igraph_integer_t) (v / 50);
+    igraph_vector_int_t memb;
+    igraph_vector_int_view(&memb, blocks.data(), (igraph_integer_t) blocks.size());
+
+    const fs::path path = fs::temp_directory_path() / ("leiden_checks." + std::to_string(::getpid()) + ".stats");
+    for (bool modularity : {true, false}) {
+        const double resolution = modularity ? 0.8 : 0.05;
+        const ClusterStats cs = run_cluster_stats(&g, tg.weights, &memb, 6, modularity, resolution, 2);
+        write_cluster_stats(path, cs, 2);
+        const std::map<std::string, double> head = stats_header(path);
+        CHECK(head.count("modularity") == 1);
+        CHECK(head.count("cpm") == 1);
+        CHECK(head.count("modularity_resolution") == 1 && head.at("modularity_resolution") == (modularity ? 0.8 : 1.0));
+        CHECK(head.count("cpm_resolution") == 1 && head.at("cpm_resolution") == resolution);
+        CHECK(head.count("clusters") == 1 && head.at("clusters") == 6);
+
+        // Both match the optimiser's own quality function at those resolutions.
+        const LeidenObjective mod = make_objective(&g, true, tg.weights);
+        const LeidenObjective cpm = make_objective(&g, false, tg.weights);
+        CHECK_NEAR(cs.modularity, partition_quality(&g, mod, cs.modularity_resolution, &memb), 1e-12);
+        CHECK_NEAR(cs.cpm, partition_quality(&g, cpm, resolution, &memb), 1e-12);
+        if (head.count("modularity") && head.count("cpm")) {
+            CHECK_NEAR(head.at("modularity"), cs.modularity, 1e-15);
+            CHECK_NEAR(head.at("cpm"), cs.cpm, 1e-15);
+        }
+    }
+    fs::remove(path);
+}
+
+static void check_native() {
+    const TestGraph tg = planted(600, 8, 8.0, 0.15, /*trees=*/true, 33);
+    igraph_t g;
+    build(tg, &g);
+    IgraphGuard guard{&g};
+    std::vector<int64_t> src, dst;
+    edge_endpoints(&g, src, dst, 3);
+    CHECK(src == tg.src && dst == tg.dst);
+    const CsrGraph csr = build_csr(tg.n, (int64_t) src.size(), src.data(), dst.data(), tg.weights.data(), 2);
+
+    for (bool modularity : {true, false}) {
+        const LeidenObjective obj = make_objective(&g, modularity, tg.weights);
+        const double resolution = modularity ? 1.0 : 0.05;
+        for (unsigned threads : {1u, 4u}) {
+            NativeLeidenOptions opt;
+            opt.modularity = modularity;
+            opt.resolution = resolution;
+            opt.seed = 5;
+            opt.threads = threads;
+            const NativeLeidenResult res = native_leiden(csr, opt);
+            CHECK((int64_t) res.membership.size() == tg.n);
+            CHECK(res.clusters > 1);
+            bool in_range = true;
+            for (int64_t c : res.membership) in_range &= c >= 0 && c < res.clusters;
+            CHECK(in_range);
+
+            std::vector<igraph_integer_t> labels(res.membership.begin(), res.membership.end());
+            igraph_vector_int_t memb;
+            igraph_vector_int_view(&memb, labels.data(), (igraph_integer_t) labels.size());
+            CHECK_NEAR(res.quality, partition_quality(&g, obj, resolution, &memb), 1e-9);
+            CHECK_NEAR(res.quality, native_quality(csr, modularity, resolution, res.membership.data(), threads), 1e-9);
+        }
+    }
+}
+
+// Adds a clique on `size` new vertices; returns its first vertex.
+static int64_t add_clique(TestGraph& tg, int64_t size) {
+    const int64_t base = tg.n;
+    for (int64_t u = 0; u < size; ++u)
+        for (int64_t v = u + 1; v < size; ++v) {
+            tg.src.push_back(base + u);
+            tg.dst.push_back(base + v);
+            tg.weights.push_back(1.0);
+        }
+    tg.n += size;
+    return base;
+}
+
+static void check_batch() {
+    // Graph 0: two 4-cliques. Graph 1: three isolated vertices. Graph 2: a
+    // weighted 5-clique. Graph 3: an endpoint out of range, so it fails.
+    TestGraph all;
+    std::vector<int64_t> offsets{0}, nodes;
+    auto add_graph = [&](const TestGraph& tg) {
+        all.src.insert(all.src.end(), tg.src.begin(), tg.src.end());
+        all.dst.insert(all.dst.end(), tg.dst.begin(), tg.dst.end());
+        all.weights.insert(all.weights.end(), tg.weights.begin(), tg.weights.end());
+        offsets.push_back((int64_t) all.src.size());
+        nodes.push_back(tg.n);
+    };
+    TestGraph cliques;
+    add_clique(cliques, 4);
+    add_clique(cliques, 4);
+    add_graph(cliques);
+    TestGraph isolated;
+    isolated.n = 3;
+    add_graph(isolated);
+    TestGraph heavy;
+    add_clique(heavy, 5);
+    for (double& w : heavy.weights) w = 2.0;
+    add_graph(heavy);
+    TestGraph bad;
+    bad.n = 2;
+    bad.src = {0};
+    bad.dst = {2};
+    bad.weights = {1.0};
+    add_graph(bad);
+    const int64_t graphs = (int64_t) nodes.size();
+    const int64_t total = std::accumulate(nodes.begin(), nodes.end(), (int64_t) 0);
+
+    LeidenConvergence conv;
+    c_leidenConvergenceDefaults(&conv);
+    conv.seed = 7;
+    std::vector<int64_t> first;
+    for (int64_t threads : {1, 4}) {
+        std::vector<int64_t> comm((size_t) total, -2), counts((size_t) graphs, -2);
+        std::vector<double> quality((size_t) graphs, -1.0);
+        CHECK(c_runLeidenBatch(all.src.data(), all.dst.data(), all.weights.data(), offsets.data(), nodes.data(),
+                               graphs, CPM, 0.1, &conv, threads, comm.data(), counts.data(), quality.data()) == 1);
+        CHECK(counts == std::vector<int64_t>({2, 3, 1, -1}));
+        // Slices start at the running node count: 0, 8, 11, 16.
+        const std::vector<igraph_integer_t> g0(comm.begin(), comm.begin() + 8);
+        CHECK(same_partition(g0, {0, 0, 0, 0, 1, 1, 1, 1}));
+        CHECK(std::vector<int64_t>(comm.begin() + 8, comm.begin() + 11) == std::vector<int64_t>({0, 1, 2}));
+        CHECK(std::all_of(comm.begin() + 11, comm.begin() + 16, [](int64_t c) { return c == 0; }));
+        CHECK(quality[1] == 0.0);
+        CHECK(quality[0] > 0.0 && quality[2] > 0.0);
+        if (first.empty()) first = comm;
+        else CHECK(comm == first);
+    }
+
+    // Invalid arguments fail the whole call before anything is clustered.
+    std::vector<int64_t> comm((size_t) total), counts((size_t) graphs);
+    CHECK(c_runLeidenBatch(nullptr, all.dst.data(), nullptr, offsets.data(), nodes.data(), graphs, CPM, 0.1,
+                           &conv, 2, comm.data(), counts.data(), nullptr) == -1);
+    CHECK(c_runLeidenBatch(all.src.data(), nullptr, nullptr, offsets.data(), nodes.data(), graphs, CPM, 0.1,
+                           &conv, 2, comm.data(), counts.data(), nullptr) == -1);
+    std::vector<int64_t> shifted = offsets;
+    for (int64_t& o : shifted) ++o;
+    CHECK(c_runLeidenBatch(all.src.data(), all.dst.data(), nullptr, shifted.data(), nodes.data(), graphs, CPM,
+                           0.1, &conv, 2, comm.data(), counts.data(), nullptr) == -1);
+    // Without edges the arrays may be null.
+    const int64_t no_edges[] = {0, 0, 0};
+    const int64_t sizes[] = {2, 1};
+    CHECK(c_runLeidenBatch(nullptr, nullptr, nullptr, no_edges, sizes, 2, CPM, 0.1, &conv, 2, comm.data(),
+                           counts.data(), nullptr) == 0);
+    CHECK(counts[0] == 2 && counts[1] == 1);
+    CHECK(comm[0] == 0 && comm[1] == 1 && comm[2] == 0);
+}
+
+// ---------- Edge input ----------
+
+static void write_file(const fs::path& path, const std::string& text) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f.write(text.data(), (std::streamsize) text.size());
+    if (!f) throw std::runtime_error("Cannot write " + path.string());
+}
+
+// Writes text compressed with Arrow's codec, as one gzip member or zstd frame.
+static void write_compressed(const fs::path& path, const std::string& text, arrow::Compression::type type) {
+    auto codec = arrow::util::Codec::Create(type, 1);
+    if (!codec.ok()) throw std::runtime_error(codec.status().ToString());
+    const auto* in = reinterpret_cast<const uint8_t*>(text.data());
+    std::string out((size_t) (*codec)->MaxCompressedLen((int64_t) text.size(), in), '\0');
+    auto len = (*codec)->Compress((int64_t) text.size(), in, (int64_t) out.size(), reinterpret_cast<uint8_t*>(&out[0]));
+    if (!len.ok()) throw std::runtime_error(len.status().ToString());
+    out.resize((size_t) *len);
+    write_file(path, out);
+}
+
+static bool same_edges(const EdgeList& a, const EdgeList& b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](const Edge& x, const Edge& y) { return x.u == y.u && x.v == y.v; });
+}
+
+static bool same_weights(const WeightList& a, const WeightList& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+// A header, then `m` tab-separated weighted edges with ids of varying width;
+// the last line has no newline.
+static std::string edge_text(size_t m, uint64_t seed, EdgeList* edges, WeightList* weights) {
+    std::mt19937_64 rng(seed);
+    std::string text = "src\tdst\tweight\n";
+    for (size_t e = 0; e < m; ++e) {
+        const long long u = (long long) (rng() % 1000000000000ULL) >> (rng() % 40);
+        const long long v = (long long) (rng() % 1000000000000ULL) >> (rng() % 40);
+        const double w = 0.5 * (double) (1 + rng() % 8);
+        edges->push_back({u, v});
+        weights->push_back(w);
+        char line[64];
+        std::snprintf(line, sizeof line, "%lld\t%lld\t%g%s", u, v, w, e + 1 < m ? "\n" : "");
+        text += line;
+    }
+    return text;
+}
+
+static void check_compressed() {
+    const fs::path dir = fs::temp_directory_path() / ("leiden_checks." + std::to_string(::getpid()) + ".compressed");
+    fs::create_directories(dir);
+    // About 45 MB of text: more than one 32 MB decompression block, so a
+    // line is carried over from the first block into the second.
+    EdgeList expect;
+    WeightList expect_w;
+    const std::string text = edge_text(2500000, 17, &expect, &expect_w);
+    write_file(dir / "edges.tsv", text);
+    std::vector<fs::path> files{dir / "edges.tsv"};
+    write_compressed(dir / "edges.tsv.gz", text, arrow::Compression::GZIP);
+    files.push_back(dir / "edges.tsv.gz");
+    if (arrow::util::Codec::IsAvailable(arrow::Compression::ZSTD)) {
+        write_compressed(dir / "edges.tsv.zst", text, arrow::Compression::ZSTD);
+        files.push_back(dir / "edges.tsv.zst");
+    }
+    for (const fs::path& path : files) {
+        for (unsigned threads : {1u, 4u}) {
+            WeightList w;
+            const EdgeList edges = read_tsv_edges(path, threads, &w);
+            CHECK(same_edges(edges, expect));
+            CHECK(same_weights(w, expect_w));
+            CHECK(same_edges(read_tsv_edges(path, threads), expect));
+        }
+    }
+    fs::remove_all(dir);
+}
+
+static void check_shards() {
+    const fs::path dir = fs::temp_directory_path() / ("leiden_checks." + std::to_string(::getpid()) + ".shards");
+    fs::create_directories(dir);
+    // Three shards of different formats, each with its own header, plus
+    // files a Spark job leaves next to them.
+    EdgeList expect, part;
+    WeightList expect_w, part_w;
+    write_file(dir / "part-0.tsv", edge_text(3000, 1, &expect, &expect_w));
+    std::string csv = edge_text(5000, 2, &part, &part_w);
+    std::replace(csv.begin(), csv.end(), '\t', ',');
+    write_compressed(dir / "part-1.csv.gz", csv, arrow::Compression::GZIP);
+    expect.insert(expect.end(), part.begin(), part.end());
+    expect_w.insert(expect_w.end(), part_w.begin(), part_w.end());
+    write_file(dir / "part-2.txt", edge_text(1000, 3, &expect, &expect_w));
+    write_file(dir / "_SUCCESS", "");
+    write_file(dir / "notes.md", "not edges\n");
+
+    const std::vector<fs::path> parts{dir / "part-0.tsv", dir / "part-1.csv.gz", dir / "part-2.txt"};
+    CHECK(expand_input_shards(dir) == parts);
+    CHECK(expand_input_shards(dir / "part-*") == parts);
+    CHECK(expand_input_shards(parts[1]) == std::vector<fs::path>{parts[1]});
+    bool threw = false;
+    try {
+        expand_input_shards(dir / "missing-*");
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    CHECK(threw);
+
+    for (unsigned io_threads : {1u, 2u, 3u}) {
+        WeightList w;
+        const EdgeList edges = read_edge_shards(parts, 4, io_threads, &w);
+        CHECK(same_edges(edges, expect));
+        CHECK(same_weights(w, expect_w));
+    }
+    fs::remove_all(dir);
+}
+
+static void check_wcc() {
+    // Cluster 0: two 5-cliques joined by one edge (mincut 1, not above
+    // log10(10) = 1). Cluster 1: a 6-clique (mincut 5).
+    TestGraph tg;
+    const int64_t left = add_clique(tg, 5), right = add_clique(tg, 5), clique = add_clique(tg, 6);
+    tg.src.push_back(left);
+    tg.dst.push_back(right);
+    tg.weights.push_back(1.0);
+    igraph_t g;
+    build(tg, &g);
+    IgraphGuard guard{&g};
+
+    for (bool heavy_bridge : {false, true}) {
+        std::vector<double> weights = tg.weights;
+        weights.back() = heavy_bridge ? 5.0 : 1.0;
+        for (unsigned threads : {1u, 3u}) {
+            std::vector<igraph_integer_t> labels((size_t) tg.n, 0);
+            for (int64_t v = clique; v < tg.n; ++v) labels[(size_t) v] = 1;
+            Membership memb;
+            igraph_vector_int_resize(&memb.v, tg.n);
+            std::copy(labels.begin(), labels.end(), VECTOR(memb.v));
+            igraph_integer_t nb = 2;
+            const WccStats st = split_poorly_connected(&g, weights, &memb.v, &nb, threads);
+            CHECK(st.clusters_in == 2);
+
+            std::vector<igraph_integer_t> expect((size_t) tg.n, 0);
+            for (int64_t v = right; v < tg.n; ++v) expect[(size_t) v] = heavy_bridge ? 0 : 1;
+            for (int64_t v = clique; v < tg.n; ++v) expect[(size_t) v] = heavy_bridge ? 1 : 2;
+            // With a bridge of weight 5 the barbell's mincut is a single vertex (4).
+            CHECK(st.splits == (heavy_bridge ? 0 : 1));
+            CHECK(st.clusters_out == (heavy_bridge ? 2 : 3));
+            CHECK(nb == st.clusters_out);
+            CHECK(memb.values() == expect);
+        }
+    }
+}
+
+static void check_reorder() {
+    const TestGraph tg = planted(2000, 20, 8.0, 0.2, /*trees=*/true, 9);
+    const size_t m = tg.src.size();
+    std::vector<int64_t> es(2 * m);
+    for (size_t e = 0; e < m; ++e) {
+        es[2 * e] = tg.src[e];
+        es[2 * e + 1] = tg.dst[e];
+    }
+    for (VertexOrder order : {VertexOrder::None, VertexOrder::Degree, VertexOrder::Bfs, VertexOrder::Rcm,
+                              VertexOrder::Rabbit}) {
+        const std::vector<int64_t> perm = vertex_order(es.data(), m, tg.n, tg.weights.data(), order, 4);
+        CHECK((int64_t) perm.size() == tg.n);
+        std::vector<int64_t> sorted = perm;
+        std::sort(sorted.begin(), sorted.end());
+        bool permutation = true;
+        for (int64_t v = 0; v < tg.n; ++v) permutation &= sorted[(size_t) v] == v;
+        CHECK(permutation);
+        CHECK(perm == vertex_order(es.data(), m, tg.n, tg.weights.data(), order, 1));
+
+        // inv_map[new] is still the original id, from identity ids or remapped ones.
+        std::vector<int64_t> renumbered = es;
+        std::vector<long long> inv;
+        apply_vertex_order(renumbered.data(), m, perm, &inv, 3);
+        bool same_edges = (int64_t) inv.size() == tg.n;
+        for (size_t i = 0; same_edges && i < 2 * m; ++i) same_edges = inv[(size_t) renumbered[i]] == es[i];
+        CHECK(same_edges);
+
+        std::vector<long long> ids((size_t) tg.n);
+        for (int64_t v = 0; v < tg.n; ++v) ids[(size_t) v] = 1000 + 3 * v;
+        renumbered = es;
+        apply_vertex_order(renumbered.data(), m, perm, &ids, 2);
+        same_edges = true;
+        for (size_t i = 0; same_edges && i < 2 * m; ++i) same_edges = ids[(size_t) renumbered[i]] == 1000 + 3 * es[i];
+        CHECK(same_edges);
+    }
+}
+
+int main(int argc, char** argv) {
+    const std::vector<std::pair<const char*, std::function<void()>>> cases = {
+        {"remap_merge", check_remap_merge},
+        {"reduce", check_reduce},
+        {"checkpoint", check_checkpoint},
+        {"components", check_components},
+        {"reorder", check_reorder},
+        {"cluster_stats", check_cluster_stats},
+        {"native", check_native},
+        {"batch", check_batch},
+        {"compressed", check_compressed},
+        {"shards", check_shards},
+        {"wcc", check_wcc},
+    };
+    bool found = argc < 2;
+    for (const auto& c : cases) {
+        if (argc >= 2 && std::strcmp(argv[1], c.first) != 0) continue;
+        found = true;
+        const int before = failures;
+        try {
+            c.second();
+        } catch (const std::exception& e) {
+            std::cerr << c.first << ": " << e.what() << '\n';
+            ++failures;
+        }
+        std::cout << c.first << ": " << (failures == before ? "ok" : "FAILED") << std::endl;
+    }
+    if (!found) {
+        std::cerr << "Unknown case: " << argv[1] << '\n';
+        return 2;
+    }
+    return failures ? 1 : 0;
+}